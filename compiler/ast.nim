@@ -155,6 +155,7 @@ const
   sfExperimental* = sfOverridden       # module uses the .experimental switch
   sfWrittenTo* = sfBorrow             # param is assigned to
                                       # currently unimplemented
+  sfCacheMacro* = sfGoto              # macro is marked as .cacheMacro
   sfCppMember* = { sfVirtual, sfMember, sfConstructor } # proc is a C++ member, meaning it will be attached to the type definition
 
 const
@@ -325,6 +326,7 @@ type
     nfDisabledOpenSym # temporary: node should be nkOpenSym but cannot
                       # because openSym experimental switch is disabled
                       # gives warning instead
+    nfNoCheck # the index or overflow check of this node is proven redundant
 
   TNodeFlags* = set[TNodeFlag]
   TTypeFlag* = enum   # keep below 32 for efficiency reasons (now: 47)
@@ -399,6 +401,8 @@ type
     tfIsOutParam
     tfSendable
     tfImplicitStatic
+    tfReorderFields # object type was annotated as .reorderFields
+    tfKeepFieldOrder # object type is passed to or from C code
 
   TTypeFlags* = set[TTypeFlag]
 
@@ -0,0 +1,145 @@
+#
+#
+#           The Nim Compiler
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+# included from cgen.nim
+
+## Whole-program acyclic inference for ORC. `canFormAcycle` only sees one
+## type at a time, so a `ref` to an inheritable object can point to any
+## subtype and is always treated as part of a possible cycle. Once all
+## modules are generated the type infos tell which object types exist at
+## runtime: an object that is allocated has a type info. An object type
+## whose fields cannot reach an object of its own type, taking only these
+## subtypes into account, gets the acyclic flag in its type info, so ORC
+## never registers it as a potential cycle root.
+##
+## Closures are still assumed to capture anything.
+
+proc acyclicInferenceEnabled(m: BModule): bool =
+  ## The analysis needs to see every object type of the program.
+  m.config.selectedGC == gcOrc and not m.hcrOn and
+    m.config.symbolFiles == disabledSf and
+    optGenDynLib notin m.config.globalOptions and
+    not isDefined(m.config, "useNimRtl") and
+    not isDefined(m.config, "nimNoAcyclicInference")
+
+proc rememberObjectTypeInfo(m: BModule; t: PType; name: Rope; cyclic: bool) =
+  if t.kind == tyObject and acyclicInferenceEnabled(m):
+    m.g.objectTypeInfos.add (t: t, name: name,
+      module: m.module.position, cyclic: cyclic)
+
+type
+  CycleSearch = object
+    g: BModuleList
+    start: PType
+    marker: IntSet
+    path: seq[string] # the fields leading back to `start`
+
+proc inheritsFrom(y, t: PType): bool =
+  var b = y
+  while b != nil:
+    b = skipTypes(b, abstractInst+{tyOwned, tyRef, tyPtr})
+    if sameBackendType(b, t): return true
+    b = b.baseClass
+  result = false
+
+proc cycleTypeName(t: PType): string =
+  result = typeToString(t)
+  # the object type of `ref object`
+  if result.endsWith(":ObjectType"): result.setLen(result.len - len(":ObjectType"))
+
+proc reachesStart(c: var CycleSearch; typ: PType; hasTrace: bool): bool
+
+proc reachesStartNode(c: var CycleSearch; n: PNode; hasTrace: bool): bool =
+  result = false
+  if n.kind == nkSym:
+    # cursor fields don't own the refs, which cannot form reference cycles
+    if hasTrace or sfCursor notin n.sym.flags:
+      c.path.add "." & n.sym.name.s
+      result = reachesStart(c, n.sym.typ, hasTrace)
+      if not result: discard c.path.pop
+  elif n.kind notin {nkNone..nkNilLit}:
+    for i in 0..<n.len:
+      result = reachesStartNode(c, n[i], hasTrace)
+      if result: return
+
+proc reachesTarget(c: var CycleSearch; y: PType; hasTrace: bool): bool =
+  ## `y` is the runtime type of an object a ref points to.
+  c.path.add " -> " & cycleTypeName(y)
+  result = sameBackendType(y, c.start) or reachesStart(c, y, hasTrace)
+  if not result: discard c.path.pop
+
+proc reachesStart(c: var CycleSearch; typ: PType; hasTrace: bool): bool =
+  result = false
+  if typ == nil or tfAcyclic in typ.flags: return
+  let t = skipTypes(typ, abstractInst+{tyOwned}-{tyTypeDesc})
+  if tfAcyclic in t.flags: return
+  case t.kind
+  of tyRef, tyPtr, tyUncheckedArray:
+    if t.kind == tyRef or hasTrace:
+      let elem = skipTypes(t.elementType, abstractInst+{tyOwned}-{tyTypeDesc})
+      if elem.kind != tyObject:
+        if not containsOrIncl(c.marker, elem.id):
+          result = reachesStart(c, elem, hasTrace)
+      else:
+        result = reachesTarget(c, elem, hasTrace)
+        if not result and tfFinal notin elem.flags:
+          for x in c.g.objectTypeInfos:
+            if not sameBackendType(x.t, elem) and inheritsFrom(x.t, elem):
+              result = reachesTarget(c, x.t, hasTrace)
+              if result: return
+  of tyObject:
+    # an object that was visited before has the same fields as then
+    if containsOrIncl(c.marker, t.id): return
+    var hasTrace = hasTrace
+    let op = getAttachedOp(c.g.graph, t, attachedTrace)
+    if op != nil and sfOverridden in op.flags:
+      hasTrace = true
+    if t.baseClass != nil:
+      result = reachesStart(c, t.baseClass, hasTrace)
+      if result: return
+    if t.n != nil: result = reachesStartNode(c, t.n, hasTrace)
+  of tyTuple:
+    for i, a in t.ikids:
+      c.path.add "[" & $i & "]"
+      result = reachesStart(c, a, hasTrace)
+      if result: return
+      discard c.path.pop
+  of tySequence, tyArray, tyOpenArray, tyVarargs:
+    if not containsOrIncl(c.marker, t.id):
+      c.path.add "[]"
+      result = reachesStart(c, t.elementType, hasTrace)
+      if not result: discard c.path.pop
+  of tyProc:
+    if t.callConv == ccClosure:
+      c.path.add " (closure)"
+      result = true
+  else: discard
+
+proc inferAcyclicTypes(g: BModuleList) =
+  ## Sets the acyclic flag of the object type infos `canFormAcycle` could
+  ## not prove acyclic but the whole program can.
+  if g.objectTypeInfos.len == 0: return
+  var cyclic: seq[string] = @[]
+  var proven = 0
+  for x in g.objectTypeInfos:
+    if not x.cyclic: continue
+    var c = CycleSearch(g: g, start: x.t, marker: initIntSet(),
+      path: @[cycleTypeName(x.t)])
+    if reachesStart(c, x.t, false):
+      cyclic.add c.path.join("")
+    else:
+      g.modules[x.module].s[cfsTypeInit3].addFieldAssignment(x.name, "flags", 1)
+      inc proven
+  if g.config.hasHint(hintCyclicTypes):
+    cyclic.sort()
+    var msg = "acyclic inference: " & $proven & " object types proven acyclic, " &
+      $cyclic.len & " can be part of a cycle"
+    for path in cyclic:
+      msg.add "\n  " & path
+    rawMessage(g.config, hintCyclicTypes, msg)
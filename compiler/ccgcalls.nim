@@ -239,11 +239,13 @@ proc genOpenArraySlice(p: BProc; q: PNode; formalType, destType: PType; prepareF
       val = cDeref(ra)
     else:
       val = ra
-    result = (
-      cIfExpr(dataFieldAccessor(p, val),
-        cCast(ptrType(dest), cOp(Add, NimInt, dataField(p, val), rb)),
-        NimNil),
-      lengthExpr)
+    var data = cIfExpr(dataFieldAccessor(p, val),
+      cCast(ptrType(dest), cOp(Add, NimInt, dataField(p, val), rb)),
+      NimNil)
+    if atyp.skipTypes(abstractVar).kind == tyString and ssoStrings(p.config):
+      data = cIfExpr(ssoFlag(val),
+        cCast(ptrType(dest), cOp(Add, NimInt, ssoChars(val), rb)), data)
+    result = (data, lengthExpr)
   else:
     result = ("", "")
     internalError(p.config, "openArrayLoc: " & typeToString(a.t))
@@ -291,17 +293,18 @@ proc openArrayLoc(p: BProc, formalType: PType, n: PNode; result: var Builder) =
         let bra = byRefLoc(p, a)
         p.s(cpsStmts).addCallStmt(cgsymValue(p.module, "nimPrepareStrMutationV2"),
           bra)
+      let isString = ntyp.skipTypes(abstractVar).kind == tyString
       if ntyp.kind in {tyVar} and not compileToCpp(p.module):
         let ra = a.rdLoc
         var t = TLoc(snippet: cDeref(ra))
         let lt = lenExpr(p, t)
-        result.add(cIfExpr(dataFieldAccessor(p, t.snippet), dataField(p, t.snippet), NimNil))
+        result.add(dataOrNil(p, t.snippet, isString))
         result.addArgumentSeparator()
         result.add(lt)
       else:
         let ra = a.rdLoc
         let la = lenExpr(p, a)
-        result.add(cIfExpr(dataFieldAccessor(p, ra), dataField(p, ra), NimNil))
+        result.add(dataOrNil(p, ra, isString))
         result.addArgumentSeparator()
         result.add(la)
     of tyArray:
@@ -315,7 +318,7 @@ proc openArrayLoc(p: BProc, formalType: PType, n: PNode; result: var Builder) =
         let ra = a.rdLoc
         var t = TLoc(snippet: cDeref(ra))
         let lt = lenExpr(p, t)
-        result.add(cIfExpr(dataFieldAccessor(p, t.snippet), dataField(p, t.snippet), NimNil))
+        result.add(dataOrNil(p, t.snippet, elementType(a.t).kind == tyString))
         result.addArgumentSeparator()
         result.add(lt)
       of tyArray:
@@ -345,7 +348,12 @@ proc literalsNeedsTmp(p: BProc, a: TLoc): TLoc =
 proc genArgStringToCString(p: BProc, n: PNode; result: var Builder; needsTmp: bool) {.inline.} =
   var a = initLocExpr(p, n[0])
   let ra = withTmpIfNeeded(p, a, needsTmp).rdLoc
-  result.addCall(cgsymValue(p.module, "nimToCStringConv"), ra)
+  if ssoStrings(p.config):
+    # the chars of a short string are in `a`, not in a copy of it
+    result.add(cIfExpr(ssoFlag(ra), cCast(NimCstring, ssoChars(ra)),
+      cCall(cgsymValue(p.module, "nimToCStringConv"), ra)))
+  else:
+    result.addCall(cgsymValue(p.module, "nimToCStringConv"), ra)
 
 proc genArg(p: BProc, n: PNode, param: PSym; call: PNode; result: var Builder; needsTmp = false) =
   var a: TLoc
@@ -321,8 +321,7 @@ proc genOpenArrayConv(p: BProc; d: TLoc; a: TLoc; flags: TAssignmentFlags) =
 
     let rd = d.rdLoc
     let ra = a.rdLoc
-    p.s(cpsStmts).addFieldAssignment(rd, "Field0",
-      cIfExpr(dataFieldAccessor(p, ra), dataField(p, ra), NimNil))
+    p.s(cpsStmts).addFieldAssignment(rd, "Field0", dataOrNil(p, ra, true))
     let la = lenExpr(p, a)
     p.s(cpsStmts).addFieldAssignment(rd, "Field1", la)
   else:
@@ -660,7 +659,8 @@ proc binaryArithOverflow(p: BProc, e: PNode, d: var TLoc, m: TMagic) =
   # skipping 'range' is correct here as we'll generate a proper range check
   # later via 'chckRange'
   let t = e.typ.skipTypes(abstractRange)
-  if optOverflowCheck notin p.options or (m in {mSucc, mPred} and t.kind in {tyUInt..tyUInt64}):
+  if optOverflowCheck notin p.options or nfNoCheck in e.flags or
+      (m in {mSucc, mPred} and t.kind in {tyUInt..tyUInt64}):
     let typ = getTypeDesc(p.module, e.typ)
     let res = cCast(typ, cOp(opr[m], typ, rdLoc(a), rdLoc(b)))
     putIntoDest(p, d, e, res)
@@ -1152,7 +1152,8 @@ proc genArrayElem(p: BProc, n, x, y: PNode, d: var TLoc) =
   var ty = skipTypes(a.t, abstractVarRange + abstractPtrs + tyUserTypeClasses)
   let first = cIntLiteral(firstOrd(p.config, ty))
   # emit range check:
-  if optBoundsCheck in p.options and ty.kind != tyUncheckedArray:
+  if optBoundsCheck in p.options and ty.kind != tyUncheckedArray and
+      nfNoCheck notin n.flags:
     if not isConstExpr(y):
       # semantic pass has already checked for const index expressions
       if firstOrd(p.config, ty) == 0 and lastOrd(p.config, ty) >= 0:
@@ -1258,7 +1259,7 @@ proc genOpenArrayElem(p: BProc, n, x, y: PNode, d: var TLoc) =
     arrLen = dotField(ra, "Field1")
 
   # emit range check:
-  if optBoundsCheck in p.options:
+  if optBoundsCheck in p.options and nfNoCheck notin n.flags:
     p.s(cpsStmts).addSingleIfStmt(cOp(Or,
         cOp(LessThan, rcb, cIntValue(0)),
         cOp(GreaterEqual, rcb, arrLen))): # BUGFIX: ``>=`` and not ``>``!
@@ -1278,7 +1279,7 @@ proc genSeqElem(p: BProc, n, x, y: PNode, d: var TLoc) =
     ty = skipTypes(ty.elementType, abstractVarRange)
   let rcb = rdCharLoc(b)
   # emit range check:
-  if optBoundsCheck in p.options:
+  if optBoundsCheck in p.options and nfNoCheck notin n.flags:
     let arrLen = lenExpr(p, a)
     p.s(cpsStmts).addSingleIfStmt(cOp(Or,
         cOp(LessThan, rcb, cIntValue(0)),
@@ -1298,7 +1299,8 @@ proc genSeqElem(p: BProc, n, x, y: PNode, d: var TLoc) =
     p.s(cpsStmts).addCallStmt(cgsymValue(p.module, "nimPrepareStrMutationV2"),
       bra)
   let ra = rdLoc(a)
-  putIntoDest(p, d, n, subscript(dataField(p, ra), rcb), a.storage)
+  let data = if ty.kind == tyString: strDataField(p, ra) else: dataField(p, ra)
+  putIntoDest(p, d, n, subscript(data, rcb), a.storage)
 
 proc genBracketExpr(p: BProc; n: PNode; d: var TLoc) =
   var ty = skipTypes(n[0].typ, abstractVarRange + tyUserTypeClasses)
@@ -1406,15 +1408,10 @@ proc genEcho(p: BProc, n: PNode) =
             let ra = a.rdLoc
             let fnName = "Genode::Cstring"
             p.s(cpsStmts).addArgument(logCall):
-              case detectStrVersion(p.module)
-              of 2:
-                p.s(cpsStmts).addCall(fnName,
-                  dotField(derefField(ra, "p"), "data"),
-                  dotField(ra, "len"))
-              else:
-                p.s(cpsStmts).addCall(fnName,
-                  derefField(ra, "data"),
-                  derefField(ra, "len"))
+              let len = case detectStrVersion(p.module)
+                        of 2: dotField(ra, "len")
+                        else: derefField(ra, "len")
+              p.s(cpsStmts).addCall(fnName, dataOrNil(p, ra, true), len)
   else:
     if n.len == 0:
       p.s(cpsStmts).addCallStmt(cgsymValue(p.module, "echoBinSafe"),
@@ -1574,6 +1571,17 @@ proc genDefault(p: BProc; n: PNode; d: var TLoc) =
   if d.k == locNone: d = getTemp(p, n.typ, needsInit=true)
   else: resetLoc(p, d)
 
+proc biasedRefCounts(conf: ConfigRef): bool {.inline.} =
+  ## With `--mm:atomicArc` an object created by `new` belongs to its thread,
+  ## the runtime needs its type info to destroy it after merging counters.
+  conf.selectedGC == gcAtomicArc and optThreads in conf.globalOptions and
+    conf.target.targetOS != osStandalone and
+    not isDefined(conf, "nimNoBiasedRc")
+
+proc newObjNeedsType(conf: ConfigRef): bool {.inline.} =
+  ## The heap profiler records the type of the objects it samples.
+  biasedRefCounts(conf) or isDefined(conf, "nimHeapProfiler")
+
 proc rawGenNew(p: BProc, a: var TLoc, sizeExpr: Rope; needsInit: bool) =
   var sizeExpr = sizeExpr
   let typ = a.t
@@ -1584,7 +1592,16 @@ proc rawGenNew(p: BProc, a: var TLoc, sizeExpr: Rope; needsInit: bool) =
   if sizeExpr == "":
     sizeExpr = cSizeof(getTypeDesc(p.module, bt))
 
-  if optTinyRtti in p.config.globalOptions:
+  if optTinyRtti in p.config.globalOptions and newObjNeedsType(p.config):
+    let fnName = cgsymValue(p.module,
+      if needsInit: "nimNewObjTyped" else: "nimNewObjUninitTyped")
+    b.snippet = cCast(getTypeDesc(p.module, typ),
+      cCall(fnName,
+        sizeExpr,
+        cAlignof(getTypeDesc(p.module, bt)),
+        genTypeInfoV2(p.module, bt, a.lode.info)))
+    genAssignment(p, a, b, {})
+  elif optTinyRtti in p.config.globalOptions:
     let fnName = cgsymValue(p.module, if needsInit: "nimNewObj" else: "nimNewObjUninit")
     b.snippet = cCast(getTypeDesc(p.module, typ),
       cCall(fnName,
@@ -2062,9 +2079,9 @@ proc genRepr(p: BProc, e: PNode, d: var TLoc) =
     of tyString, tySequence:
       let ra = rdLoc(a)
       let la = lenExpr(p, a)
+      let isString = skipTypes(a.t, abstractVarRange).kind == tyString
       putIntoDest(p, b, e,
-        cIfExpr(dataFieldAccessor(p, ra), dataField(p, ra), NimNil) &
-          cArgumentSeparator & la,
+        dataOrNil(p, ra, isString) & cArgumentSeparator & la,
         a.storage)
     of tyArray:
       let ra = rdLoc(a)
@@ -2645,8 +2662,12 @@ proc genConv(p: BProc, e: PNode, d: var TLoc) =
 
 proc convStrToCStr(p: BProc, n: PNode, d: var TLoc) =
   var a: TLoc = initLocExpr(p, n[0])
-  putIntoDest(p, d, n,
-    cgCall(p, "nimToCStringConv", rdLoc(a)),
+  let ra = rdLoc(a)
+  var res = cgCall(p, "nimToCStringConv", ra)
+  if ssoStrings(p.config):
+    # the chars of a short string are in `a`, not in a copy of it
+    res = cIfExpr(ssoFlag(ra), cCast(NimCstring, ssoChars(ra)), res)
+  putIntoDest(p, d, n, res,
 #   "($1 ? $1->data : (NCSTRING)\"\")" % [a.rdLoc],
     a.storage)
 
@@ -2729,8 +2750,13 @@ proc genMove(p: BProc; n: PNode; d: var TLoc) =
         dotField(destVal, "p"),
         dotField(srcVal, "p"))):
       genStmts(p, n[3])
-    p.s(cpsStmts).addFieldAssignment(destVal, "len", dotField(srcVal, "len"))
-    p.s(cpsStmts).addFieldAssignment(destVal, "p", dotField(srcVal, "p"))
+    if ssoStrings(p.config) and
+        n[1].skipAddr.typ.skipTypes(abstractVar).kind == tyString:
+      # a short string has chars past its `p` field
+      p.s(cpsStmts).addAssignment(destVal, srcVal)
+    else:
+      p.s(cpsStmts).addFieldAssignment(destVal, "len", dotField(srcVal, "len"))
+      p.s(cpsStmts).addFieldAssignment(destVal, "p", dotField(srcVal, "p"))
   else:
     if d.k == locNone: d = getTemp(p, n.typ)
     if p.config.selectedGC in {gcArc, gcAtomicArc, gcOrc}:
@@ -2775,11 +2801,14 @@ proc genDestroy(p: BProc; n: PNode) =
       var a: TLoc = initLocExpr(p, arg)
       let ra = rdLoc(a)
       let rp = dotField(ra, "p")
-      p.s(cpsStmts).addSingleIfStmt(
-        cOp(And, rp,
-          cOp(Not, cOp(BitAnd, NimInt,
-            derefField(rp, "cap"),
-            NimStrlitFlag)))):
+      var cond = cOp(And, rp,
+        cOp(Not, cOp(BitAnd, NimInt,
+          derefField(rp, "cap"),
+          NimStrlitFlag)))
+      if ssoStrings(p.config):
+        # the `p` field of a short string holds its chars
+        cond = cOp(And, cOp(Not, ssoFlag(ra)), cond)
+      p.s(cpsStmts).addSingleIfStmt(cond):
         let fn = if optThreads in p.config.globalOptions: "deallocShared" else: "dealloc"
         p.s(cpsStmts).addCallStmt(cgsymValue(p.module, fn), rp)
     of tySequence:
@@ -2858,7 +2887,8 @@ proc genMagicExpr(p: BProc, e: PNode, d: var TLoc, op: TMagic) =
     const fun64: array[mInc..mDec, string] = ["nimAddInt64", "nimSubInt64"]
     const fun: array[mInc..mDec, string] = ["nimAddInt","nimSubInt"]
     let underlying = skipTypes(e[1].typ, {tyGenericInst, tyAlias, tySink, tyVar, tyLent, tyRange, tyDistinct})
-    if optOverflowCheck notin p.options or underlying.kind in {tyUInt..tyUInt64}:
+    if optOverflowCheck notin p.options or nfNoCheck in e.flags or
+        underlying.kind in {tyUInt..tyUInt64}:
       binaryStmt(p, e, d, opr[op])
     else:
       assert(e[1].typ != nil)
@@ -3762,7 +3792,10 @@ proc getNullValueAux(p: BProc; t: PType; obj, constOrNil: PNode,
   case obj.kind
   of nkRecList:
     let isUnion = tfUnion in t.flags
-    for it in obj.sons:
+    # ordered initializers follow the order the fields are declared in C
+    let fields = if fieldsReorderable(p.config, t): fieldLayoutOrder(p.config, obj)
+                 else: obj.sons
+    for it in fields:
       getNullValueAux(p, t, it, constOrNil, result, init, isConst, info)
       if isUnion:
         # generate only 1 field for default value of union
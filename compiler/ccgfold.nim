@@ -0,0 +1,119 @@
+#
+#
+#           The Nim Compiler
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+# included from cgen.nim
+
+## Identical code folding. Instantiations of generics often produce the same
+## C code, for example for a distinct type and its base type or for the
+## hooks of types with the same C type. A generated proc whose code equals
+## that of a proc emitted earlier into the same C file is turned into an
+## alias of that proc. A type info whose fields equal those of a type info
+## of any earlier module is not emitted at all; the modules refer to the
+## earlier one instead.
+##
+## Code is compared after replacing the name of the proc itself and the
+## names of procs that were already folded by the names they are aliases
+## of. C types are compared by name: types that map to the same C type
+## are not distinguished, any other type difference prevents folding, as
+## two C structs with different names may have different layouts.
+##
+## A folded proc has the address of the proc it is an alias of: proc values
+## of two folded instantiations compare equal, as with the linker option
+## `--icf=all`.
+
+proc declareNimType(m: BModule; name: string; str: Rope, module: int)
+
+proc codeFoldingEnabled(m: BModule): bool =
+  ## Aliases need ELF and a GCC compatible C compiler.
+  m.config.backend == backendC and not m.hcrOn and
+    m.config.cCompiler in {ccGcc, ccLLVM_Gcc, ccCLang, ccIcc} and
+    m.config.target.targetOS in {osLinux, osAndroid, osFreebsd, osNetbsd,
+      osOpenbsd, osDragonfly, osSolaris, osHaiku} and
+    optCDebug notin m.config.globalOptions and
+    isHeaderFile notin m.flags and
+    not isDefined(m.config, "nimNoCodeFolding")
+
+proc foldKey(g: BModuleList; code, self: string): string =
+  ## `code` with `self` and the names of folded procs made uniform.
+  result = newStringOfCap(code.len)
+  var i = 0
+  while i < code.len:
+    let c = code[i]
+    if c in IdentStartChars and (i == 0 or code[i-1] notin IdentChars):
+      var j = i+1
+      while j < code.len and code[j] in IdentChars: inc j
+      let id = substr(code, i, j-1)
+      if id == self: result.add "\1"
+      else: result.add g.foldedNames.getOrDefault(id, id)
+      i = j
+    elif c == '"':
+      # string literals are copied verbatim
+      var j = i+1
+      while j < code.len and code[j] != '"':
+        if code[j] == '\\': inc j
+        inc j
+      result.add substr(code, i, j)
+      i = j+1
+    else:
+      result.add c
+      inc i
+
+proc foldProc(m: BModule; prc: PSym; visibility: DeclVisibility;
+              header, code: string): bool =
+  ## Emits `prc` as an alias if an identical proc was emitted into the same
+  ## C file before. Returns false if `code` has to be emitted instead.
+  result = false
+  if not codeFoldingEnabled(m) or sfFromGeneric notin prc.flags or
+      visibility notin {Private, StaticProc} or prc.typ.callConv == ccInline or
+      {sfExportc, sfCodegenDecl, sfPure, sfCppMember} * prc.flags != {}:
+    return
+  let name = prc.loc.snippet
+  inc m.g.foldStats.procs
+  let key = $secureHash($visibility & "\n" & foldKey(m.g, code, name))
+  let canon = m.procFolds.getOrDefault(key)
+  if canon == "":
+    m.procFolds[key] = name
+    return
+  m.g.foldedNames[name] = canon
+  var alias = newBuilder("")
+  alias.addDeclWithVisibility(visibility):
+    alias.add(header)
+    alias.add(" __attribute__((alias(\"" & canon & "\")));\n")
+  let decl = extract(alias)
+  m.s[cfsProcs].add(decl)
+  inc m.g.foldStats.foldedProcs
+  m.g.foldStats.bytes += code.len - decl.len
+  result = true
+
+proc foldTypeInfo(m: BModule; sig: SigHash; name, entry: string): Rope =
+  ## Returns the name of an identical type info emitted before, or "" if
+  ## `entry`, the definition of `name`, has to be emitted.
+  result = ""
+  if not codeFoldingEnabled(m): return
+  inc m.g.foldStats.typeInfos
+  let key = $secureHash(foldKey(m.g, entry, name))
+  let canon = m.g.typeInfoFolds.getOrDefault(key)
+  if canon.str == "" or sig in m.g.typeInfoRefs:
+    # a type info that is referenced while it is generated keeps its name
+    if canon.str == "":
+      m.g.typeInfoFolds[key] = (str: name, owner: m.module.position.int32)
+    return
+  m.typeInfoMarkerV2[sig] = canon.str
+  m.g.typeInfoMarkerV2[sig] = canon
+  if canon.owner != m.module.position.int32:
+    declareNimType(m, "TNimTypeV2", canon.str, canon.owner)
+  inc m.g.foldStats.foldedTypeInfos
+  m.g.foldStats.bytes += entry.len
+  result = canon.str
+
+proc codeFoldingReport(g: BModuleList): string =
+  result = "code folding: " & $g.foldStats.foldedProcs & " of " &
+    $g.foldStats.procs & " procs, " & $g.foldStats.foldedTypeInfos & " of " &
+    $g.foldStats.typeInfos & " type infos, " & $g.foldStats.bytes &
+    " bytes of C code saved"
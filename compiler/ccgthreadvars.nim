@@ -49,9 +49,10 @@ proc generateThreadLocalStorage(m: BModule) =
   if m.g.nimtv.buf.len != 0 and (usesThreadVars in m.flags or sfMainModule in m.module.flags):
     for t in items(m.g.nimtvDeps): discard getTypeDesc(m, t)
     finishTypeDescriptions(m)
-    m.s[cfsSeqTypes].addTypedef(name = "NimThreadVars"):
-      m.s[cfsSeqTypes].addSimpleStruct(m, name = "", baseType = ""):
-        m.s[cfsSeqTypes].add(extract(m.g.nimtv))
+    addUnityGuarded(m, cfsSeqTypes, "NimThreadVars"):
+      m.s[cfsSeqTypes].addTypedef(name = "NimThreadVars"):
+        m.s[cfsSeqTypes].addSimpleStruct(m, name = "", baseType = ""):
+          m.s[cfsSeqTypes].add(extract(m.g.nimtv))
 
 proc generateThreadVarsSize(m: BModule) =
   if m.g.nimtv.buf.len != 0:
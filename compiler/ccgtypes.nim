@@ -427,9 +427,10 @@ proc getTypeDescWeak(m: BModule; t: PType; check: var IntSet; kind: TypeDescKind
       if cacheGetType(m.typeCache, sig) == "":
         m.typeCache[sig] = result
         #echo "adding ", sig, " ", typeToString(t), " ", m.module.name.s
-        m.s[cfsTypes].addSimpleStruct(m, name = result, baseType = ""):
-          m.s[cfsTypes].addField(name = "len", typ = NimInt)
-          m.s[cfsTypes].addField(name = "p", typ = ptrType(result & "_Content"))
+        addUnityGuarded(m, cfsTypes, result):
+          m.s[cfsTypes].addSimpleStruct(m, name = result, baseType = ""):
+            m.s[cfsTypes].addField(name = "len", typ = NimInt)
+            m.s[cfsTypes].addField(name = "p", typ = ptrType(result & "_Content"))
         pushType(m, t)
     else:
       result = getTypeForward(m, t, sig) & seqStar(m)
@@ -449,11 +450,12 @@ proc seqV2ContentType(m: BModule; t: PType; check: var IntSet) =
     discard getTypeDescAux(m, t, check, dkVar)
   else:
     let dataTyp = getTypeDescAux(m, t.skipTypes(abstractInst)[0], check, dkVar)
-    m.s[cfsTypes].addSimpleStruct(m, name = result & "_Content", baseType = ""):
-      m.s[cfsTypes].addField(name = "cap", typ = NimInt)
-      m.s[cfsTypes].addField(name = "data",
-        typ = dataTyp,
-        isFlexArray = true)
+    addUnityGuarded(m, cfsTypes, result & "_Content"):
+      m.s[cfsTypes].addSimpleStruct(m, name = result & "_Content", baseType = ""):
+        m.s[cfsTypes].addField(name = "cap", typ = NimInt)
+        m.s[cfsTypes].addField(name = "data",
+          typ = dataTyp,
+          isFlexArray = true)
 
 proc paramStorageLoc(param: PSym): TStorageLoc =
   if param.typ.skipTypes({tyVar, tyLent, tyTypeDesc}).kind notin {
@@ -675,8 +677,12 @@ proc genRecordFieldsAux(m: BModule; n: PNode,
                         check: var IntSet; result: var Builder; unionPrefix = "") =
   case n.kind
   of nkRecList:
-    for i in 0..<n.len:
-      genRecordFieldsAux(m, n[i], rectype, check, result, unionPrefix)
+    if fieldsReorderable(m.config, rectype):
+      for it in fieldLayoutOrder(m.config, n):
+        genRecordFieldsAux(m, it, rectype, check, result, unionPrefix)
+    else:
+      for i in 0..<n.len:
+        genRecordFieldsAux(m, n[i], rectype, check, result, unionPrefix)
   of nkRecCase:
     if n[0].kind != nkSym: internalError(m.config, n.info, "genRecordFieldsAux")
     genRecordFieldsAux(m, n[0], rectype, check, result, unionPrefix)
@@ -762,9 +768,38 @@ proc fillObjectFields*(m: BModule; typ: PType) =
 
 proc mangleDynLibProc(sym: PSym): Rope
 
+proc recordPadding(m: BModule; typ: PType) =
+  let (padding, saving) = objectPadding(m.config, typ)
+  if padding > 0:
+    var name = typeToString(typ)
+    if typ.sym != nil: name.add " (" & toFileLineCol(m.config, typ.sym.info) & ")"
+    m.g.paddings[name] = (size: int(typ.size), padding: padding, saving: saving)
+
+proc paddingReport(g: BModuleList): string =
+  ## The object types with the most padding, the ones reordering the fields
+  ## would shrink the most first.
+  const maxTypes = 10
+  var worst: seq[(string, int, int, int)] = @[]
+  var total, saved = 0
+  for name, p in g.paddings:
+    worst.add (name, p.size, p.padding, p.saving)
+    total += p.padding
+    saved += p.saving
+  worst.sort(proc (a, b: (string, int, int, int)): int =
+    result = cmp(b[3], a[3])
+    if result == 0: result = cmp(b[2], a[2])
+    if result == 0: result = cmp(a[0], b[0]))
+  result = "padding: " & $total & " bytes in " & $worst.len &
+    " object types, reordering the fields would save " & $saved & " bytes"
+  for i in 0..<min(worst.len, maxTypes):
+    let (name, size, padding, saving) = worst[i]
+    result.add "\n  " & name & ": " & $size & " bytes, " & $padding &
+      " bytes padding, " & $saving & " bytes saved by reordering"
+
 proc getRecordDesc(m: BModule; typ: PType, name: Rope,
                    check: var IntSet): Rope =
   # declare the record:
+  if m.config.hasHint(hintPadding): recordPadding(m, typ)
   var baseType: string = ""
   if typ.baseClass != nil:
     baseType = getTypeDescAux(m, typ.baseClass.skipTypes(skipPtrs), check, dkField)
@@ -827,10 +862,11 @@ proc getOpenArrayDesc(m: BModule; t: PType, check: var IntSet; kind: TypeDescKin
       result = getTypeName(m, t, sig)
       m.typeCache[sig] = result
       let elemType = getTypeDescWeak(m, t.elementType, check, kind)
-      m.s[cfsTypes].addTypedef(name = result):
-        m.s[cfsTypes].addSimpleStruct(m, name = "", baseType = ""):
-          m.s[cfsTypes].addField(name = "Field0", typ = ptrType(elemType))
-          m.s[cfsTypes].addField(name = "Field1", typ = NimInt)
+      addUnityGuarded(m, cfsTypes, result):
+        m.s[cfsTypes].addTypedef(name = result):
+          m.s[cfsTypes].addSimpleStruct(m, name = "", baseType = ""):
+            m.s[cfsTypes].addField(name = "Field0", typ = ptrType(elemType))
+            m.s[cfsTypes].addField(name = "Field1", typ = NimInt)
 
 proc getTypeDescAux(m: BModule; origTyp: PType, check: var IntSet; kind: TypeDescKind): Rope =
   # returns only the type's name
@@ -943,10 +979,11 @@ proc getTypeDescAux(m: BModule; origTyp: PType, check: var IntSet; kind: TypeDes
       if t.callConv != ccClosure: # procedure vars may need a closure!
         m.s[cfsTypes].addProcTypedef(callConv = t.callConv, name = result, rettype = rettype, params = params)
       else:
-        m.s[cfsTypes].addTypedef(name = result):
-          m.s[cfsTypes].addSimpleStruct(m, name = "", baseType = ""):
-            m.s[cfsTypes].addProcField(name = "ClP_0", callConv = ccNimCall, rettype = rettype, params = params)
-            m.s[cfsTypes].addField(name = "ClE_0", typ = CPointer)
+        addUnityGuarded(m, cfsTypes, result):
+          m.s[cfsTypes].addTypedef(name = result):
+            m.s[cfsTypes].addSimpleStruct(m, name = "", baseType = ""):
+              m.s[cfsTypes].addProcField(name = "ClP_0", callConv = ccNimCall, rettype = rettype, params = params)
+              m.s[cfsTypes].addField(name = "ClE_0", typ = CPointer)
   of tySequence:
     if optSeqDestructors in m.config.globalOptions:
       result = getTypeDescWeak(m, t, check, kind)
@@ -965,11 +1002,12 @@ proc getTypeDescAux(m: BModule; origTyp: PType, check: var IntSet; kind: TypeDes
         if skipTypes(t.elementType, typedescInst).kind != tyEmpty:
           let et = getTypeDescAux(m, t.elementType, check, kind)
           let baseType = cgsymValue(m, "TGenericSeq")
-          m.s[cfsSeqTypes].addSimpleStruct(m, name = result, baseType = baseType):
-            m.s[cfsSeqTypes].addField(
-              name = "data",
-              typ = et,
-              isFlexArray = true)
+          addUnityGuarded(m, cfsSeqTypes, result):
+            m.s[cfsSeqTypes].addSimpleStruct(m, name = result, baseType = baseType):
+              m.s[cfsSeqTypes].addField(
+                name = "data",
+                typ = et,
+                isFlexArray = true)
         else:
           result = rope("TGenericSeq")
       result.add(seqStar(m))
@@ -1051,7 +1089,8 @@ proc getTypeDescAux(m: BModule; origTyp: PType, check: var IntSet; kind: TypeDes
         let recdesc = if t.kind != tyTuple: getRecordDesc(m, t, result, check)
                       else: getTupleDesc(m, t, result, check)
         if not isImportedType(t):
-          m.s[cfsTypes].add(recdesc)
+          addUnityGuarded(m, cfsTypes, result):
+            m.s[cfsTypes].add(recdesc)
         elif tfIncompleteStruct notin t.flags:
           discard # addAbiCheck(m, t, result) # already handled elsewhere
   of tySet:
@@ -1715,6 +1754,20 @@ proc genVTable(result: var Builder, seqs: seq[PSym]) =
       result.addField(table, ""):
         result.add(cCast(CPointer, seqs[i].loc.snippet))
 
+proc hasTypeInfoV2Name(m: BModule): bool {.inline.} =
+  result = isDefined(m.config, "nimTypeNames") or isDefined(m.config, "nimHeapProfiler")
+
+proc genTypeInfoV2Name(m: BModule; t: PType): Snippet =
+  let heapProfiler = isDefined(m.config, "nimHeapProfiler")
+  if t.kind in {tyObject, tyDistinct} and
+      not (heapProfiler and tfFromGeneric in t.skipTypes(skipPtrs).flags):
+    result = genTypeInfo2Name(m, t)
+  elif heapProfiler:
+    # the profiler shows generic instances and `ref int` by name too
+    result = makeCString(typeToString(t))
+  else:
+    result = NimNil
+
 proc genTypeInfoV2OldImpl(m: BModule; t, origType: PType, name: Rope; info: TLineInfo) =
   cgsym(m, "TNimTypeV2")
   m.s[cfsStrData].addDeclWithVisibility(Private):
@@ -1737,13 +1790,8 @@ proc genTypeInfoV2OldImpl(m: BModule; t, origType: PType, name: Rope; info: TLin
     localError(m.config, info, "request for RTTI generation for incomplete object: " &
               typeToString(t))
 
-  if isDefined(m.config, "nimTypeNames"):
-    var typeName: Snippet
-    if t.kind in {tyObject, tyDistinct}:
-      typeName = genTypeInfo2Name(m, t)
-    else:
-      typeName = NimNil
-    typeEntry.addFieldAssignment(name, "name", typeName)
+  if hasTypeInfoV2Name(m):
+    typeEntry.addFieldAssignment(name, "name", genTypeInfoV2Name(m, t))
   let sizeTyp = getTypeDesc(m, t)
   typeEntry.addFieldAssignmentWithValue(name, "size"):
     typeEntry.addSizeof(sizeTyp)
@@ -1779,14 +1827,14 @@ proc genTypeInfoV2OldImpl(m: BModule; t, origType: PType, name: Rope; info: TLin
   if t.kind == tyObject and t.baseClass != nil and optEnableDeepCopy in m.config.globalOptions:
     discard genTypeInfoV1(m, t, info)
 
-proc genTypeInfoV2Impl(m: BModule; t, origType: PType, name: Rope; info: TLineInfo) =
+proc genTypeInfoV2Impl(m: BModule; t, origType: PType, name: Rope; info: TLineInfo;
+                       sig: SigHash): Rope =
   cgsym(m, "TNimTypeV2")
-  m.s[cfsStrData].addDeclWithVisibility(Private):
-    m.s[cfsStrData].addVar(kind = Local, name = name, typ = "TNimTypeV2")
 
   var flags = 0
   if not canFormAcycle(m.g.graph, t): flags = flags or 1
 
+  let dispatchMethods = toSeq(getMethodsPerType(m.g.graph, t))
   var typeEntry = newBuilder("")
   typeEntry.addDeclWithVisibility(Private):
     typeEntry.addVarWithInitializer(kind = Local, name = name, typ = "TNimTypeV2"):
@@ -1820,19 +1868,13 @@ proc genTypeInfoV2Impl(m: BModule; t, origType: PType, name: Rope; info: TLineIn
             genDisplay(m.s[cfsVars], m, t, objDepth)
           typeEntry.addField(typeInit, name = "display"):
             typeEntry.add(objDisplayStore)
-        if isDefined(m.config, "nimTypeNames"):
-          var typeName: Rope
-          if t.kind in {tyObject, tyDistinct}:
-            typeName = genTypeInfo2Name(m, t)
-          else:
-            typeName = NimNil
+        if hasTypeInfoV2Name(m):
           typeEntry.addField(typeInit, name = "name"):
-            typeEntry.add(typeName)
+            typeEntry.add(genTypeInfoV2Name(m, t))
         typeEntry.addField(typeInit, name = "traceImpl"):
           typeEntry.addCast(CPointer):
             genHook(m, t, info, attachedTrace, typeEntry)
 
-        let dispatchMethods = toSeq(getMethodsPerType(m.g.graph, t))
         if dispatchMethods.len > 0:
           typeEntry.addField(typeInit, name = "flags"):
             typeEntry.addIntValue(flags)
@@ -1843,7 +1885,16 @@ proc genTypeInfoV2Impl(m: BModule; t, origType: PType, name: Rope; info: TLineIn
         else:
           typeEntry.addField(typeInit, name = "flags"):
             typeEntry.addIntValue(flags)
-  m.s[cfsVars].add extract(typeEntry)
+  let entry = extract(typeEntry)
+  result = ""
+  if t.kind != tyObject and dispatchMethods.len == 0:
+    result = foldTypeInfo(m, sig, name, entry)
+  if result == "":
+    m.s[cfsStrData].addDeclWithVisibility(Private):
+      m.s[cfsStrData].addVar(kind = Local, name = name, typ = "TNimTypeV2")
+    m.s[cfsVars].add entry
+    result = name
+    rememberObjectTypeInfo(m, t, name, cyclic = flags == 0)
 
   if t.kind == tyObject and t.baseClass != nil and optEnableDeepCopy in m.config.globalOptions:
     discard genTypeInfoV1(m, t, info)
@@ -1862,10 +1913,12 @@ proc genTypeInfoV2(m: BModule; t: PType; info: TLineInfo): Rope =
   let sig = hashType(origType, m.config)
   result = m.typeInfoMarkerV2.getOrDefault(sig)
   if result != "":
+    m.g.typeInfoRefs.incl sig
     return prefixTI(result)
 
   let marker = m.g.typeInfoMarkerV2.getOrDefault(sig)
   if marker.str != "":
+    m.g.typeInfoRefs.incl sig
     cgsym(m, "TNimTypeV2")
     declareNimType(m, "TNimTypeV2", marker.str, marker.owner)
     # also store in local type section:
@@ -1879,16 +1932,18 @@ proc genTypeInfoV2(m: BModule; t: PType; info: TLineInfo): Rope =
   if owner != m.module.position and moduleOpenForCodegen(m.g.graph, FileIndex owner):
     # make sure the type info is created in the owner module
     discard genTypeInfoV2(m.g.modules[owner], origType, info)
-    # reference the type info as extern here
+    # reference the type info as extern here; it can be folded into another
+    let marker = m.g.typeInfoMarkerV2.getOrDefault(sig, (str: result, owner: owner))
+    m.typeInfoMarkerV2[sig] = marker.str
     cgsym(m, "TNimTypeV2")
-    declareNimType(m, "TNimTypeV2", result, owner)
-    return prefixTI(result)
+    declareNimType(m, "TNimTypeV2", marker.str, marker.owner)
+    return prefixTI(marker.str)
 
   m.g.typeInfoMarkerV2[sig] = (str: result, owner: owner)
   if m.compileToCpp or m.hcrOn:
     genTypeInfoV2OldImpl(m, t, origType, result, info)
   else:
-    genTypeInfoV2Impl(m, t, origType, result, info)
+    result = genTypeInfoV2Impl(m, t, origType, result, info, sig)
   result = prefixTI(result)
 
 proc openArrayToTuple(m: BModule; t: PType): PType =
@@ -20,7 +20,9 @@ import
 
 from expanddefaults import caseObjDefaultBranch
 
-import pipelineutils
+import pipelineutils, timeline
+
+import ../dist/checksums/src/checksums/sha1
 
 when defined(nimPreviewSlimSystem):
   import std/assertions
@@ -32,6 +34,7 @@ import std/strutils except `%`, addf # collides with ropes.`%`
 
 from ic / ic import ModuleBackendFlag
 import std/[dynlib, math, tables, sets, os, intsets, hashes]
+from std/algorithm import sort
 
 const
   # we use some ASCII control characters to insert directives that will be converted to real code in a postprocessing pass
@@ -351,6 +354,20 @@ proc getTempName(m: BModule): Rope =
 proc isNoReturn(m: BModule; s: PSym): bool {.inline.} =
   sfNoReturn in s.flags and m.config.exc != excGoto
 
+proc isUnityBuild(conf: ConfigRef): bool {.inline.} =
+  optUnityBuild in conf.globalOptions and conf.backend == backendC and
+    not conf.hcrOn and conf.symbolFiles == disabledSf and conf.cmd != cmdTcc
+
+template addUnityGuarded(m: BModule; sec: TCFileSection; name: string; body: untyped) =
+  ## In a unity build the sections of several modules share one C file. A
+  ## definition that every module emits for itself may only be seen once.
+  let guarded = isUnityBuild(m.config)
+  if guarded:
+    m.s[sec].add("#ifndef NIM_DEF_" & name & "\n#define NIM_DEF_" & name & "\n")
+  body
+  if guarded:
+    m.s[sec].add("#endif\n")
+
 include cbuilderexprs
 include cbuilderdecls
 include cbuilderstmts
@@ -390,9 +407,34 @@ proc dataFieldAccessor(p: BProc, sym: Rope): Rope =
 proc dataField(p: BProc, val: Rope): Rope {.inline.} =
   result = derefField(dataFieldAccessor(p, val), "data")
 
+proc ssoStrings(conf: ConfigRef): bool {.inline.} =
+  ## With `-d:nimSso` a short string stores its chars inline, starting at
+  ## its `p` field, and has its `sso` field set.
+  optSeqDestructors in conf.globalOptions and isDefined(conf, "nimSso")
+
+proc ssoFlag(val: Rope): Rope {.inline.} =
+  result = dotField(wrapPar(val), "sso")
+
+proc ssoChars(val: Rope): Rope {.inline.} =
+  result = cCast(ptrType(NimChar), cAddr(dotField(wrapPar(val), "p")))
+
+proc strDataField(p: BProc, val: Rope): Rope =
+  ## `dataField` for the string `val`.
+  result = dataField(p, val)
+  if ssoStrings(p.config):
+    result = cIfExpr(ssoFlag(val), ssoChars(val), result)
+
+proc dataOrNil(p: BProc, val: Rope; isString: bool): Rope =
+  ## The data of the seq or string `val`, `NIM_NIL` if it has no payload.
+  result = cIfExpr(dataFieldAccessor(p, val), dataField(p, val), NimNil)
+  if isString and ssoStrings(p.config):
+    result = cIfExpr(ssoFlag(val), ssoChars(val), result)
+
 proc genProcPrototype(m: BModule, sym: PSym)
 
 include ccgliterals
+include ccgfold
+include ccgacyclic
 include ccgtypes
 
 # ------------------------------ Manager of temporaries ------------------
@@ -1344,11 +1386,12 @@ proc genProcAux*(m: BModule, prc: PSym) =
 
   prc.info = tmpInfo
 
+  let headerCode = extract(header)
   var generatedProc = newBuilder("")
   generatedProc.genCLineDir prc.info, m.config
   generatedProc.addDeclWithVisibility(visibility):
     if sfPure in prc.flags:
-      generatedProc.add(extract(header))
+      generatedProc.add(headerCode)
       generatedProc.finishProcHeaderWithBody():
         generatedProc.add(extract(p.s(cpsLocals)))
         generatedProc.add(extract(p.s(cpsInit)))
@@ -1359,9 +1402,9 @@ proc genProcAux*(m: BModule, prc: PSym) =
           # Add forward declaration for "_actual"-suffixed functions defined in the same module (or inline).
           # This fixes the use of methods and also the case when 2 functions within the same module
           # call each other using directly the "_actual" versions (an optimization) - see issue #11608
-          m.s[cfsProcHeaders].add(extract(header))
+          m.s[cfsProcHeaders].add(headerCode)
           m.s[cfsProcHeaders].finishProcHeaderAsProto()
-      generatedProc.add(extract(header))
+      generatedProc.add(headerCode)
       generatedProc.finishProcHeaderWithBody():
         if optStackTrace in prc.options:
           generatedProc.add(extract(p.s(cpsLocals)))
@@ -1385,7 +1428,13 @@ proc genProcAux*(m: BModule, prc: PSym) =
           generatedProc.add(extract(p.s(cpsStmts)))
         if optStackTrace in prc.options: generatedProc.add(deinitFrame(p))
         generatedProc.add(returnStmt)
-  m.s[cfsProcs].add(extract(generatedProc))
+  let code = extract(generatedProc)
+  if prc.typ.callConv == ccInline:
+    # emitted by every module that calls it
+    addUnityGuarded(m, cfsProcs, prc.loc.snippet):
+      m.s[cfsProcs].add(code)
+  elif not foldProc(m, prc, visibility, headerCode, code):
+    m.s[cfsProcs].add(code)
   if isReloadable(m, prc):
     m.s[cfsDynLibInit].add('\t')
     m.s[cfsDynLibInit].addAssignmentWithValue(prc.loc.snippet):
@@ -2464,8 +2513,7 @@ proc shouldRecompile(m: BModule; code: Rope, cfile: Cfile): bool =
 # such logic and in fact the logic hurts for the main module at least;
 # it would generate multiple 'main' procs, for instance.
 
-proc writeModule(m: BModule, pending: bool) =
-  let cfile = getCFile(m)
+proc finishModuleCode(m: BModule) =
   if moduleHasChanged(m.g.graph, m.module):
     genInitCode(m)
     finishTypeDescriptions(m)
@@ -2475,6 +2523,10 @@ proc writeModule(m: BModule, pending: bool) =
       m.s[cfsProcHeaders].add(extract(m.g.mainModProcs))
       generateThreadVarsSize(m)
 
+proc writeModule(m: BModule, pending: bool) =
+  let cfile = getCFile(m)
+  finishModuleCode(m)
+
   var cf = Cfile(nimname: m.module.name.s, cname: cfile,
                   obj: completeCfilePath(m.config, toObjFile(m.config, cfile)), flags: {})
   var code = genModule(m, cf)
@@ -2487,6 +2539,79 @@ proc writeModule(m: BModule, pending: bool) =
     if not shouldRecompile(m, code, cf): cf.flags = {CfileFlag.Cached}
     addFileToCompile(m.config, cf)
 
+type
+  UnityPart = object
+    ## The code of a module in a unity build, section by section.
+    headers: string
+    sections: array[cfsForwardTypes..cfsDatInitProc, string]
+    size: int
+
+proc genUnityPart(m: BModule): UnityPart =
+  result = UnityPart()
+  generateThreadLocalStorage(m)
+  generateHeaders(m)
+  result.headers = extract(m.s[cfsHeaders]) & extract(m.s[cfsFrameDefines])
+  for i in cfsForwardTypes..cfsDatInitProc:
+    var code = extract(m.s[i])
+    postprocessCode(m.config, code)
+    result.size += code.len
+    result.sections[i] = move code
+
+proc writeUnityShard(conf: ConfigRef; parts: openArray[UnityPart]; idx: int) =
+  let cfile = changeFileExt(completeCfilePath(conf, AbsoluteFile("@unity" & $idx)), ".nim.c")
+  var cf = Cfile(nimname: "unity" & $idx, cname: cfile,
+                 obj: completeCfilePath(conf, toObjFile(conf, cfile)), flags: {})
+  var code = getFileHeader(conf, cf)
+  if optLineDir in conf.options:
+    for fi in 0..conf.m.fileInfos.high:
+      code.add("#define FX_" & $fi & " " & makeSingleLineCString(toFullPath(conf, fi.FileIndex)) & "\n")
+  # the headers of all modules come first, so that feature macros a module
+  # defines before its includes are in effect for every include
+  for p in parts: code.add p.headers
+  for i in cfsForwardTypes..cfsDatInitProc:
+    for p in parts: code.add p.sections[i]
+  if optForceFullMake notin conf.globalOptions and equalsFile(code, cfile):
+    if fileExists(cf.obj) and os.fileNewer(cf.obj.string, cfile.string):
+      cf.flags = {CfileFlag.Cached}
+  elif not writeRope(code, cfile):
+    rawMessage(conf, errCannotOpenFile, cfile.string)
+  addFileToCompile(conf, cf)
+
+proc writeUnityBuild(g: BModuleList) =
+  ## Writes the modules as `--unityShards` C files of similar size. Modules
+  ## with C compiler options of their own keep their own C file.
+  let conf = g.config
+  var parts: seq[UnityPart] = @[]
+  for m in cgenModules(g):
+    traceTimeline(conf, "cgen", m.module.name.s):
+      let cf = Cfile(nimname: m.module.name.s, cname: getCFile(m))
+      if m.compileToCpp or sfCompileToObjc in m.module.flags or
+          hasFileSpecificOptions(conf, cf):
+        m.writeModule(pending=true)
+      else:
+        finishModuleCode(m)
+        let part = genUnityPart(m)
+        if part.size > 0: parts.add part
+  let n = max(1, min(conf.unityShards, parts.len))
+  # largest parts first, each into the currently smallest shard; every shard
+  # keeps the modules in their original order
+  var order = newSeq[int](parts.len)
+  for i in 0..<parts.len: order[i] = i
+  order.sort(proc (a, b: int): int = cmp(parts[b].size, parts[a].size))
+  var shardOf = newSeq[int](parts.len)
+  var sizes = newSeq[int](n)
+  for i in order:
+    var best = 0
+    for s in 1..<n:
+      if sizes[s] < sizes[best]: best = s
+    shardOf[i] = best
+    sizes[best] += parts[i].size
+  for s in 0..<n:
+    var shard: seq[UnityPart] = @[]
+    for i in 0..<parts.len:
+      if shardOf[i] == s: shard.add move(parts[i])
+    writeUnityShard(conf, shard, s)
+
 proc updateCachedModule(m: BModule) =
   let cfile = getCFile(m)
   var cf = Cfile(nimname: m.module.name.s, cname: cfile,
@@ -2601,8 +2726,17 @@ proc cgenWriteModules*(backend: RootRef, config: ConfigRef) =
   # deps are allowed (and the system module is processed in the wrong
   # order anyway)
   genForwardedProcs(g)
+  inferAcyclicTypes(g)
 
-  for m in cgenModules(g):
-    m.writeModule(pending=true)
+  if isUnityBuild(config):
+    writeUnityBuild(g)
+  else:
+    for m in cgenModules(g):
+      traceTimeline(config, "cgen", m.module.name.s):
+        m.writeModule(pending=true)
   writeMapping(config, g.mapping)
   if g.generatedHeader != nil: writeHeader(g.generatedHeader)
+  if config.hasHint(hintCodeFolding):
+    rawMessage(config, hintCodeFolding, codeFoldingReport(g))
+  if config.hasHint(hintPadding):
+    rawMessage(config, hintPadding, paddingReport(g))
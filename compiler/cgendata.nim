@@ -138,6 +138,13 @@ type
                             # nimtvDeps is VERY hard to cache because it's
                             # not a list of IDs nor can it be made to be one.
     mangledPrcs*: HashSet[string]
+    foldedNames*: Table[string, string] # folded proc -> the proc it aliases
+    typeInfoFolds*: Table[string, tuple[str: Rope, owner: int32]]
+    typeInfoRefs*: HashSet[SigHash] # type infos referenced while generated
+    foldStats*: tuple[procs, foldedProcs, typeInfos, foldedTypeInfos, bytes: int]
+    paddings*: Table[string, tuple[size, padding, saving: int]] # for hintPadding
+    objectTypeInfos*: seq[tuple[t: PType, name: Rope, module: int, cyclic: bool]]
+      # for the acyclic inference
 
   TCGen = object of PPassContext # represents a C source file
     s*: TCFileSections        # sections of the C file
@@ -172,6 +179,7 @@ type
     extensionLoaders*: array['0'..'9', Builder] # special procs for the
                                              # OpenGL wrapper
     sigConflicts*: CountTable[SigHash]
+    procFolds*: Table[string, Rope] # code hash -> first proc with this code
     g*: BModuleList
 
 template config*(m: BModule): ConfigRef = m.g.config
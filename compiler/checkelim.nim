@@ -0,0 +1,629 @@
+#
+#
+#           The Nim Compiler
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+## This module removes index checks and overflow checks that can never fail.
+## It walks a routine body before it is transformed and collects facts about
+## integer locals with the help of `guards`: the range of the variable of a
+## `for` loop over `..`, `..<`, `countup` and `countdown` and the conditions
+## of `if` and `while` statements. An index or arithmetic operation that the
+## facts prove to be in range gets the `nfNoCheck` flag and the code
+## generator leaves out its check.
+##
+## The analysis is deliberately simple and conservative. A fact may only
+## mention literals, constants and locals of the routine whose address is
+## not taken and that are not written by a nested routine, combined with
+## integer arithmetic, comparisons and `len`. Writes to a local remove every
+## fact that mentions it; a loop first removes the facts about everything it
+## writes. Parameters passed by `var` and locals passed to a `var` parameter
+## are forgotten at every call that is not a magic.
+##
+## When the index of an access in a loop is the loop variable, the access is
+## executed in every iteration and the loop has no other effects than
+## assignments and builtin arithmetic, the check of the first and the last
+## index is moved in front of the loop and covers all iterations. Such a loop
+## reports an `IndexDefect` before its first iteration instead of in the
+## failing one.
+
+import ast, astalgo, types, trees, guards, modulegraphs, options, msgs,
+  lineinfos, magicsys, lowerings, int128
+import std/intsets
+
+when defined(nimPreviewSlimSystem):
+  import std/assertions
+
+const
+  PureMagics = {mLow, mHigh, mSizeOf, mInc, mDec, mOrd, mChr,
+    mLengthOpenArray..mLengthSeq, mAddI..mXor, mUnaryMinusI..mUnaryMinusF64}
+    ## magics without effects besides writing their `var` argument and
+    ## raising a `Defect`
+  FactMagics = {mAddI, mSubI, mMulI, mDivI, mModI, mSucc, mPred, mMinI, mMaxI,
+    mEqI, mLeI, mLtI, mLengthOpenArray..mLengthSeq, mHigh, mNot, mAnd}
+  NestedDefs = routineDefs + nkLambdaKinds + {nkTypeSection, nkConstSection}
+
+type
+  Effects = object
+    written: seq[PSym]
+    opaque: bool ## calls a routine that is not a magic
+    impure: bool ## has control flow or calls something that is not pure
+
+  Elim = object
+    g: ModuleGraph
+    prc: PSym
+    m: TModel
+    written: IntSet  ## written anywhere in the routine
+    unstable: IntSet ## address taken or written by a nested routine
+    exposed: IntSet  ## passed to a `var` parameter of a call
+    hoist: bool      ## rewrite loops to check in front of them
+    wantsHoist: bool
+    indexChecks, indexElided, overflowChecks, overflowElided, hoisted: int
+
+proc isSignedInt(t: PType): bool =
+  t != nil and t.skipTypes(abstractRange).kind in {tyInt..tyInt64}
+
+proc isPlainValue(t: PType): bool =
+  ## assigning a value of type `t` cannot call a hook
+  t != nil and t.skipTypes(abstractRange).kind in
+    {tyBool, tyChar, tyEnum, tyInt..tyUInt64, tyFloat..tyFloat128, tyPtr, tyPointer}
+
+proc rootSym(n: PNode): PSym =
+  var n = n
+  while true:
+    case n.kind
+    of nkHiddenDeref, nkHiddenAddr, nkAddr: n = n[0]
+    of nkHiddenStdConv, nkHiddenSubConv, nkConv: n = n[1]
+    else: break
+  result = if n.kind == nkSym: n.sym else: nil
+
+proc addWrite(e: var Effects; n: PNode) =
+  if n.kind in {nkTupleConstr, nkPar}:
+    for x in n: addWrite(e, x)
+  else:
+    let s = rootSym(n)
+    if s != nil: e.written.add s
+
+proc isVarFormal(t: PType; i: int): bool =
+  t != nil and t.kind == tyProc and i < t.len and t[i] != nil and
+    t[i].skipTypes(abstractInst-{tyTypeDesc}).kind == tyVar
+
+proc effects(n: PNode; e: var Effects) =
+  ## Collects the writes of `n`, not counting nested routines.
+  case n.kind
+  of nkNone..nkNilLit, NestedDefs: discard
+  of nkAsgn, nkFastAsgn, nkSinkAsgn:
+    addWrite(e, n[0])
+    if not isPlainValue(n[0].typ): e.impure = true
+    effects(n[0], e)
+    effects(n[1], e)
+  of nkHiddenAddr, nkAddr:
+    addWrite(e, n[0])
+    effects(n[0], e)
+  of nkIdentDefs, nkVarTuple:
+    for i in 0..<n.len-2:
+      addWrite(e, n[i])
+      if not isPlainValue(n[i].typ): e.impure = true
+    effects(n[^1], e)
+  of nkForStmt, nkParForStmt:
+    for i in 0..<n.len-2: addWrite(e, n[i])
+    let iterCall = n[^2]
+    if iterCall.kind notin nkCallKinds or iterCall[0].kind != nkSym or
+        not fromSystem(iterCall[0].sym):
+      # the body of the iterator is inlined here
+      e.opaque = true
+      e.impure = true
+    for i in 1..<iterCall.safeLen: effects(iterCall[i], e)
+    effects(n[^1], e)
+  of nkCallKinds:
+    if n[0].kind == nkSym and n[0].sym.magic != mNone:
+      if n[0].sym.magic == mAddr: addWrite(e, n[1])
+      if n[0].sym.magic notin PureMagics: e.impure = true
+    else:
+      e.opaque = true
+      e.impure = true
+    let t = if n[0].typ != nil: n[0].typ.skipTypes(abstractInst) else: nil
+    for i in 1..<n.len:
+      if isVarFormal(t, i): addWrite(e, n[i])
+    for x in n: effects(x, e)
+  of nkBreakStmt, nkContinueStmt, nkReturnStmt, nkRaiseStmt, nkYieldStmt:
+    e.impure = true
+    for x in n: effects(x, e)
+  else:
+    for x in n: effects(x, e)
+
+proc scan(c: var Elim; n: PNode; nested: bool) =
+  ## Finds the locals that are unsafe to reason about.
+  case n.kind
+  of nkNone..nkNilLit, nkTypeSection, nkConstSection: discard
+  of routineDefs + nkLambdaKinds:
+    if n.len > bodyPos:
+      var e = Effects()
+      effects(n[bodyPos], e)
+      for s in e.written: c.unstable.incl s.id
+      scan(c, n[bodyPos], true)
+  of nkAddr:
+    let s = rootSym(n)
+    if s != nil: c.unstable.incl s.id
+    scan(c, n[0], nested)
+  of nkHiddenAddr:
+    let s = rootSym(n)
+    if s != nil: c.exposed.incl s.id
+    scan(c, n[0], nested)
+  of nkCallKinds:
+    if n[0].getMagic == mAddr:
+      let s = rootSym(n[1])
+      if s != nil: c.unstable.incl s.id
+    elif n[0].getMagic == mNone:
+      let t = if n[0].typ != nil: n[0].typ.skipTypes(abstractInst) else: nil
+      for i in 1..<n.len:
+        if isVarFormal(t, i):
+          let s = rootSym(n[i])
+          if s != nil: c.exposed.incl s.id
+    for x in n: scan(c, x, nested)
+  else:
+    for x in n: scan(c, x, nested)
+
+proc isVarParam(s: PSym): bool =
+  s.kind == skParam and s.typ.skipTypes(abstractInst).kind == tyVar
+
+proc admissibleSym(c: Elim; s: PSym): bool =
+  case s.kind
+  of skConst, skEnumField: result = true
+  of skLet, skVar, skForVar, skParam, skResult, skTemp:
+    result = {sfGlobal, sfThread, sfAddrTaken} * s.flags == {} and
+      s.owner == c.prc and s.id notin c.unstable
+  else: result = false
+
+proc stableExpr(c: Elim; n: PNode): bool
+
+proc admissible(c: Elim; n: PNode): bool =
+  ## Whether the fact `n` only mentions things the analysis can track.
+  case n.kind
+  of nkCharLit..nkInt64Lit: result = true
+  of nkSym:
+    let s = n.sym
+    result = admissibleSym(c, s)
+    if result and s.kind == skLet and s.astdef.getMagic != mNone:
+      # `guards.canon` replaces such a `let` by its value
+      result = stableExpr(c, s.astdef)
+  of nkHiddenStdConv, nkHiddenSubConv, nkConv:
+    result = isSignedInt(n.typ) and isSignedInt(n[1].typ) and admissible(c, n[1])
+  of nkHiddenDeref:
+    result = n[0].kind == nkSym and isVarParam(n[0].sym) and admissible(c, n[0])
+  of nkCallKinds:
+    result = n[0].kind == nkSym and n[0].sym.magic in FactMagics
+    for i in 1..<n.len:
+      if not result: break
+      result = admissible(c, n[i])
+  else: result = false
+
+proc stableExpr(c: Elim; n: PNode): bool =
+  ## `n` is admissible and has the same value everywhere in the routine.
+  case n.kind
+  of nkCharLit..nkInt64Lit: result = true
+  of nkSym:
+    result = admissible(c, n) and n.sym.id notin c.written and
+      not isVarParam(n.sym) and n.sym.id notin c.exposed
+  of nkHiddenStdConv, nkHiddenSubConv, nkConv:
+    result = isSignedInt(n.typ) and isSignedInt(n[1].typ) and stableExpr(c, n[1])
+  of nkCallKinds:
+    result = n[0].kind == nkSym and n[0].sym.magic in FactMagics
+    for i in 1..<n.len:
+      if not result: break
+      result = stableExpr(c, n[i])
+  else: result = false
+
+proc letsAreStable(c: Elim; n: PNode): bool =
+  ## The `let` variables in the query `n` may be replaced by their values.
+  case n.kind
+  of nkSym:
+    result = n.sym.kind != skLet or n.sym.astdef.getMagic == mNone or
+      stableExpr(c, n.sym.astdef)
+  of NestedDefs: result = false
+  else:
+    result = true
+    for x in n:
+      if not letsAreStable(c, x): return false
+
+# ---------------- facts ----------------
+
+proc invalidate(c: var Elim; e: Effects) =
+  for s in e.written:
+    invalidateFacts(c.m, newSymNode(s))
+  if e.opaque:
+    for i in 0..<c.m.s.len:
+      let f = c.m.s[i]
+      if f != nil:
+        var leaves: seq[PNode] = @[f]
+        while leaves.len > 0:
+          let x = leaves.pop
+          if x.kind == nkSym:
+            if isVarParam(x.sym) or x.sym.id in c.exposed:
+              c.m.s[i] = nil
+              break
+          else:
+            for y in x: leaves.add y
+
+proc changedBy(c: Elim; n: PNode; e: Effects; loopVar: PSym): bool =
+  ## Whether the effects `e` can change the value of `n`; the writes of
+  ## `loopVar` do not count.
+  if n.kind == nkSym:
+    let s = n.sym
+    result = s != loopVar and (s in e.written or
+      e.opaque and (isVarParam(s) or s.id in c.exposed))
+  else:
+    result = false
+    for x in n:
+      if changedBy(c, x, e, loopVar): return true
+
+proc addCond(c: var Elim; n: PNode) =
+  if n.getMagic == mAnd:
+    addCond(c, n[1])
+    addCond(c, n[2])
+  elif admissible(c, n):
+    addFact(c.m, n)
+
+proc addCondNeg(c: var Elim; n: PNode) =
+  if admissible(c, n): addFactNeg(c.m, n)
+
+# ---------------- queries ----------------
+
+proc isProven(c: Elim; a, b: PNode): bool {.inline.} =
+  proveLe(c.m, a, b) == impYes
+
+proc indexInRange(c: Elim; n: PNode): bool =
+  let arr = n[0]
+  let idx = n[1]
+  result = letsAreStable(c, arr) and letsAreStable(c, idx) and
+    isProven(c, lowBound(c.g.config, arr), idx) and
+    isProven(c, idx, highBound(c.g.config, arr, c.g.operators))
+
+proc noOverflow(c: Elim; x: PNode; t: PType; delta: BiggestInt): bool =
+  ## Whether `x + delta` stays in the range of `t`.
+  if delta == 0 or not letsAreStable(c, x): return delta == 0
+  let first = toInt64(firstOrd(c.g.config, t))
+  let last = toInt64(lastOrd(c.g.config, t))
+  if delta > 0:
+    let bound = last - delta
+    if bound < first: return false
+    if isProven(c, x, newIntNode(nkIntLit, bound)): return true
+    if t.skipTypes(abstractRange).kind in {tyInt, tyInt64}:
+      # x <= y.len + d  with  d + delta <= 0, as a length is at most high(int)
+      for f in c.m.s:
+        if f != nil and f.getMagic == mLeI:
+          let y = f[2]
+          if y.getMagic == mAddI and y[1].getMagic in {mLengthOpenArray..mLengthSeq} and
+              y[2].kind in {nkCharLit..nkInt64Lit} and y[2].intVal <= -delta and
+              isProven(c, x, f[1]):
+            return true
+    result = false
+  else:
+    let bound = first - delta
+    if bound > last: return false
+    result = isProven(c, newIntNode(nkIntLit, bound), x)
+
+proc arithInRange(c: Elim; n: PNode): bool =
+  let t = n.typ.skipTypes(abstractRange)
+  if not isSignedInt(t): return false
+  var x = n[1]
+  var k = n[2]
+  if n.getMagic in {mAddI, mSucc} and x.kind in {nkCharLit..nkInt64Lit}: swap x, k
+  if k.kind notin {nkCharLit..nkInt64Lit} or k.intVal == low(BiggestInt): return false
+  let delta = if n.getMagic in {mAddI, mSucc}: k.intVal else: -k.intVal
+  result = noOverflow(c, x, t, delta)
+
+proc incInRange(c: Elim; n: PNode): bool =
+  let t = n[1].typ.skipTypes({tyGenericInst, tyAlias, tySink, tyVar, tyLent, tyDistinct})
+  if not isSignedInt(t) or t.kind == tyRange or n.len < 3: return false
+  let k = n[2]
+  if k.kind notin {nkCharLit..nkInt64Lit} or k.intVal == low(BiggestInt): return false
+  let delta = if n.getMagic == mInc: k.intVal else: -k.intVal
+  result = noOverflow(c, n[1], t, delta)
+
+proc isCheckedIndex(n: PNode): bool =
+  n.kind == nkBracketExpr and n.len == 2 and n[0].typ != nil and
+    n[0].typ.skipTypes(abstractVarRange).kind in
+      {tyArray, tyOpenArray, tyVarargs, tySequence, tyString}
+
+proc prove(c: var Elim; n: PNode) =
+  ## Marks the checks in `n` that the current facts prove redundant.
+  case n.kind
+  of nkNone..nkNilLit, NestedDefs: return
+  of nkBracketExpr:
+    if isCheckedIndex(n) and optBoundsCheck in c.prc.options and
+        not (n[0].typ.skipTypes(abstractVarRange).kind == tyArray and isConstExpr(n[1])):
+      inc c.indexChecks
+      if nfNoCheck in n.flags or indexInRange(c, n):
+        n.flags.incl nfNoCheck
+        inc c.indexElided
+  of nkCallKinds:
+    let m = n.getMagic
+    if m in {mAddI, mSubI, mSucc, mPred} and n.len == 3 and
+        optOverflowCheck in c.prc.options and isSignedInt(n.typ):
+      inc c.overflowChecks
+      if arithInRange(c, n):
+        n.flags.incl nfNoCheck
+        inc c.overflowElided
+  else: discard
+  for x in n: prove(c, x)
+
+proc proveIncDec(c: var Elim; n: PNode) =
+  ## `inc x` is checked against the value of `x` before the statement.
+  if n.kind in nkCallKinds and n.getMagic in {mInc, mDec} and
+      optOverflowCheck in c.prc.options:
+    let t = n[1].typ.skipTypes({tyGenericInst, tyAlias, tySink, tyVar, tyLent, tyDistinct})
+    if isSignedInt(t):
+      inc c.overflowChecks
+      if incInRange(c, n):
+        n.flags.incl nfNoCheck
+        inc c.overflowElided
+
+# ---------------- hoisting ----------------
+
+proc simpleBound(c: Elim; n: PNode; written: seq[PSym]): bool =
+  ## `n` can be evaluated again in front of the loop.
+  case n.kind
+  of nkCharLit..nkInt64Lit: result = true
+  of nkSym: result = admissible(c, n) and n.sym notin written
+  of nkHiddenStdConv, nkHiddenSubConv, nkConv:
+    result = isSignedInt(n.typ) and simpleBound(c, n[1], written)
+  of nkHiddenDeref: result = false
+  of nkCallKinds:
+    result = n.len == 2 and n.getMagic in {mLengthOpenArray..mLengthSeq} and
+      rootSym(n[1]) != nil and simpleBound(c, n[1].skipHidden, written)
+  else: result = false
+
+proc unconditionalIndexes(n: PNode; loopVar: PSym; res: var seq[PNode]) =
+  ## The accesses `a[loopVar]` that are evaluated whenever `n` is.
+  case n.kind
+  of nkBracketExpr:
+    if isCheckedIndex(n) and n[1].skipHidden.kind == nkSym and
+        n[1].skipHidden.sym == loopVar and nfNoCheck notin n.flags:
+      res.add n
+    for x in n: unconditionalIndexes(x, loopVar, res)
+  of nkCallKinds:
+    if n.getMagic notin {mAnd, mOr}:
+      for x in n: unconditionalIndexes(x, loopVar, res)
+  of nkAsgn, nkFastAsgn, nkSinkAsgn, nkDiscardStmt, nkHiddenStdConv,
+      nkHiddenSubConv, nkConv, nkHiddenDeref, nkHiddenAddr, nkDotExpr,
+      nkCheckedFieldExpr, nkVarSection, nkLetSection, nkIdentDefs:
+    for x in n: unconditionalIndexes(x, loopVar, res)
+  of nkStmtList:
+    # every statement of a loop body without control flow is executed
+    for x in n: unconditionalIndexes(x, loopVar, res)
+  else: discard
+
+proc checkedAccess(c: Elim; access, idx: PNode): PNode =
+  newTreeI(nkDiscardStmt, idx.info,
+    newTreeIT(nkBracketExpr, idx.info, access.typ, copyTree(access[0]), copyTree(idx)))
+
+proc hoistChecks(c: var Elim; n: PNode; e: Effects; exclusive, allowed: bool): PNode =
+  ## Returns the checks to put in front of the loop `n`, or nil.
+  result = nil
+  let iterCall = n[^2]
+  let loopVar = n[0]
+  if not allowed or e.impure or n.len != 3 or loopVar.kind != nkSym or
+      loopVar.sym.typ.skipTypes(abstractRange).kind != tyInt:
+    return
+  let lo = iterCall[1]
+  let hi = iterCall[2]
+  if not (simpleBound(c, lo, e.written) and simpleBound(c, hi, e.written) and
+      lo.typ.skipTypes(abstractRange).kind == tyInt and
+      hi.typ.skipTypes(abstractRange).kind == tyInt):
+    return
+  var candidates: seq[PNode] = @[]
+  unconditionalIndexes(n[^1], loopVar.sym, candidates)
+  var arrays: seq[PNode] = @[]
+  for x in candidates:
+    let root = rootSym(x[0])
+    if root != nil and x[0].skipHidden.kind in {nkSym, nkHiddenDeref} and
+        admissible(c, x[0].skipConv) and root notin e.written and
+        not indexInRange(c, x):
+      var seen = false
+      for a in arrays:
+        if guards.sameTree(a[0], x[0]): seen = true
+      if not seen: arrays.add x
+  if arrays.len == 0: return
+  c.wantsHoist = true
+  if not c.hoist: return
+
+  let g = c.g
+  let info = n.info
+  let intType = getSysType(g, info, tyInt)
+  let last =
+    if exclusive:
+      let x = newTreeIT(nkCall, info, intType,
+        newSymNode(getSysMagic(g, info, "-", mSubI)), copyTree(hi), newIntLit(g, info, 1))
+      x.flags.incl nfNoCheck # the loop runs, so `hi > lo`
+      x
+    else:
+      copyTree(hi)
+  let cond = newTreeIT(nkCall, info, getSysType(g, info, tyBool),
+    newSymNode(if exclusive: getSysMagic(g, info, "<", mLtI)
+               else: getSysMagic(g, info, "<=", mLeI)),
+    copyTree(lo), copyTree(hi))
+  let checks = newNodeI(nkStmtList, info)
+  for a in arrays:
+    checks.add checkedAccess(c, a, lo)
+    checks.add checkedAccess(c, a, last)
+    addFactLe(c.m, lowBound(g.config, a[0]), lo)
+    addFactLe(c.m, last, highBound(g.config, a[0], g.operators))
+    inc c.hoisted
+  result = newTreeI(nkIfStmt, info, newTreeI(nkElifBranch, info, cond, checks))
+
+# ---------------- statements ----------------
+
+proc walk(c: var Elim; n: PNode)
+
+proc simple(c: var Elim; n: PNode) =
+  var e = Effects()
+  var top = Effects()
+  case n.kind
+  of nkAsgn, nkFastAsgn, nkSinkAsgn:
+    addWrite(top, n[0])
+    effects(n[0], e)
+    effects(n[1], e)
+  of nkCallKinds:
+    let t = if n[0].typ != nil: n[0].typ.skipTypes(abstractInst) else: nil
+    for i in 1..<n.len:
+      if isVarFormal(t, i): addWrite(top, n[i])
+      effects(n[i], e)
+    top.opaque = n.getMagic == mNone
+    effects(n[0], e)
+  of nkVarSection, nkLetSection:
+    for it in n:
+      if it.kind in {nkIdentDefs, nkVarTuple}:
+        for i in 0..<it.len-2: addWrite(top, it[i])
+        effects(it[^1], e)
+  else:
+    effects(n, e)
+  # the arguments are evaluated before the assignment or call itself
+  invalidate(c, e)
+  proveIncDec(c, n)
+  prove(c, n)
+  invalidate(c, top)
+
+proc walkLoop(c: var Elim; n: PNode; allowHoist: bool): PNode =
+  ## Walks the loop `n`; returns the checks to put in front of it or nil.
+  result = nil
+  var e = Effects()
+  effects(n, e)
+  if n.kind == nkWhileStmt:
+    invalidate(c, e)
+    prove(c, n[0])
+    let base = c.m.s.len
+    addCond(c, n[0]) # re-established in every iteration
+    walk(c, n[1])
+    c.m.s.setLen(base)
+  else:
+    let iterCall = n[^2]
+    for i in 1..<iterCall.safeLen: simple(c, iterCall[i])
+    invalidate(c, e)
+    let base = c.m.s.len
+    if n.len == 3 and n[0].kind == nkSym and isSignedInt(n[0].typ) and
+        iterCall.kind in nkCallKinds and iterCall[0].kind == nkSym and
+        fromSystem(iterCall[0].sym) and iterCall.len >= 3:
+      let i = n[0]
+      let a = iterCall[1]
+      let b = iterCall[2]
+      # `lo` and `hi` are only evaluated once: the facts about them hold in
+      # every iteration unless the loop changes what they mention
+      if admissible(c, a) and admissible(c, b) and
+          not changedBy(c, a, e, i.sym) and not changedBy(c, b, e, i.sym):
+        case iterCall[0].sym.name.s
+        of "..", "countup":
+          addFactLe(c.m, a, i)
+          addFactLe(c.m, i, b)
+          let step = if iterCall.len > 3: iterCall[3] else: nil
+          if step == nil or (step.kind == nkIntLit and step.intVal == 1):
+            result = hoistChecks(c, n, e, exclusive = false, allowHoist)
+        of "..<":
+          addFactLe(c.m, a, i)
+          addFactLt(c.m, i, b)
+          result = hoistChecks(c, n, e, exclusive = true, allowHoist)
+        of "countdown":
+          addFactLe(c.m, b, i)
+          addFactLe(c.m, i, a)
+        else: discard
+    walk(c, n[^1])
+    c.m.s.setLen(base)
+
+proc walk(c: var Elim; n: PNode) =
+  case n.kind
+  of nkNone..nkNilLit, NestedDefs, nkCommentStmt, nkPragma, nkMixinStmt,
+      nkBindStmt, nkIncludeStmt, nkImportStmt, nkExportStmt, nkFromStmt,
+      nkImportExceptStmt, nkExportExceptStmt:
+    discard
+  of nkStmtList:
+    for i in 0..<n.len:
+      if n[i].kind in {nkWhileStmt, nkForStmt}:
+        let checks = walkLoop(c, n[i], allowHoist = true)
+        if checks != nil:
+          n[i] = newTreeI(nkStmtList, n[i].info, checks, n[i])
+      else:
+        walk(c, n[i])
+  of nkWhileStmt, nkForStmt:
+    # no place for checks in front of the loop
+    discard walkLoop(c, n, allowHoist = false)
+  of nkIfStmt:
+    let base = c.m.s.len
+    for branch in n:
+      if branch.kind == nkElifBranch:
+        simple(c, branch[0])
+        let here = c.m.s.len
+        addCond(c, branch[0])
+        walk(c, branch[1])
+        c.m.s.setLen(here)
+        addCondNeg(c, branch[0])
+      else:
+        walk(c, branch[0])
+    c.m.s.setLen(base)
+  of nkCaseStmt:
+    simple(c, n[0])
+    for i in 1..<n.len:
+      if n[i].kind == nkElifBranch: simple(c, n[i][0])
+      walk(c, n[i][^1])
+  of nkBlockStmt:
+    walk(c, n[1])
+  of nkPragmaBlock:
+    walk(c, n[1])
+  of nkTryStmt, nkHiddenTryStmt:
+    # an `except` or `finally` can be entered from anywhere in the body and
+    # from the other branches: it only knows the facts from before the
+    # statement that none of them invalidates
+    let base = c.m.s.len
+    for x in n:
+      var e = Effects()
+      effects(x, e)
+      walk(c, if x.kind in {nkExceptBranch, nkFinally}: x[^1] else: x)
+      c.m.s.setLen(base)
+      invalidate(c, e)
+  of nkDefer:
+    # runs at the end of the scope; forget what it writes right away
+    var e = Effects()
+    effects(n, e)
+    invalidate(c, e)
+  else:
+    simple(c, n)
+
+proc analyse(c: var Elim; body: PNode) =
+  c.m = TModel(s: @[], g: c.g, beSmart: true)
+  c.indexChecks = 0
+  c.indexElided = 0
+  c.overflowChecks = 0
+  c.overflowElided = 0
+  c.hoisted = 0
+  walk(c, body)
+
+proc elimChecks*(g: ModuleGraph; prc: PSym; body: PNode): PNode =
+  ## Returns a copy of `body` in which the index and overflow checks of `prc`
+  ## that cannot fail are marked and, where possible, moved in front of
+  ## loops. `body` itself is not changed.
+  result = body
+  if {optBoundsCheck, optOverflowCheck} * prc.options == {} or
+      prc.kind in {skIterator, skMacro, skTemplate} or
+      sfCompileTime in prc.flags or body.kind == nkEmpty:
+    return
+  var c = Elim(g: g, prc: prc, written: initIntSet(), unstable: initIntSet(),
+               exposed: initIntSet())
+  var e = Effects()
+  effects(body, e)
+  for s in e.written: c.written.incl s.id
+  scan(c, body, false)
+  # the original body is still used by macros and IC; only a copy gets the
+  # flags and the hoisted checks
+  result = copyTree(body)
+  analyse(c, result)
+  if c.wantsHoist:
+    result = copyTree(body)
+    c.hoist = true
+    analyse(c, result)
+  if c.indexElided + c.overflowElided > 0 and g.config.hasHint(hintChecksElided):
+    message(g.config, prc.info, hintChecksElided,
+      "'" & prc.name.s & "': removed " & $c.indexElided & " of " & $c.indexChecks &
+      " index checks (" & $c.hoisted & " hoisted out of loops) and " &
+      $c.overflowElided & " of " & $c.overflowChecks & " overflow checks")
@@ -364,6 +364,9 @@ proc testCompileOption*(conf: ConfigRef; switch: string, info: TLineInfo): bool
     result = false
   of "panics": result = contains(conf.globalOptions, optPanics)
   of "jsbigint64": result = contains(conf.globalOptions, optJsBigInt64)
+  of "unitybuild": result = contains(conf.globalOptions, optUnityBuild)
+  of "reorderfields": result = contains(conf.globalOptions, optReorderFields)
+  of "framepointers": result = contains(conf.globalOptions, optFramePointers)
   else:
     result = false
     invalidCmdLineOption(conf, passCmd1, switch, info)
@@ -746,7 +749,18 @@ proc processSwitch*(switch, arg: string, pass: TCmdLinePass, info: TLineInfo;
   of "threadanalysis":
     if conf.backend == backendJs: discard
     else: processOnOffSwitchG(conf, {optThreadAnalysis}, arg, pass, info)
-  of "stacktrace": processOnOffSwitch(conf, {optStackTrace}, arg, pass, info)
+  of "stacktrace":
+    if arg.normalize == "native":
+      # no frame bookkeeping in the generated code, the stack is walked
+      # and resolved through the `#line` directives when needed
+      conf.options.excl {optStackTrace, optLineTrace}
+      conf.options.incl optLineDir
+      conf.globalOptions.incl optNativeStackTrace
+      defineSymbol(conf.symbols, "nimNativeStackTraces")
+    else:
+      conf.globalOptions.excl optNativeStackTrace
+      undefSymbol(conf.symbols, "nimNativeStackTraces")
+      processOnOffSwitch(conf, {optStackTrace}, arg, pass, info)
   of "stacktracemsgs": processOnOffSwitch(conf, {optStackTraceMsgs}, arg, pass, info)
   of "excessivestacktrace": processOnOffSwitchG(conf, {optExcessiveStackTrace}, arg, pass, info)
   of "linetrace": processOnOffSwitch(conf, {optLineTrace}, arg, pass, info)
@@ -951,6 +965,17 @@ proc processSwitch*(switch, arg: string, pass: TCmdLinePass, info: TLineInfo;
     var value: int = 0
     discard parseSaturatedNatural(arg, value)
     conf.numberOfProcessors = value
+  of "unitybuild":
+    processOnOffSwitchG(conf, {optUnityBuild}, arg, pass, info)
+  of "unityshards":
+    expectArg(conf, switch, arg, pass, info)
+    var value: int = 0
+    discard parseSaturatedNatural(arg, value)
+    conf.unityShards = value
+  of "reorderfields":
+    processOnOffSwitchG(conf, {optReorderFields}, arg, pass, info)
+  of "framepointers":
+    processOnOffSwitchG(conf, {optFramePointers}, arg, pass, info)
   of "version", "v":
     expectNoArg(conf, switch, arg, pass, info)
     writeVersionInfo(conf, pass)
@@ -1134,6 +1159,10 @@ proc processSwitch*(switch, arg: string, pass: TCmdLinePass, info: TLineInfo;
     processOnOffSwitchG(conf, {optBenchmarkVM}, arg, pass, info)
   of "profilevm":
     processOnOffSwitchG(conf, {optProfileVM}, arg, pass, info)
+  of "tracetimeline":
+    expectArg(conf, switch, arg, pass, info)
+    conf.timeline = Timeline(
+      file: AbsoluteFile processPath(conf, arg, info, notRelativeToProj=true).string)
   of "sinkinference":
     processOnOffSwitch(conf, {optSinkInference}, arg, pass, info)
   of "cursorinference":
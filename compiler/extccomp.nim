@@ -12,7 +12,8 @@
 # from a lineinfos file, to provide generalized procedures to compile
 # nim files.
 
-import ropes, platform, condsyms, options, msgs, lineinfos, pathutils, modulepaths
+import ropes, platform, condsyms, options, msgs, lineinfos, pathutils, modulepaths,
+  timeline
 
 import std/[os, osproc, streams, sequtils, times, strtabs, json, jsonutils, sugar, parseutils]
 
@@ -429,7 +430,11 @@ proc addExternalFileToLink*(conf: ConfigRef; filename: AbsoluteFile) =
 
 proc execWithEcho(conf: ConfigRef; cmd: string, msg = hintExecuting): int =
   rawMessage(conf, msg, if msg == hintLinking and not(optListCmd in conf.globalOptions or conf.verbosity > 1): "" else: cmd)
+  let start = timelineNow(conf)
   result = execCmd(cmd)
+  if start != 0:
+    addTimelineEvent(conf, if msg == hintLinking: "link" else: "process",
+                     commandName(cmd), start, cmd, lane = 1, always = true)
 
 proc execExternalProgram*(conf: ConfigRef; cmd: string, msg = hintExecuting) =
   if execWithEcho(conf, cmd, msg) != 0:
@@ -490,11 +495,26 @@ proc cFileSpecificOptions(conf: ConfigRef; nimname, fullNimFile: string): string
     let key = nimname & ".size"
     if existsConfigVar(conf, key): addOpt(result, getConfigVar(conf, key))
     else: addOpt(result, getOptSize(conf, conf.cCompiler))
+  if {optFramePointers, optNativeStackTrace} * conf.globalOptions != {} and
+      conf.cCompiler in {ccGcc, ccLLVM_Gcc, ccCLang, ccIcc, ccNintendoSwitch}:
+    # after the optimization flags, `-O2` implies `-fomit-frame-pointer`
+    addOpt(result, "-fno-omit-frame-pointer")
+    if optNativeStackTrace in conf.globalOptions and optCDebug notin conf.globalOptions:
+      # the line tables without the rest of the debug information
+      addOpt(result, "-g1")
   let key = nimname & ".always"
   if existsConfigVar(conf, key): addOpt(result, getConfigVar(conf, key))
 
   addOpt(result, conf.cfileSpecificOptions.getOrDefault(fullNimFile))
 
+proc hasFileSpecificOptions*(conf: ConfigRef; cfile: Cfile): bool =
+  ## Whether `cfile` is compiled with options of its own, so that it cannot
+  ## be merged with other files.
+  result = conf.cfileSpecificOptions.hasKey(cfile.cname.changeFileExt("").string) or
+    cfile.customArgs != ""
+  for suffix in [".always", ".speed", ".size", ".debug"]:
+    if existsConfigVar(conf, cfile.nimname & suffix): result = true
+
 proc getCompileOptions(conf: ConfigRef): string =
   result = cFileSpecificOptions(conf, "__dummy__", "__dummy__")
 
@@ -817,7 +837,26 @@ proc execLinkCmd(conf: ConfigRef; linkCmd: string) =
     execExternalProgram(conf, linkCmd, hintLinking)
 
 proc execCmdsInParallel(conf: ConfigRef; cmds: seq[string]; prettyCb: proc (idx: int)) =
+  # for `--traceTimeline`: every running process gets its own lane
+  var starts = newSeq[int64](cmds.len)
+  var lanes = newSeq[int](cmds.len)
+  var busy: seq[bool] = @[]
+  let startCb = proc (idx: int) =
+    if conf.timeline != nil:
+      var lane = busy.find(false)
+      if lane < 0:
+        lane = busy.len
+        busy.add true
+      else:
+        busy[lane] = true
+      lanes[idx] = lane + 1
+      starts[idx] = timelineNow(conf)
+    prettyCb(idx)
   let runCb = proc (idx: int, p: Process) =
+    if conf.timeline != nil:
+      addTimelineEvent(conf, "process", commandName(cmds[idx]), starts[idx],
+                       cmds[idx], lanes[idx], always = true)
+      busy[lanes[idx] - 1] = false
     let exitCode = p.peekExitCode
     if exitCode != 0:
       rawMessage(conf, errGenerated, "execution of an external compiler program '" &
@@ -834,7 +873,7 @@ proc execCmdsInParallel(conf: ConfigRef; cmds: seq[string]; prettyCb: proc (idx:
   else:
     tryExceptOSErrorMessage(conf, "invocation of external compiler program failed."):
       res = execProcesses(cmds, {poStdErrToStdOut, poUsePath, poParentStreams},
-                            conf.numberOfProcessors, prettyCb, afterRunEvent=runCb)
+                            conf.numberOfProcessors, startCb, afterRunEvent=runCb)
   if res != 0:
     if conf.numberOfProcessors <= 1:
       rawMessage(conf, errGenerated, "execution of an external program failed: '$1'" %
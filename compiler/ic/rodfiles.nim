@@ -104,6 +104,7 @@ type
     sideChannelSection
     namespaceSection
     symnamesSection
+    macroExpansionSection # `.cacheMacro` expansions, stored in their own files
 
   RodFileError* = enum
     ok, tooBig, cannotOpen, ioFailure, wrongHeader, wrongSection, configMismatch,
@@ -17,7 +17,7 @@ import
   ast, astalgo, msgs, renderer, magicsys, types, idents,
   options, lowerings, modulegraphs,
   lineinfos, parampatterns, sighashes, liftdestructors, optimizer,
-  varpartitions, aliasanalysis, dfa, wordrecg
+  varpartitions, aliasanalysis, dfa, wordrecg, timeline
 
 import std/[strtabs, tables, strutils, intsets]
 
@@ -1255,17 +1255,18 @@ proc injectDestructorCalls*(g: ModuleGraph; idgen: IdGenerator; owner: PSym; n:
     computeCursors(owner, n, g)
 
   var scope = Scope(body: n)
-  let body = p(n, c, scope, normal)
-
-  if owner.kind in {skProc, skFunc, skMethod, skIterator, skConverter}:
-    let params = owner.typ.n
-    for i in 1..<params.len:
-      let t = params[i].sym.typ
-      if isSinkTypeForParam(t) and hasDestructor(c, t.skipTypes({tySink})):
-        scope.final.add c.genDestroy(params[i])
-  #if optNimV2 in c.graph.config.globalOptions:
-  #  injectDefaultCalls(n, c)
-  result = optimize processScope(c, scope, body)
+  traceTimeline(g.config, "injectdestructors", owner.name.s):
+    let body = p(n, c, scope, normal)
+
+    if owner.kind in {skProc, skFunc, skMethod, skIterator, skConverter}:
+      let params = owner.typ.n
+      for i in 1..<params.len:
+        let t = params[i].sym.typ
+        if isSinkTypeForParam(t) and hasDestructor(c, t.skipTypes({tySink})):
+          scope.final.add c.genDestroy(params[i])
+    #if optNimV2 in c.graph.config.globalOptions:
+    #  injectDefaultCalls(n, c)
+    result = optimize processScope(c, scope, body)
   dbg:
     echo ">---------transformed-to--------->"
     echo renderTree(result, {renderIds})
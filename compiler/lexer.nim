@@ -763,8 +763,9 @@ proc getString(L: var Lexer, tok: var Token, mode: StringMode) =
         L.bufpos = pos
         break
       else:
-        tok.literal.add(L.buf[pos])
-        inc(pos)
+        let last = scanUntil(L, pos, {'\"', CR, LF})
+        tok.literal.addChars(L.buf, pos, last)
+        pos = last
   else:
     # ordinary string literal
     if mode != normal: tok.tokType = tkRStrLit
@@ -788,8 +789,11 @@ proc getString(L: var Lexer, tok: var Token, mode: StringMode) =
         getEscapedChar(L, tok)
         pos = L.bufpos
       else:
-        tok.literal.add(c)
-        inc(pos)
+        let last =
+          if mode == normal: scanUntil(L, pos, {'\"', '\\', CR, LF})
+          else: scanUntil(L, pos, {'\"', CR, LF})
+        tok.literal.addChars(L.buf, pos, last)
+        pos = last
     L.bufpos = pos
 
 proc getCharacter(L: var Lexer; tok: var Token) =
@@ -1042,8 +1046,9 @@ proc skipMultiLineComment(L: var Lexer; tok: var Token; start: int;
       lexMessagePos(L, errGenerated, pos, "end of multiline comment expected")
       break
     else:
-      if isDoc or defined(nimpretty): tok.literal.add L.buf[pos]
-      inc(pos)
+      let last = scanUntil(L, pos, {'#', ']', CR, LF})
+      if isDoc or defined(nimpretty): tok.literal.addChars(L.buf, pos, last)
+      pos = last
   L.bufpos = pos
   when defined(nimpretty):
     tok.commentOffsetB = L.offsetBase + pos - 1
@@ -1073,9 +1078,9 @@ proc scanComment(L: var Lexer, tok: var Token) =
         toStrip = 0
       else:  # found first non-whitespace character
         stripInit = true
-    while L.buf[pos] notin {CR, LF, nimlexbase.EndOfFile}:
-      tok.literal.add(L.buf[pos])
-      inc(pos)
+    let last = scanUntil(L, pos, {CR, LF})
+    tok.literal.addChars(L.buf, pos, last)
+    pos = last
     tokenEndIgnore(tok, pos)
     pos = handleCRLF(L, pos)
     var indent = 0
@@ -1156,9 +1161,9 @@ proc skip(L: var Lexer, tok: var Token) =
         pos = L.bufpos
       else:
         tokenBegin(tok, pos)
-        while L.buf[pos] notin {CR, LF, nimlexbase.EndOfFile}:
-          when defined(nimpretty): tok.literal.add L.buf[pos]
-          inc(pos)
+        let last = scanUntil(L, pos, {CR, LF})
+        when defined(nimpretty): tok.literal.addChars(L.buf, pos, last)
+        pos = last
         tokenEndIgnore(tok, pos+1)
         when defined(nimpretty):
           tok.commentOffsetB = L.offsetBase + pos + 1
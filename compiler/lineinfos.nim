@@ -112,6 +112,11 @@ type
     hintUser = "User", hintUserRaw = "UserRaw", hintExtendedContext = "ExtendedContext",
     hintMsgOrigin = "MsgOrigin", # since 1.3.5
     hintDeclaredLoc = "DeclaredLoc", # since 1.5.1
+    hintCacheStats = "CacheStats", # since 2.3.1
+    hintChecksElided = "ChecksElided", # since 2.3.1
+    hintCodeFolding = "CodeFolding", # since 2.3.1
+    hintPadding = "Padding", # since 2.3.1
+    hintCyclicTypes = "CyclicTypes", # since 2.3.1
 
 const
   MsgKindToStr*: array[TMsgKind, string] = [
@@ -237,7 +242,12 @@ const
     hintUserRaw: "$1",
     hintExtendedContext: "$1",
     hintMsgOrigin: "$1",
-    hintDeclaredLoc: "$1"
+    hintDeclaredLoc: "$1",
+    hintCacheStats: "$1",
+    hintChecksElided: "$1",
+    hintCodeFolding: "$1",
+    hintPadding: "$1",
+    hintCyclicTypes: "$1"
   ]
 
 const
@@ -260,7 +270,9 @@ proc computeNotesVerbosity(): array[0..3, TNoteKinds] =
   result[2] = result[3] - {hintStackTrace, hintExtendedContext, hintDeclaredLoc, hintProcessingStmt}
   result[1] = result[2] - {warnProveField, warnProveIndex,
     warnGcUnsafe, hintPath, hintDependency, hintCodeBegin, hintCodeEnd,
-    hintSource, hintGlobalVar, hintGCStats, hintMsgOrigin, hintPerformance}
+    hintSource, hintGlobalVar, hintGCStats, hintMsgOrigin, hintPerformance,
+    hintCacheStats, hintChecksElided, hintCodeFolding, hintPadding,
+    hintCyclicTypes}
   result[0] = result[1] - {hintSuccessX, hintSuccess, hintConf,
     hintProcessing, hintPattern, hintExecuting, hintLinking, hintCC}
 
@@ -0,0 +1,333 @@
+#
+#
+#           The Nim Compiler
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+## A persistent cache for the expansions of macros that are marked as
+## `.cacheMacro`. Such a macro promises to be a pure function of its
+## arguments: the same macro implementation applied to the same arguments at
+## the same place always produces the same tree. The expansion is then stored
+## in the nimcache, in the rod file format used by IC, and the next build
+## reads it back instead of running the macro in the VM.
+##
+## Only expansions that are plain syntax are cached: every parameter of the
+## macro must be `untyped` and every argument and the result must consist of
+## identifiers and literals only. Trees that contain symbols or types refer to
+## state of the current compilation and are never stored. The key of an
+## expansion covers the implementation of the macro and of every routine,
+## constant and type it (transitively) refers to, the compiler version, the
+## call site and the arguments, all with their line information, so that a
+## cached tree is indistinguishable from a fresh one. A macro that reaches
+## compile-time state (global or `.compileTime` variables, `std/macrocache`,
+## `staticRead`, `staticExec`) is never cached.
+##
+## Expansion files that a successful build did not use are stale and removed
+## at the end of the build, see `evictExpansions`.
+
+import ast, options, msgs, lineinfos, pathutils, modulegraphs, idents,
+  nversion
+import ic / [packed_ast, bitabs, rodfiles, iclineinfos]
+import std/[tables, intsets, sets, os]
+
+when defined(nimPreviewSlimSystem):
+  import std/[assertions, syncio]
+
+import ../dist/checksums/src/checksums/sha1
+
+type
+  Hasher = object
+    conf: ConfigRef
+    g: ModuleGraph
+    buf: string
+    visited, visitedTypes: IntSet
+    cacheable: bool # false if the macro reaches compile-time state
+
+const
+  compileTimeStateMagics = {mNccValue, mNccInc, mNcsAdd, mNcsIncl, mNcsLen,
+    mNcsAt, mNctPut, mNctLen, mNctGet, mNctHasNext, mNctNext, mSlurp,
+    mStaticExec}
+
+proc addInfo(h: var Hasher; info: TLineInfo) =
+  if info.fileIndex.int32 >= 0:
+    h.buf.add toFullPath(h.conf, info.fileIndex)
+  h.buf.add ':'
+  h.buf.addInt info.line.int
+  h.buf.add ':'
+  h.buf.addInt info.col.int
+  h.buf.add ' '
+
+proc addSyntax(h: var Hasher; n: PNode): bool =
+  ## Adds the plain syntax tree `n`. Returns false if `n` is not plain
+  ## syntax.
+  if n == nil: return false
+  h.buf.addInt ord(n.kind)
+  h.buf.add ' '
+  h.addInfo n.info
+  if n.typ != nil: return false
+  case n.kind
+  of nkSym, nkType, nkNone: return false
+  of nkEmpty, nkNilLit: discard
+  of nkIdent: h.buf.add n.ident.s
+  of nkCharLit..nkUInt64Lit: h.buf.addInt n.intVal
+  of nkFloatLit..nkFloat128Lit: h.buf.addInt cast[BiggestInt](n.floatVal)
+  of nkStrLit..nkTripleStrLit:
+    h.buf.addInt n.strVal.len
+    h.buf.add ':'
+    h.buf.add n.strVal
+  else:
+    h.buf.add '('
+    for i in 0..<n.len:
+      if not h.addSyntax(n[i]): return false
+    h.buf.add ')'
+  h.buf.add ' '
+  result = true
+
+proc addImpl(h: var Hasher; s: PSym)
+proc addTree(h: var Hasher; n: PNode)
+
+proc addType(h: var Hasher; t: PType) =
+  ## Adds the structure of `t`: its kind, name, fields and element types.
+  if t == nil:
+    h.buf.add "nil "
+    return
+  h.buf.addInt ord(t.kind)
+  h.buf.add ' '
+  if t.sym != nil:
+    h.buf.add t.sym.name.s
+    h.buf.add ' '
+    h.addInfo t.sym.info
+  if containsOrIncl(h.visitedTypes, t.id): return
+  h.buf.add '('
+  h.addTree t.n
+  for k in t.kids: h.addType k
+  h.buf.add ')'
+
+  if n == nil:
+    h.buf.add "nil "
+    return
+  h.buf.addInt ord(n.kind)
+  h.buf.add ' '
+  h.addInfo n.info
+  case n.kind
+  of nkSym:
+    let s = n.sym
+    h.buf.add s.name.s
+    h.buf.add ' '
+    h.addInfo s.info
+    case s.kind
+    of skVar, skLet:
+      # locals of the macro and of its callees are fine, globals are state
+      # that the expansion would silently depend on
+      if {sfGlobal, sfCompileTime} * s.flags != {}: h.cacheable = false
+    of skType, skField, skEnumField:
+      h.buf.addInt s.position
+      h.addType s.typ
+    else:
+      h.addImpl s
+  of nkType: h.addType n.typ
+  of nkIdent: h.buf.add n.ident.s
+  of nkCharLit..nkUInt64Lit: h.buf.addInt n.intVal
+  of nkFloatLit..nkFloat128Lit: h.buf.addInt cast[BiggestInt](n.floatVal)
+  of nkStrLit..nkTripleStrLit:
+    h.buf.addInt n.strVal.len
+    h.buf.add ':'
+    h.buf.add n.strVal
+  of nkEmpty, nkNilLit, nkNone: discard
+  else:
+    h.buf.add '('
+    for i in 0..<n.len: h.addTree n[i]
+    h.buf.add ')'
+  h.buf.add ' '
+
+proc addImpl(h: var Hasher; s: PSym) =
+  if s.magic in compileTimeStateMagics: h.cacheable = false
+  if s.kind notin routineKinds + {skConst} or s.magic != mNone or
+      containsOrIncl(h.visited, s.id):
+    return
+  if s.kind == skConst:
+    h.addTree s.astdef
+  elif s.ast != nil:
+    for i in 0..<s.ast.len:
+      if i == bodyPos and s.ast[i] == nil: h.addTree getBody(h.g, s)
+      else: h.addTree s.ast[i]
+
+const uncacheable = "-" # `implHash` of a macro that reaches compile-time state
+
+proc implHash(g: ModuleGraph; s: PSym): string =
+  result = g.macroImplHashes.getOrDefault(s.id)
+  if result.len == 0:
+    var h = Hasher(conf: g.config, g: g, visited: initIntSet(),
+                   visitedTypes: initIntSet(), cacheable: true)
+    h.buf.add NimVersion & " " & CompileDate & " " & CompileTime & "\n"
+    h.addImpl s
+    result = if h.cacheable: $secureHash(h.buf) else: uncacheable
+    g.macroImplHashes[s.id] = result
+
+proc hasUntypedParams(s: PSym): bool =
+  result = true
+  for _, t in s.typ.paramTypes:
+    let p = if t.kind == tyVarargs: t.elementType else: t
+    if p.kind != tyUntyped: return false
+
+proc expansionKey*(g: ModuleGraph; s: PSym; n: PNode; key: var string): bool =
+  ## Computes the cache key of the expansion of the macro `s` for the call
+  ## `n`. Returns false if the call cannot be cached because the macro takes
+  ## typed arguments, reaches compile-time state or one of its arguments is
+  ## not plain syntax.
+  if not hasUntypedParams(s): return false
+  let impl = implHash(g, s)
+  if impl == uncacheable: return false
+  var h = Hasher(conf: g.config, g: g)
+  h.buf.add impl
+  h.buf.add '\n'
+  h.addInfo n.info
+  for i in 1..<n.len:
+    if not h.addSyntax(n[i]): return false
+  key = $secureHash(h.buf)
+  result = true
+
+proc expansionFile(conf: ConfigRef; key: string): string =
+  toGeneratedFile(conf, AbsoluteFile("macro_" & key), "rod").string
+
+proc evictExpansions*(g: ModuleGraph) =
+  ## Removes the expansion files in the nimcache that the current build did
+  ## neither load nor store. Their keys belong to macros, call sites or
+  ## arguments that no longer exist.
+  for path in walkFiles(getNimcacheDir(g.config).string / "macro_*.rod"):
+    if path notin g.macroExpansionsUsed:
+      try: removeFile(path)
+      except OSError: discard
+
+# ---------------- storing ----------------
+
+type
+  Encoder = object
+    conf: ConfigRef
+    strings: BiTable[string]
+    numbers: BiTable[BiggestInt]
+    man: LineInfoManager
+    tree: PackedTree
+
+proc toPackedInfo(e: var Encoder; info: TLineInfo): PackedLineInfo =
+  let file = if info.fileIndex.int32 >= 0: toFullPath(e.conf, info.fileIndex) else: ""
+  pack(e.man, e.strings.getOrIncl(file), info.line.int32, info.col.int32)
+
+proc pack(e: var Encoder; n: PNode): bool =
+  if n == nil:
+    e.tree.addNode(kind = nkNilRodNode, operand = 1, info = NoLineInfo)
+    return true
+  if n.typ != nil: return false
+  let info = e.toPackedInfo(n.info)
+  case n.kind
+  of nkSym, nkType, nkNone: return false
+  of nkEmpty, nkNilLit:
+    e.tree.addNode(kind = n.kind, flags = n.flags, operand = 0, info = info)
+  of nkIdent:
+    e.tree.addNode(kind = n.kind, flags = n.flags,
+                   operand = int32 e.strings.getOrIncl(n.ident.s), info = info)
+  of externIntLit:
+    e.tree.addNode(kind = n.kind, flags = n.flags,
+                   operand = int32 e.numbers.getOrIncl(n.intVal), info = info)
+  of nkStrLit..nkTripleStrLit:
+    e.tree.addNode(kind = n.kind, flags = n.flags,
+                   operand = int32 e.strings.getOrIncl(n.strVal), info = info)
+  of nkFloatLit..nkFloat128Lit:
+    e.tree.addNode(kind = n.kind, flags = n.flags,
+                   operand = int32 e.numbers.getOrIncl(cast[BiggestInt](n.floatVal)),
+                   info = info)
+  else:
+    let patchPos = e.tree.prepare(n.kind, n.flags, nilItemId, info)
+    for i in 0..<n.len:
+      if not e.pack(n[i]): return false
+    e.tree.patch patchPos
+  result = true
+
+proc storeExpansion*(g: ModuleGraph; key: string; n: PNode) =
+  ## Stores the expansion `n` under `key` if it is plain syntax.
+  var e = Encoder(conf: g.config, strings: initBiTable[string](),
+                  numbers: initBiTable[BiggestInt]())
+  if not e.pack(n): return
+  let filename = expansionFile(g.config, key)
+  g.macroExpansionsUsed.incl filename
+  let tmp = filename & ".tmp"
+  var f = rodfiles.create(tmp)
+  if f.err != ok: return
+  f.storeHeader()
+  f.storeSection macroExpansionSection
+  f.store e.strings
+  f.store e.numbers
+  f.store e.man
+  f.store e.tree
+  let err = f.err
+  close(f)
+  try:
+    # written under another name first so that a concurrent or interrupted
+    # build never reads a partial file
+    if err == ok: moveFile(tmp, filename)
+    else: removeFile(tmp)
+  except OSError:
+    discard
+
+# ---------------- loading ----------------
+
+type
+  Decoder = object
+    conf: ConfigRef
+    cache: IdentCache
+    strings: BiTable[string]
+    numbers: BiTable[BiggestInt]
+    man: LineInfoManager
+    files: Table[LitId, FileIndex]
+
+proc toLineInfo(d: var Decoder; x: PackedLineInfo): TLineInfo =
+  let (file, line, col) = unpack(d.man, x)
+  var fileIndex = d.files.getOrDefault(file, InvalidFileIdx)
+  if fileIndex == InvalidFileIdx:
+    let path = d.strings[file]
+    fileIndex = if path.len == 0: InvalidFileIdx
+                else: fileInfoIdx(d.conf, AbsoluteFile path)
+    d.files[file] = fileIndex
+  result = newLineInfo(fileIndex, line, col)
+
+proc unpack(d: var Decoder; tree: PackedTree; n: NodePos): PNode =
+  let k = n.kind
+  if k == nkNilRodNode:
+    return nil
+  result = newNodeI(k, d.toLineInfo(n.info))
+  result.flags = n.flags
+  case k
+  of nkEmpty, nkNilLit: discard
+  of nkIdent: result.ident = getIdent(d.cache, d.strings[n.litId])
+  of externIntLit: result.intVal = d.numbers[n.litId]
+  of nkStrLit..nkTripleStrLit: result.strVal = d.strings[n.litId]
+  of nkFloatLit..nkFloat128Lit:
+    result.floatVal = cast[BiggestFloat](d.numbers[n.litId])
+  else:
+    for n0 in sonsReadonly(tree, n):
+      result.addAllowNil d.unpack(tree, n0)
+
+proc loadExpansion*(g: ModuleGraph; key: string): PNode =
+  ## Returns the expansion stored under `key` or nil.
+  result = nil
+  if optForceFullMake in g.config.globalOptions: return
+  let filename = expansionFile(g.config, key)
+  if not fileExists(filename): return
+  var f = rodfiles.open(filename)
+  if f.err != ok: return
+  var d = Decoder(conf: g.config, cache: g.cache)
+  var tree = PackedTree()
+  f.loadHeader()
+  f.loadSection macroExpansionSection
+  f.load d.strings
+  f.load d.numbers
+  f.load d.man
+  f.load tree
+  let err = f.err
+  close(f)
+  if err == ok and tree.len > 0:
+    result = d.unpack(tree, NodePos 0)
+    g.macroExpansionsUsed.incl filename
@@ -20,7 +20,7 @@ import
   cgen, nversion,
   platform, nimconf, depends,
   modules,
-  modulegraphs, lineinfos, pathutils, vmprofiler
+  modulegraphs, lineinfos, pathutils, vmprofiler, timeline, macroexpcache
 
 
 when defined(nimPreviewSlimSystem):
@@ -429,7 +429,12 @@ proc mainCommand*(graph: ModuleGraph) =
   if conf.errorCounter == 0 and conf.cmd notin {cmdTcc, cmdDump, cmdNop}:
     if optProfileVM in conf.globalOptions:
       echo conf.dump(conf.vmProfileData)
+    if conf.hasHint(hintCacheStats):
+      rawMessage(conf, hintCacheStats, instCacheStatsReport(graph))
+    if conf.cmd in cmdBackends:
+      evictExpansions(graph)
     genSuccessX(conf)
+  writeTimeline(conf)
 
   when PrintRopeCacheStats:
     echo "rope cache stats: "
@@ -11,7 +11,7 @@
 ## represents a complete Nim project. Single modules can either be kept in RAM
 ## or stored in a rod-file.
 
-import std/[intsets, tables, hashes, strtabs, algorithm, os, strutils, parseutils]
+import std/[intsets, sets, tables, hashes, strtabs, algorithm, os, strutils, parseutils, times, monotimes]
 import ../dist/checksums/src/checksums/md5
 import ast, astalgo, options, lineinfos,idents, btrees, ropes, msgs, pathutils, packages, suggestsymdb
 import ic / [packed_ast, ic]
@@ -55,6 +55,21 @@ type
     concreteTypes*: seq[FullId]
     inst*: PInstantiation
 
+  InstIndex* = object
+    ## Hash index over the cached instantiations of one generic symbol.
+    ## Holds positions into `typeInstCache` or `procInstCache`.
+    byHash: Table[Hash, seq[int]] # sorted positions per hash
+    unhashed: seq[int] # sorted positions that could not be hashed (yet)
+    indexed: int # positions below this one are in the index
+
+  InstCacheStats* = object
+    typeHits*, typeMisses*, procHits*, procMisses*: int
+    compared*: int # candidates that had to be compared structurally
+    duplicates*: int # type instances equal to one that was already cached
+    lookupTime*: Duration
+    overloadHits*, overloadMisses*: int # see `semcall.pickBestCandidate`
+    macroHits*, macroMisses*: int # see `macroexpcache`
+
   PipelinePass* = enum
     NonePass
     SemPass
@@ -74,6 +89,11 @@ type
 
     typeInstCache*: Table[ItemId, seq[LazyType]] # A symbol's ItemId.
     procInstCache*: Table[ItemId, seq[LazyInstantiation]] # A symbol's ItemId.
+    typeInstIndex: Table[ItemId, InstIndex] # built lazily from typeInstCache
+    procInstIndex: Table[ItemId, InstIndex] # built lazily from procInstCache
+    instCacheStats*: InstCacheStats
+    macroImplHashes*: Table[int, string] # symbol id of a `.cacheMacro` -> hash of its implementation
+    macroExpansionsUsed*: HashSet[string] # expansion files loaded or stored by this build
     attachedOps*: array[TTypeAttachedOp, Table[ItemId, LazySym]] # Type ID, destructors, etc.
     methodsPerGenericType*: Table[ItemId, seq[(int, LazySym)]] # Type ID, attached methods
     memberProcsPerType*: Table[ItemId, seq[PSym]] # Type ID, attached member procs (only c++, virtual,member and ctor so far).
@@ -153,6 +173,8 @@ proc resetForBackend*(g: ModuleGraph) =
   g.compilerprocs = initStrTable()
   g.typeInstCache.clear()
   g.procInstCache.clear()
+  g.typeInstIndex.clear()
+  g.procInstIndex.clear()
   for a in mitems(g.attachedOps):
     a.clear()
   g.methodsPerGenericType.clear()
@@ -348,6 +370,89 @@ iterator procInstCacheItems*(g: ModuleGraph; s: PSym): PInstantiation =
     for t in mitems(x[]):
       yield resolveInst(g, t)
 
+proc insertSorted(s: var seq[int]; x: int) =
+  s.insert(x, s.lowerBound(x))
+
+template indexedCandidates(g: ModuleGraph; instCache, instIndex: untyped; s: PSym;
+                           key: untyped; hashOf, resolve: untyped) =
+  # Brings the index of `s` up to date and yields the entries whose hash
+  # matches the one of `key`, plus the ones that cannot be hashed, in the
+  # order in which they were added to the cache.
+  if g.instCache.contains(s.itemId):
+    let items = addr(g.instCache[s.itemId])
+    let ix = addr(g.instIndex.mgetOrPut(s.itemId, InstIndex()))
+    while ix.indexed < items[].len:
+      var h: Hash = 0
+      if hashOf(resolve(g, items[][ix.indexed]), h):
+        ix.byHash.mgetOrPut(h, @[]).add ix.indexed
+      else:
+        ix.unhashed.add ix.indexed
+      inc ix.indexed
+    var keyHash: Hash = 0
+    if not hashOf(key, keyHash):
+      for i in 0..<items[].len:
+        yield resolve(g, items[][i])
+    else:
+      # incomplete entries may have become hashable in the meantime:
+      var i = 0
+      while i < ix.unhashed.len:
+        var h: Hash = 0
+        if hashOf(resolve(g, items[][ix.unhashed[i]]), h):
+          ix.byHash.mgetOrPut(h, @[]).insertSorted ix.unhashed[i]
+          ix.unhashed.delete i
+        else:
+          inc i
+      let bucket = ix.byHash.getOrDefault(keyHash)
+      let unhashed = ix.unhashed
+      var a = 0
+      var b = 0
+      while a < bucket.len or b < unhashed.len:
+        if b >= unhashed.len or (a < bucket.len and bucket[a] < unhashed[b]):
+          yield resolve(g, items[][bucket[a]])
+          inc a
+        else:
+          yield resolve(g, items[][unhashed[b]])
+          inc b
+
+iterator typeInstCandidates*(g: ModuleGraph; s: PSym; key: PType;
+    hashOf: proc (t: PType; h: var Hash): bool {.nimcall.}): PType =
+  ## Like `typeInstCacheItems` but only yields the instantiations that can
+  ## be equal to `key`. `hashOf` must produce the same hash for types that
+  ## are equal and return false for types it cannot hash.
+  indexedCandidates(g, typeInstCache, typeInstIndex, s, key, hashOf, resolveType)
+
+iterator procInstCandidates*(g: ModuleGraph; s: PSym; key: PInstantiation;
+    hashOf: proc (inst: PInstantiation; h: var Hash): bool {.nimcall.}): PInstantiation =
+  ## Like `procInstCacheItems` but only yields the instantiations that can
+  ## be equal to `key`, see `typeInstCandidates`.
+  indexedCandidates(g, procInstCache, procInstIndex, s, key, hashOf, resolveInst)
+
+template measureInstLookup*(g: ModuleGraph; hits, misses: untyped;
+                            lookup: untyped): untyped =
+  ## Evaluates `lookup` and, if the `CacheStats` hint is enabled, records
+  ## its outcome and duration in `g.instCacheStats`.
+  if g.config.hasHint(hintCacheStats):
+    let start = getMonoTime()
+    let res = lookup
+    g.instCacheStats.lookupTime += getMonoTime() - start
+    if res != nil: inc g.instCacheStats.hits
+    else: inc g.instCacheStats.misses
+    res
+  else:
+    lookup
+
+proc instCacheStatsReport*(g: ModuleGraph): string =
+  let st = g.instCacheStats
+  result = "generic instantiation caches: types: " & $st.typeHits & " hits, " &
+    $st.typeMisses & " misses; procs: " & $st.procHits & " hits, " &
+    $st.procMisses & " misses; " & $st.compared & " structural comparisons; " &
+    $st.duplicates & " duplicate types; " &
+    formatFloat(st.lookupTime.inNanoseconds.float / 1e9, ffDecimal, 3) & "s in lookups\n" &
+    "overload resolution memo: " & $st.overloadHits & " hits, " &
+    $st.overloadMisses & " misses\n" &
+    "macro expansion cache: " & $st.macroHits & " hits, " &
+    $st.macroMisses & " misses"
+
 
 proc getAttachedOp*(g: ModuleGraph; t: PType; op: TTypeAttachedOp): PSym =
   ## returns the requested attached operation for type `t`. Can return nil
@@ -17,7 +17,10 @@ import llstream
 import std/strutils
 
 when defined(nimPreviewSlimSystem):
-  import std/assertions
+  import std/[assertions, syncio]
+
+when defined(posix):
+  import std/posix
 
 const
   Lrz* = ' '
@@ -52,6 +55,8 @@ type
     sentinel*: int
     lineStart*: int           # index of last line start in buffer
     offsetBase*: int          # use ``offsetBase + bufpos`` to get the offset
+    mapped: pointer           # `buf` is a mapping of the file, see `openBaseLexer`
+    mappedLen: int
 
 
 proc openBaseLexer*(L: var TBaseLexer, inputstream: PLLStream,
@@ -71,6 +76,11 @@ proc handleLF*(L: var TBaseLexer, pos: int): int
 # implementation
 
 proc closeBaseLexer(L: var TBaseLexer) =
+  when defined(posix):
+    if L.mapped != nil:
+      discard munmap(L.mapped, L.mappedLen)
+      L.mapped = nil
+      L.buf = nil
   llStreamClose(L.stream)
 
 proc fillBuffer(L: var TBaseLexer) =
@@ -146,18 +156,58 @@ proc skipUTF8BOM(L: var TBaseLexer) =
     inc(L.bufpos, 3)
     inc(L.lineStart, 3)
 
+proc remainingInput(s: PLLStream): int =
+  ## The number of bytes left in `s`, or -1 if that cannot be known.
+  result = -1
+  case s.kind
+  of llsString: result = s.s.len - s.rd
+  of llsFile:
+    try:
+      result = int(getFileSize(s.f) - getFilePos(s.f))
+    except IOError:
+      discard
+  of llsNone, llsStdIn: discard
+
+const
+  mapThreshold = 64 * 1024 # smaller files are cheaper to read
+
+proc tryMap(L: var TBaseLexer, size: int): bool =
+  ## Maps the file read by `L.stream` into memory. Only done if the bytes
+  ## after the file's end on its last page are there and zero: they
+  ## provide the `EndOfFile` marker.
+  result = false
+  when defined(posix):
+    let pageSize = int(sysconf(SC_PAGESIZE))
+    if L.stream.kind == llsFile and size >= mapThreshold and pageSize > 0 and
+        size mod pageSize != 0 and getFilePos(L.stream.f) == 0:
+      let p = mmap(nil, size, PROT_READ, MAP_PRIVATE,
+                   getFileHandle(L.stream.f), 0)
+      if p != MAP_FAILED:
+        L.mapped = p
+        L.mappedLen = size
+        L.buf = cast[cstring](p)
+        L.bufLen = size + 1
+        L.sentinel = size
+        result = true
+
 proc openBaseLexer(L: var TBaseLexer, inputstream: PLLStream, bufLen = 8192) =
   assert(bufLen > 0)
   L.bufpos = 0
   L.offsetBase = 0
-  L.bufStorage = newString(bufLen)
-  L.buf = L.bufStorage.cstring
-  L.bufLen = bufLen
-  L.sentinel = bufLen - 1
   L.lineStart = 0
   L.lineNumber = 1            # lines start at 1
   L.stream = inputstream
-  fillBuffer(L)
+  L.mapped = nil
+  # Files and strings are read in one go: the buffer then never needs to be
+  # refilled and the scanners below can look at whole words.
+  let size = remainingInput(inputstream)
+  if size < 0 or not tryMap(L, size):
+    let bufLen = max(bufLen, size + 1)
+    L.bufStorage = newString(bufLen)
+    L.buf = L.bufStorage.cstring
+    L.bufLen = bufLen
+    L.sentinel = bufLen - 1
+    fillBuffer(L)
   skipUTF8BOM(L)
 
 proc getColNumber(L: TBaseLexer, pos: int): int =
@@ -172,3 +222,37 @@ proc getCurrentLine(L: TBaseLexer, marker: bool = true): string =
   result.add "\n"
   if marker:
     result.add spaces(getColNumber(L, L.bufpos)) & '^' & "\n"
+
+template repeatByte(c: char): uint64 = 0x0101010101010101'u64 * uint64(ord(c))
+
+template hasZeroByte(x: uint64): bool =
+  ((x - 0x0101010101010101'u64) and not x and 0x8080808080808080'u64) != 0
+
+proc scanUntil*(L: var TBaseLexer, pos: int, stops: static set[char]): int =
+  ## Returns the position of the first character in `stops` or of
+  ## `EndOfFile` at or after `pos`. Looks at 8 bytes at a time. `stops` has
+  ## to contain `CR` and `LF` so that the sentinel ends the scan.
+  static: assert NewLines <= stops
+  const words = block:
+    var r: seq[uint64] = @[]
+    for c in stops: r.add repeatByte(c)
+    r
+  result = pos
+  while result + 8 <= L.bufLen:
+    var w: uint64
+    copyMem(addr w, addr L.buf[result], 8)
+    var found = hasZeroByte(w)
+    for x in words:
+      if hasZeroByte(w xor x): found = true
+    if found: break
+    inc result, 8
+  while L.buf[result] notin stops and L.buf[result] != EndOfFile:
+    inc result
+
+proc addChars*(s: var string, buf: cstring, first, last: int) {.inline.} =
+  ## Appends `buf[first ..< last]` to `s`.
+  let n = last - first
+  if n > 0:
+    let old = s.len
+    s.setLen(old + n)
+    copyMem(addr s[old], addr buf[first], n)
@@ -110,6 +110,10 @@ type                          # please make sure we have under 32 options
     optEnableDeepCopy         # ORC specific: enable 'deepcopy' for all types.
     optShowNonExportedFields  # for documentation: show fields that are not exported
     optJsBigInt64             # use bigints for 64-bit integers in JS
+    optUnityBuild             # compile the generated C code as few big files
+    optReorderFields          # lay out object fields by decreasing alignment
+    optFramePointers          # keep frame pointers for profilers and stack walks
+    optNativeStackTrace       # stack traces from frame pointers and DWARF line tables
 
   TGlobalOptions* = set[TGlobalOption]
 
@@ -320,6 +324,15 @@ type
   ProfileData* = ref object
     data*: TableRef[TLineInfo, ProfileInfo]
 
+  TimelineEvent* = object
+    cat*, name*, detail*: string
+    start*, duration*: int64 # in microseconds
+    lane*: int # 0 for the compiler itself, 1.. for external processes
+
+  Timeline* = ref object # see `--traceTimeline`
+    file*: AbsoluteFile
+    events*: seq[TimelineEvent]
+
   StdOrrKind* = enum
     stdOrrStdout
     stdOrrStderr
@@ -358,6 +371,7 @@ type
     hintProcessingDots*: bool # true for dots, false for filenames
     verbosity*: int            # how verbose the compiler is
     numberOfProcessors*: int   # number of processors
+    unityShards*: int          # number of C files of a unity build
     lastCmdTime*: float        # when caas is enabled, we measure each command
     symbolFiles*: SymbolFilesOption
     spellSuggestMax*: int # max number of spelling suggestions for typos
@@ -439,6 +453,7 @@ type
     cppCustomNamespace*: string
     nimMainPrefix*: string
     vmProfileData*: ProfileData
+    timeline*: Timeline # nil unless `--traceTimeline` is used
 
     expandProgress*: bool
     expandLevels*: int
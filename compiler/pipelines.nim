@@ -3,7 +3,7 @@ import sem, cgen, modulegraphs, ast, llstream, parser, msgs,
        packages, syntaxes, depends, vm, pragmas, idents, lookups, wordrecg,
        liftdestructors
 
-import pipelineutils
+import pipelineutils, timeline
 
 import ../dist/checksums/src/checksums/sha1
 
@@ -159,23 +159,28 @@ proc processPipelineModule*(graph: ModuleGraph; module: PSym; idgen: IdGenerator
     checkFirstLineIndentation(p)
     block processCode:
       if graph.stopCompile(): break processCode
-      var n = parseTopLevelStmt(p)
-      if n.kind == nkEmpty: break processCode
-      # read everything, no streaming possible
-      var sl = newNodeI(nkStmtList, n.info)
-      sl.add n
-      while true:
+      var sl: PNode = nil
+      traceTimeline(graph.config, "parse", module.name.s):
         var n = parseTopLevelStmt(p)
-        if n.kind == nkEmpty: break
+        if n.kind == nkEmpty: break processCode
+        # read everything, no streaming possible
+        sl = newNodeI(nkStmtList, n.info)
         sl.add n
+        while true:
+          var n = parseTopLevelStmt(p)
+          if n.kind == nkEmpty: break
+          sl.add n
 
       prePass(ctx, sl)
       if sfReorder in module.flags or codeReordering in graph.config.features:
         sl = reorder(graph, sl, module)
       if graph.pipelinePass != EvalPass:
         message(graph.config, sl.info, hintProcessingStmt, $idgen[])
-      var semNode = semWithPContext(ctx, sl)
-      discard processPipeline(graph, semNode, bModule)
+      var semNode: PNode = nil
+      traceTimeline(graph.config, "sem", module.name.s):
+        semNode = semWithPContext(ctx, sl)
+      traceTimeline(graph.config, "codegen", module.name.s):
+        discard processPipeline(graph, semNode, bModule)
 
     closeParser(p)
     if s.kind != llsStdIn: break
@@ -184,7 +189,8 @@ proc processPipelineModule*(graph: ModuleGraph; module: PSym; idgen: IdGenerator
   of CgenPass:
     if bModule != nil:
       let m = BModule(bModule)
-      finalCodegenActions(graph, m, finalNode)
+      traceTimeline(graph.config, "codegen", module.name.s):
+        finalCodegenActions(graph, m, finalNode)
       if graph.dispatchers.len > 0:
         let ctx = preparePContext(graph, module, idgen)
         for disp in getDispatchers(graph):
@@ -228,7 +234,8 @@ proc compilePipelineModule*(graph: ModuleGraph; fileIdx: FileIndex; flags: TSymF
     if sfMainModule in flags:
       if graph.config.projectIsStdin: s = stdin.llStreamOpen
       elif graph.config.projectIsCmd: s = llStreamOpen(graph.config.cmdInput)
-    discard processPipelineModule(graph, result, idGeneratorFromModule(result), s)
+    traceTimeline(graph.config, "module", toFilenameOption(graph.config, fileIdx, foName)):
+      discard processPipelineModule(graph, result, idGeneratorFromModule(result), s)
   if result == nil:
     var cachedModules: seq[FileIndex] = @[]
     result = moduleFromRodFile(graph, fileIdx, cachedModules)
@@ -20,8 +20,8 @@ import
   isolation_check, typeallowed, modulegraphs, enumtostr, concepts, astmsgs,
   extccomp, layeredtable
 
-import vtables
-import std/[strtabs, math, tables, intsets, strutils, packedsets]
+import vtables, timeline, macroexpcache
+import std/[strtabs, math, tables, intsets, strutils, packedsets, hashes]
 
 when not defined(leanCompiler):
   import spawn
@@ -537,7 +537,18 @@ proc semMacroExpr(c: PContext, n, nOrig: PNode, sym: PSym,
 
   #if c.evalContext == nil:
   #  c.evalContext = c.createEvalContext(emStatic)
-  result = evalMacroCall(c.module, c.idgen, c.graph, c.templInstCounter, n, nOrig, sym)
+  var cacheKey = ""
+  let cacheable = sfCacheMacro in sym.flags and
+    expansionKey(c.graph, sym, n, cacheKey)
+  result = if cacheable: loadExpansion(c.graph, cacheKey) else: nil
+  if result != nil:
+    inc c.graph.instCacheStats.macroHits
+  else:
+    traceTimeline(c.config, "macro", sym.name.s, c.config.toFileLineCol(info)):
+      result = evalMacroCall(c.module, c.idgen, c.graph, c.templInstCounter, n, nOrig, sym)
+    if cacheable:
+      inc c.graph.instCacheStats.macroMisses
+      storeExpansion(c.graph, cacheKey, result)
   if efNoSemCheck notin flags:
     result = semAfterMacroCall(c, n, result, sym, flags, expectedType)
   if c.config.macrosToExpand.hasKey(sym.name.s):
@@ -102,6 +102,85 @@ proc addTypeBoundSymbols(graph: ModuleGraph, arg: PType, name: PIdent,
           syms.add((s, -2))
         s = nextModuleIter(iter, graph)
 
+proc isPlainRoutine(c: PContext; s: PSym): bool =
+  ## Whether matching a call against `s` depends on nothing but the types of
+  ## the arguments and whether they are l-values.
+  c.overloadMemo.plainRoutines.withValue(s.itemId, known):
+    return known[]
+  result = s.kind in {skProc, skFunc, skMethod, skIterator, skConverter} and
+    s.typ != nil and s.typ.n != nil and not isGenericRoutine(s) and
+    s.magic notin {mArrGet, mArrPut}
+  if result:
+    for i in 1..<s.typ.n.len:
+      let param = s.typ.n[i].sym
+      if param.constraint != nil or param.typ == nil or
+          param.typ.kind in {tyUntyped, tyTyped, tyTypeDesc, tyStatic,
+                             tyVarargs, tyAnything} or
+          containsGenericType(param.typ):
+        result = false
+        break
+  c.overloadMemo.plainRoutines[s.itemId] = result
+
+proc overloadMemoKey(c: PContext; n: PNode; syms: seq[tuple[s: PSym, scope: int]];
+                     flags: TExprFlags; key: var Hash): bool =
+  ## Computes the key under which the outcome of resolving `n` against
+  ## `syms` is remembered. Fails for calls whose outcome depends on more than
+  ## the candidates, the argument types and their l-valueness: literals (as
+  ## they convert implicitly), procvars, named arguments, converters and
+  ## candidates that are not plain routines.
+  result = false
+  if c.converters.len > 0: return
+  var h: Hash = hash(flags) !& n.len !& ord(c.inUncheckedAssignSection > 0)
+  for a in 1..<n.len:
+    let arg = n[a]
+    if arg.typ == nil or arg.kind notin {nkSym, nkDotExpr, nkBracketExpr,
+        nkCall, nkCommand, nkInfix, nkPrefix, nkPostfix, nkHiddenCallConv,
+        nkDerefExpr, nkHiddenDeref, nkAddr, nkHiddenAddr, nkConv, nkCast,
+        nkHiddenStdConv, nkHiddenSubConv, nkObjDownConv, nkObjUpConv,
+        nkCheckedFieldExpr, nkObjConstr, nkStmtListExpr}:
+      return
+    if arg.kind == nkSym and arg.sym.kind notin {skVar, skLet, skParam,
+        skResult, skForVar, skTemp}:
+      return
+    let t = arg.typ.skipTypes({tyAlias})
+    if t.kind in {tyProc, tyError, tyNone, tyEmpty, tyNil, tyVoid, tyStatic,
+                  tyTypeDesc, tyFromExpr, tyGenericParam, tyUntyped, tyTyped}:
+      return
+    if t.n != nil and t.kind in {tyBool, tyChar, tyInt..tyFloat128, tyString, tyCstring}:
+      return # the type of a literal
+    if not sameTypeHash(arg.typ, h): return
+    h = h !& ord(parampatterns.isAssignable(nil, arg))
+  for x in syms:
+    if not isPlainRoutine(c, x.s): return
+    h = h !& hash(x.s.itemId) !& x.scope
+  key = !$h
+  result = true
+
+proc overloadMemoGet(c: PContext; n: PNode; syms: seq[tuple[s: PSym, scope: int]];
+                     flags: TExprFlags; key: Hash): int =
+  result = -1
+  c.overloadMemo.entries.withValue(key, entries):
+    for e in entries[]:
+      if e.flags != flags or e.args.len != n.len - 1 or
+          e.candidates.len != syms.len:
+        continue
+      block sameCall:
+        for i in 0..<syms.len:
+          if e.candidates[i].s != syms[i].s or e.candidates[i].scope != syms[i].scope:
+            break sameCall
+        for a in 1..<n.len:
+          if e.args[a-1].lvalue != ord(parampatterns.isAssignable(nil, n[a])) or
+              not compareTypes(e.args[a-1].typ, n[a].typ):
+            break sameCall
+        return e.winner
+
+proc overloadMemoPut(c: PContext; n: PNode; syms: seq[tuple[s: PSym, scope: int]];
+                     flags: TExprFlags; key: Hash; winner: int) =
+  var e = OverloadMemoEntry(candidates: syms, flags: flags, winner: winner)
+  for a in 1..<n.len:
+    e.args.add (n[a].typ, ord(parampatterns.isAssignable(nil, n[a])))
+  c.overloadMemo.entries.mgetOrPut(key, @[]).add e
+
 proc pickBestCandidate(c: PContext, headSymbol: PNode,
                        n, orig: PNode,
                        initialBinding: PNode,
@@ -124,6 +203,29 @@ proc pickBestCandidate(c: PContext, headSymbol: PNode,
   let allowTypeBoundOps = typeBoundOps in c.features and
     # qualified or bound symbols cannot refer to type bound ops
     headSymbol.kind in {nkIdent, nkAccQuoted, nkOpenSymChoice, nkOpenSym}
+
+  # Calls of the same plain routines with arguments of the same types pick
+  # the same winner; remember it and only match against the winner next time.
+  var memoKey: Hash = 0
+  let memoize = headSymbol.kind == nkIdent and initialBinding == nil and
+    not allowTypeBoundOps and not diagnosticsFlag and not errorsEnabled and
+    c.inGenericContext == 0 and c.matchedConcept == nil and
+    c.compilesContextId == 0 and not c.graph.suggestMode and
+    overloadMemoKey(c, n, syms, flags, memoKey)
+  if memoize:
+    let winner = overloadMemoGet(c, n, syms, flags, memoKey)
+    if winner >= 0:
+      let (sym, scope) = syms[winner]
+      determineType(c, sym)
+      var z = initCandidate(c, sym, initialBinding, scope, diagnosticsFlag)
+      matches(c, n, orig, z)
+      if z.state == csMatch:
+        inc c.graph.instCacheStats.overloadHits
+        best = z
+        return
+    inc c.graph.instCacheStats.overloadMisses
+  let memoSyms = if memoize: syms else: @[]
+  var bestIndex = -1
   var symMarker = initIntSet()
   for s in syms:
     symMarker.incl(s.s.id)
@@ -140,6 +242,8 @@ proc pickBestCandidate(c: PContext, headSymbol: PNode,
 
   # starts at 1 because 0 is already done with setup, only needs checking
   var nextSymIndex = 1
+  var symIndex = 0 # index of `sym` in `syms`
+  var recalculated = false
   var z: TCandidate # current candidate
   while true:
     determineType(c, sym)
@@ -168,10 +272,14 @@ proc pickBestCandidate(c: PContext, headSymbol: PNode,
           else:
             dec(z.exactMatches, 200)
         case best.state
-        of csEmpty, csNoMatch: best = z
+        of csEmpty, csNoMatch:
+          best = z
+          bestIndex = symIndex
         of csMatch:
           var cmp = cmpCandidates(best, z)
-          if cmp < 0: best = z   # x is better than the best so far
+          if cmp < 0:
+            best = z   # x is better than the best so far
+            bestIndex = symIndex
           elif cmp == 0: alt = z # x is as good as the best so far
       elif errorsEnabled or z.diagnosticsEnabled:
         errors.add(CandidateError(
@@ -201,6 +309,7 @@ proc pickBestCandidate(c: PContext, headSymbol: PNode,
       # reset counter because syms may be in a new order
       symCount = c.currentScope.symbols.counter
       nextSymIndex = 0
+      recalculated = true
 
       # just in case, should be impossible though
       if syms.len == 0:
@@ -213,8 +322,14 @@ proc pickBestCandidate(c: PContext, headSymbol: PNode,
     # advance to next sym
     sym = syms[nextSymIndex].s
     scope = syms[nextSymIndex].scope
+    symIndex = nextSymIndex
     inc(nextSymIndex)
 
+  if memoize and not recalculated and best.state == csMatch and
+      bestIndex >= 0 and syms.len == memoSyms.len and
+      not (alt.state == csMatch and cmpCandidates(best, alt) == 0):
+    overloadMemoPut(c, n, memoSyms, flags, memoKey, bestIndex)
+
 
 proc effectProblem(f, a: PType; result: var string; c: PContext) =
   if f.kind == tyProc and a.kind == tyProc:
@@ -9,7 +9,7 @@
 
 ## This module contains the data structures for the semantic checking phase.
 
-import std/[tables, intsets, sets]
+import std/[tables, intsets, sets, hashes]
 
 when defined(nimPreviewSlimSystem):
   import std/assertions
@@ -54,6 +54,18 @@ type
     genericSym*: PSym
     inst*: PInstantiation
 
+  OverloadMemoEntry* = object
+    ## The winner of an earlier overload resolution, valid for calls that
+    ## see exactly the same candidates with arguments of the same types.
+    candidates*: seq[tuple[s: PSym, scope: int]]
+    args*: seq[tuple[typ: PType, lvalue: int]]
+    flags*: TExprFlags
+    winner*: int # index into `candidates`
+
+  OverloadMemo* = object
+    entries*: Table[Hash, seq[OverloadMemoEntry]]
+    plainRoutines*: Table[ItemId, bool] # routines whose matching has no side effects
+
   TExprFlag* = enum
     efLValue, efWantIterator, efWantIterable, efInTypeof,
     efNeedStatic,
@@ -119,6 +131,7 @@ type
     compilesContextId*: int    # > 0 if we are in a ``compiles`` magic
     compilesContextIdGenerator*: int
     inGenericInst*: int        # > 0 if we are instantiating a generic
+    overloadMemo*: OverloadMemo # see `pickBestCandidate`
     converters*: seq[PSym]
     patterns*: seq[PSym]       # sequence of pattern matchers
     optionStack*: seq[POptionEntry]
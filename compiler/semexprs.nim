@@ -34,8 +34,9 @@ proc semTemplateExpr(c: PContext, n: PNode, s: PSym,
   # Note: This is n.info on purpose. It prevents template from creating an info
   # context when called from an another template
   pushInfoContext(c.config, n.info, s.detailedInfo)
-  result = evalTemplate(n, s, getCurrOwner(c), c.config, c.cache,
-                        c.templInstCounter, c.idgen, efFromHlo in flags)
+  traceTimeline(c.config, "template", s.name.s, c.config.toFileLineCol(info)):
+    result = evalTemplate(n, s, getCurrOwner(c), c.config, c.cache,
+                          c.templInstCounter, c.idgen, efFromHlo in flags)
   if efNoSemCheck notin flags:
     result = semAfterMacroCall(c, n, result, s, flags, expectedType)
   popInfoContext(c.config)
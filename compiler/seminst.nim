@@ -86,13 +86,26 @@ proc sameInstantiation(a, b: TInstantiation): bool =
   else:
     result = false
 
-proc genericCacheGet(g: ModuleGraph; genericSym: PSym, entry: TInstantiation;
-                     id: CompilesId): PSym =
+proc instantiationHash(inst: PInstantiation; h: var Hash): bool =
+  result = true
+  h = h !& inst.concreteTypes.len
+  for t in inst.concreteTypes:
+    if not sameTypeHash(t, h): return false
+  h = !$h
+
+proc genericCacheGetAux(g: ModuleGraph; genericSym: PSym, entry: PInstantiation;
+                        id: CompilesId): PSym =
   result = nil
-  for inst in procInstCacheItems(g, genericSym):
-    if (inst.compilesId == 0 or inst.compilesId == id) and sameInstantiation(entry, inst[]):
+  for inst in procInstCandidates(g, genericSym, entry, instantiationHash):
+    inc g.instCacheStats.compared
+    if (inst.compilesId == 0 or inst.compilesId == id) and sameInstantiation(entry[], inst[]):
       return inst.sym
 
+proc genericCacheGet(g: ModuleGraph; genericSym: PSym, entry: PInstantiation;
+                     id: CompilesId): PSym =
+  result = measureInstLookup(g, procHits, procMisses):
+    genericCacheGetAux(g, genericSym, entry, id)
+
 when false:
   proc `$`(x: PSym): string =
     result = x.name.s & " " & " id " & $x.id
@@ -435,7 +448,7 @@ proc generateInstance(c: PContext, fn: PSym, pt: LayeredIdTable,
   if tfTriggersCompileTime in result.typ.flags:
     incl(result.flags, sfCompileTime)
   n[genericParamsPos] = c.graph.emptyNode
-  var oldPrc = genericCacheGet(c.graph, fn, entry[], c.compilesContextId)
+  var oldPrc = genericCacheGet(c.graph, fn, entry, c.compilesContextId)
   if oldPrc == nil:
     # we MUST not add potentially wrong instantiations to the caching mechanism.
     # This means recursive instantiations behave differently when in
@@ -2512,6 +2512,12 @@ proc semProcAux(c: PContext, n: PNode, kind: TSymKind,
   pragmaCallable(c, s, n, validPragmas)
   if not hasProto:
     implicitPragmas(c, s, n.info, validPragmas)
+  if optReorderFields in c.config.globalOptions and
+      ({sfImportc, sfExportc} * s.flags != {} or s.typ.callConv in foreignCallConvs):
+    let what = (if sfImportc in s.flags: "the importc routine '"
+                elif sfExportc in s.flags: "the exportc routine '"
+                else: "the " & $s.typ.callConv & " routine '") & s.name.s & "'"
+    for t in s.typ.signature: keepFieldOrder(c, t, n.info, what)
 
   if n[pragmasPos].kind != nkEmpty and sfBorrow notin s.flags:
     setEffectsForProcType(c.graph, s.typ, n[pragmasPos], s)
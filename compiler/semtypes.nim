@@ -1887,6 +1887,35 @@ proc applyTypeSectionPragmas(c: PContext; pragmas, operand: PNode): PNode =
             of skTemplate: return semTemplateExpr(c, r, m, {efNoSemCheck})
             else: doAssert(false, "cannot happen")
 
+const
+  foreignCallConvs = {ccStdCall, ccCDecl, ccSafeCall, ccSysCall, ccFastCall,
+                      ccThisCall, ccNoConvention}
+
+proc keepFieldOrder(c: PContext; n: PNode; info: TLineInfo; what: string)
+
+proc keepFieldOrder(c: PContext; t: PType; info: TLineInfo; what: string) =
+  ## Objects that are passed to or from C code mirror C structs, and so do
+  ## the objects they contain: `--reorderFields` must not touch them. `what`
+  ## is the routine or proc type that passes them.
+  if t == nil: return
+  let t = t.skipTypes(abstractInst + {tyPtr, tyVar, tyLent, tyArray, tyUncheckedArray})
+  if t.kind != tyObject or {tfKeepFieldOrder, tfReorderFields} * t.flags != {}:
+    return
+  if t.size != szUncomputedSize and fieldsReorderable(c.config, t):
+    localError(c.config, info, errGenerated, "the fields of '" & typeToString(t) &
+      "' were already reordered by --reorderFields when it was passed to " &
+      what & "; declare that before the size of the type is needed or mark " &
+      "the type as .bycopy")
+  t.flags.incl tfKeepFieldOrder
+  keepFieldOrder(c, t.baseClass, info, what)
+  keepFieldOrder(c, t.n, info, what)
+
+proc keepFieldOrder(c: PContext; n: PNode; info: TLineInfo; what: string) =
+  if n == nil: return
+  if n.kind == nkSym: keepFieldOrder(c, n.sym.typ, info, what)
+  else:
+    for i in 0..<n.safeLen: keepFieldOrder(c, n[i], info, what)
+
 proc semProcTypeWithScope(c: PContext, n: PNode,
                           prev: PType, kind: TSymKind): PType =
   checkSonsLen(n, 2, c.config)
@@ -1906,6 +1935,10 @@ proc semProcTypeWithScope(c: PContext, n: PNode,
   if n[1].kind != nkEmpty and n[1].len > 0:
     pragma(c, s, n[1], procTypePragmas)
     when useEffectSystem: setEffectsForProcType(c.graph, result, n[1])
+    if result.callConv in foreignCallConvs and
+        optReorderFields in c.config.globalOptions:
+      for t in result.signature:
+        keepFieldOrder(c, t, n.info, "a " & $result.callConv & " proc type")
   elif c.optionStack.len > 0:
     # we construct a fake 'nkProcDef' for the 'mergePragmas' inside 'implicitPragmas'...
     s.ast = newTree(nkProcDef, newNodeI(nkEmpty, n.info), newNodeI(nkEmpty, n.info),
@@ -9,7 +9,7 @@
 
 # This module does the instantiation of generic types.
 
-import std / tables
+import std / [tables, hashes]
 
 import ast, astalgo, msgs, types, magicsys, semdata, renderer, options,
   lineinfos, modulegraphs, layeredtable
@@ -31,13 +31,23 @@ proc checkConstructedType*(conf: ConfigRef; info: TLineInfo, typ: PType) =
   elif computeSize(conf, t) == szIllegalRecursion or isTupleRecursive(t):
     localError(conf, info, "illegal recursion in type '" & typeToString(t) & "'")
 
-proc searchInstTypes*(g: ModuleGraph; key: PType): PType =
+proc genericArgsHash(t: PType; h: var Hash): bool =
+  # Hashes the arguments of a generic invocation or instantiation. Fails for
+  # instantiations that are still being built: they are cached before their
+  # arguments are added.
+  result = false
+  if t.kidsLen == 0 or t[0] == nil: return
+  let params = t[0].kidsLen - 1
+  if params <= 0 or t.kidsLen <= params: return
+  for j in FirstGenericParamAt..params:
+    if not sameTypeHash(t[j], h): return
+  h = !$h
+  result = true
+
+proc searchInstTypesAux(g: ModuleGraph; genericTyp, key: PType): PType =
   result = nil
-  let genericTyp = key[0]
-  if not (genericTyp.kind == tyGenericBody and
-      genericTyp.sym != nil): return
-
-  for inst in typeInstCacheItems(g, genericTyp.sym):
+  for inst in typeInstCandidates(g, genericTyp.sym, key, genericArgsHash):
+    inc g.instCacheStats.compared
     if inst.id == key.id: return inst
     if inst.kidsLen < key.kidsLen:
       # XXX: This happens for prematurely cached
@@ -57,6 +67,29 @@ proc searchInstTypes*(g: ModuleGraph; key: PType): PType =
 
       return inst
 
+proc countDuplicateInst(g: ModuleGraph; inst: PType) =
+  # For the `CacheStats` hint: an instance that is equal to an instance that
+  # was cached before is one that the lookup should have found.
+  let genericTyp = inst[0]
+  if not (genericTyp.kind == tyGenericBody and genericTyp.sym != nil): return
+  for other in typeInstCacheItems(g, genericTyp.sym):
+    if other != inst and other.kidsLen == inst.kidsLen and sameFlags(other, inst):
+      block matchType:
+        for j in FirstGenericParamAt..<inst.kidsLen - 1:
+          if not compareTypes(other[j], inst[j],
+                              flags = {ExactGenericParams, PickyCAliases}):
+            break matchType
+        inc g.instCacheStats.duplicates
+        return
+
+proc searchInstTypes*(g: ModuleGraph; key: PType): PType =
+  result = nil
+  let genericTyp = key[0]
+  if not (genericTyp.kind == tyGenericBody and
+      genericTyp.sym != nil): return
+  result = measureInstLookup(g, typeHits, typeMisses):
+    searchInstTypesAux(g, genericTyp, key)
+
 proc cacheTypeInst(c: PContext; inst: PType) =
   let gt = inst[0]
   let t = if gt.kind == tyGenericBody: gt.typeBodyImpl else: gt
@@ -498,6 +531,8 @@ proc handleGenericInvocation(cl: var TReplTypeVars, t: PType): PType =
   rawAddSon(result, newbody)
   checkPartialConstructedType(cl.c.config, cl.info, newbody)
   if not cl.allowMetaTypes:
+    if cl.c.config.hasHint(hintCacheStats):
+      countDuplicateInst(cl.c.graph, result)
     let dc = cl.c.graph.getAttachedOp(newbody, attachedDeepCopy)
     if dc != nil and sfFromGeneric notin dc.flags:
       # 'deepCopy' needs to be instantiated for
@@ -105,6 +105,57 @@ proc computeSubObjectAlign(conf: ConfigRef; n: PNode): BiggestInt =
     result = 1
 
 
+proc inProjectPackage(conf: ConfigRef; typ: PType): bool =
+  var s = if typ.sym != nil: typ.sym else: typ.owner
+  while s != nil and s.kind != skPackage: s = s.owner
+  result = s != nil and s.id == conf.mainPackageId
+
+proc fieldsReorderable*(conf: ConfigRef; typ: PType): bool =
+  ## Whether the fields of the object type `typ` are laid out by decreasing
+  ## alignment rather than in declaration order. Types whose layout is
+  ## shared with C code keep the declared order. `--reorderFields:on` only
+  ## applies to the project's own package, not to the standard library and
+  ## other packages with their C wrappers, and not to objects that are
+  ## passed to importc routines; the system module's low level code also
+  ## casts between objects with common fields.
+  result = typ.kind == tyObject and
+    (tfReorderFields in typ.flags or optReorderFields in conf.globalOptions and
+      tfKeepFieldOrder notin typ.flags and inProjectPackage(conf, typ)) and
+    {tfPacked, tfUnion, tfByCopy, tfCompleteStruct, tfIncompleteStruct} * typ.flags == {} and
+    (typ.sym == nil or {sfImportc, sfExportc, sfCodegenDecl} * typ.sym.flags == {})
+
+proc fieldAlign(conf: ConfigRef; field: PSym): int32 =
+  computeSizeAlign(conf, field.typ)
+  result = field.typ.align.int32
+  if result > 0 and field.alignment.int32 > result:
+    result = field.alignment.int32
+
+proc isReorderableList(conf: ConfigRef; n: PNode): bool =
+  ## only lists of plain fields of known alignment are reordered; a flexible
+  ## array member has to stay last
+  result = n.kind == nkRecList
+  if result:
+    for it in n.sons:
+      if it.kind != nkSym or it.sym.bitsize != 0 or fieldAlign(conf, it.sym) <= 0 or
+          it.sym.typ.skipTypes(abstractInst).kind == tyUncheckedArray:
+        return false
+
+proc fieldLayoutOrder*(conf: ConfigRef; n: PNode): seq[PNode] =
+  ## The children of the record list `n` of a reorderable object in the order
+  ## of their offsets: by decreasing alignment, fields of equal alignment in
+  ## declaration order. The backends emit the fields in this order.
+  result = n.sons
+  if not isReorderableList(conf, n): return
+  # a stable insertion sort, the lists are short
+  for i in 1..<result.len:
+    let x = result[i]
+    let a = fieldAlign(conf, x.sym)
+    var j = i - 1
+    while j >= 0 and fieldAlign(conf, result[j].sym) < a:
+      result[j+1] = result[j]
+      dec j
+    result[j+1] = x
+
 proc setOffsetsToUnknown(n: PNode) =
   if n.kind == nkSym and n.sym.kind == skField:
     n.sym.offset = szUnknownSize
@@ -112,16 +163,17 @@ proc setOffsetsToUnknown(n: PNode) =
     for i in 0..<n.safeLen:
       setOffsetsToUnknown(n[i])
 
-proc computeObjectOffsetsFoldFunction(conf: ConfigRef; n: PNode; packed: bool; accum: var OffsetAccum) =
+proc computeObjectOffsetsFoldFunction(conf: ConfigRef; n: PNode; packed, reorder: bool; accum: var OffsetAccum) =
   ## ``offset`` is the offset within the object, after the node has been written, no padding bytes added
   ## ``align`` maximum alignment from all sub nodes
+  ## ``reorder`` lays out record lists in ``fieldLayoutOrder``
   assert n != nil
   if n.typ != nil and n.typ.size == szIllegalRecursion:
     raiseIllegalTypeRecursion()
   case n.kind
   of nkRecCase:
     assert(n[0].kind == nkSym)
-    computeObjectOffsetsFoldFunction(conf, n[0], packed, accum)
+    computeObjectOffsetsFoldFunction(conf, n[0], packed, reorder, accum)
     var maxChildAlign = if accum.offset == szUnknownSize: szUnknownSize.int32 else: 1'i32
     if not packed:
       for i in 1..<n.len:
@@ -143,12 +195,13 @@ proc computeObjectOffsetsFoldFunction(conf: ConfigRef; n: PNode; packed: bool; a
       let accumRoot = accum # copy, because each branch should start af the same offset
       for i in 1..<n.len:
         var branchAccum = OffsetAccum(offset: accumRoot.offset, maxAlign: 1)
-        computeObjectOffsetsFoldFunction(conf, n[i].lastSon, packed, branchAccum)
+        computeObjectOffsetsFoldFunction(conf, n[i].lastSon, packed, reorder, branchAccum)
         discard finish(branchAccum)
         accum.mergeBranch(branchAccum)
   of nkRecList:
-    for i, child in n.sons:
-      computeObjectOffsetsFoldFunction(conf, child, packed, accum)
+    let children = if reorder: fieldLayoutOrder(conf, n) else: n.sons
+    for child in children:
+      computeObjectOffsetsFoldFunction(conf, child, packed, reorder, accum)
   of nkSym:
     var size = szUnknownSize.int32
     var align = szUnknownSize.int32
@@ -195,6 +248,33 @@ proc computeUnionObjectOffsetsFoldFunction(conf: ConfigRef; n: PNode; packed: bo
     accum.maxAlign = szUnknownSize
     accum.offset = szUnknownSize
 
+proc objectHeader(conf: ConfigRef; typ: PType): OffsetAccum =
+  ## the accumulator after the base object or the type field of `typ`
+  if typ.baseClass != nil:
+    # compute header size
+    var st = typ.baseClass
+    while st.kind in skipPtrs:
+      st = st.skipModifier
+    computeSizeAlign(conf, st)
+    if conf.backend == backendCpp:
+      result = OffsetAccum(
+        offset: int32(st.size) - int32(st.paddingAtEnd),
+        maxAlign: st.align
+      )
+    else:
+      result = OffsetAccum(
+        offset: int32(st.size),
+        maxAlign: st.align
+      )
+  elif isObjectWithTypeFieldPredicate(typ):
+    # this branch is taken for RootObj
+    result = OffsetAccum(
+      offset: conf.target.intSize.int32,
+      maxAlign: conf.target.intSize.int32
+    )
+  else:
+    result = OffsetAccum(maxAlign: 1)
+
 proc computeSizeAlign(conf: ConfigRef; typ: PType) =
   template setSize(typ, s) =
     typ.size = s
@@ -244,6 +324,9 @@ proc computeSizeAlign(conf: ConfigRef; typ: PType) =
   of tyString:
     if optSeqDestructors in conf.globalOptions:
       typ.size = conf.target.ptrSize * 2
+      if isDefined(conf, "nimSso"):
+        # the inline chars and the flag of a short string, see strs_v2
+        typ.size += 8
     else:
       typ.size = conf.target.ptrSize
     typ.align = int16(conf.target.ptrSize)
@@ -349,31 +432,7 @@ proc computeSizeAlign(conf: ConfigRef; typ: PType) =
 
   of tyObject:
     try:
-      var accum =
-        if typ.baseClass != nil:
-          # compute header size
-          var st = typ.baseClass
-          while st.kind in skipPtrs:
-            st = st.skipModifier
-          computeSizeAlign(conf, st)
-          if conf.backend == backendCpp:
-            OffsetAccum(
-              offset: int32(st.size) - int32(st.paddingAtEnd),
-              maxAlign: st.align
-            )
-          else:
-            OffsetAccum(
-              offset: int32(st.size),
-              maxAlign: st.align
-            )
-        elif isObjectWithTypeFieldPredicate(typ):
-          # this branch is taken for RootObj
-          OffsetAccum(
-            offset: conf.target.intSize.int32,
-            maxAlign: conf.target.intSize.int32
-          )
-        else:
-          OffsetAccum(maxAlign: 1)
+      var accum = objectHeader(conf, typ)
       if tfUnion in typ.flags:
         if accum.offset != 0:
           let info = if typ.sym != nil: typ.sym.info else: unknownLineInfo
@@ -383,7 +442,7 @@ proc computeSizeAlign(conf: ConfigRef; typ: PType) =
           computeUnionObjectOffsetsFoldFunction(conf, typ.n, tfPacked in typ.flags, accum)
       elif tfPacked in typ.flags:
         accum.maxAlign = 1
-        computeObjectOffsetsFoldFunction(conf, typ.n, true, accum)
+        computeObjectOffsetsFoldFunction(conf, typ.n, true, false, accum)
       else:
         if typ.baseClass == nil and lacksMTypeField(typ) and typ.n.len == 1 and
             typ.n[0].kind == nkSym and
@@ -392,7 +451,8 @@ proc computeSizeAlign(conf: ConfigRef; typ: PType) =
           # with an UncheckedArray type
           assert accum.offset == 0
           accum.offset = 1
-        computeObjectOffsetsFoldFunction(conf, typ.n, false, accum)
+        computeObjectOffsetsFoldFunction(conf, typ.n, false,
+                                         fieldsReorderable(conf, typ), accum)
       let paddingAtEnd = int16(accum.finish())
       if typ.sym != nil and
          typ.sym.flags * {sfCompilerProc, sfImportc} == {sfImportc} and
@@ -468,6 +528,27 @@ proc computeSizeAlign(conf: ConfigRef; typ: PType) =
     typ.align = szUnknownSize
     typ.paddingAtEnd = szUnknownSize
 
+proc objectPadding*(conf: ConfigRef; typ: PType): tuple[padding, saving: int] =
+  ## The padding bytes in the object type `typ` after its header and the
+  ## bytes that laying out its fields by decreasing alignment would save.
+  ## Both are 0 for types that are not a plain list of fields.
+  result = (0, 0)
+  if typ.kind != tyObject or typ.n == nil or typ.size <= 0 or
+      {tfPacked, tfUnion} * typ.flags != {} or
+      not isReorderableList(conf, typ.n):
+    return
+  var accum = objectHeader(conf, typ)
+  let header = accum.offset.int
+  var used = 0
+  for it in fieldLayoutOrder(conf, typ.n):
+    accum.align(fieldAlign(conf, it.sym))
+    accum.inc(it.sym.typ.size.int32)
+    used += it.sym.typ.size.int
+  discard accum.finish()
+  if accum.offset > 0:
+    result.padding = int(typ.size) - header - used
+    result.saving = int(typ.size) - accum.offset.int
+
 template foldSizeOf*(conf: ConfigRef; n: PNode; fallback: PNode): PNode =
   let config = conf
   let node = n
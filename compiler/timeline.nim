@@ -0,0 +1,103 @@
+#
+#
+#           The Nim Compiler
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+## Implements `--traceTimeline:file.json`: the compiler records how long it
+## spends in its phases (parsing, semantic checking, macro and template
+## expansion, VM execution, transformations, code generation) and in the C
+## compiler and linker processes it starts. The result is written in the
+## Chrome trace event format which `chrome://tracing`, Perfetto and
+## speedscope can display.
+
+import options, msgs, lineinfos
+import std/[monotimes, json, os, strutils]
+
+when defined(nimPreviewSlimSystem):
+  import std/syncio
+
+const
+  minDuration = 20 ## µs; shorter fine grained events are not recorded
+                   ## to keep the trace small
+
+proc timelineNow*(conf: ConfigRef): int64 {.inline.} =
+  ## The current time in µs if a timeline is recorded, otherwise 0.
+  if conf.timeline != nil: getMonoTime().ticks div 1000
+  else: 0
+
+proc addTimelineEvent*(conf: ConfigRef; cat, name: string; start: int64;
+                       detail = ""; lane = 0; always = false) =
+  ## Records an event that began at `start` (see `timelineNow`) and ends now.
+  let duration = getMonoTime().ticks div 1000 - start
+  if always or duration >= minDuration:
+    conf.timeline.events.add TimelineEvent(cat: cat, name: name,
+      detail: detail, start: start, duration: duration, lane: lane)
+
+template traceTimeline*(conf: ConfigRef; cat, name, detail: string;
+                        body: untyped) =
+  ## Records the time spent in `body` as an event of category `cat`. `name`
+  ## and `detail` are only evaluated if a timeline is recorded.
+  let tlStart = timelineNow(conf)
+  try:
+    body
+  finally:
+    if tlStart != 0:
+      addTimelineEvent(conf, cat, name, tlStart, detail,
+                       always = cat == "module")
+
+template traceTimeline*(conf: ConfigRef; cat, name: string; body: untyped) =
+  traceTimeline(conf, cat, name, "", body)
+
+proc commandName*(cmd: string): string =
+  ## A short name for an external command: the C file it compiles or else
+  ## the name of the program.
+  result = ""
+  for token in cmd.split(' '):
+    let t = token.strip(chars = {'"', '\''})
+    if t.endsWith(".c") or t.endsWith(".cpp") or t.endsWith(".cc") or
+        t.endsWith(".cxx") or t.endsWith(".m"):
+      return t.extractFilename
+    if result.len == 0 and t.len > 0:
+      result = t.extractFilename
+
+proc writeTimeline*(conf: ConfigRef) =
+  ## Writes the recorded events to the file given to `--traceTimeline`.
+  let tl = conf.timeline
+  if tl == nil: return
+  var origin = high(int64)
+  for e in tl.events: origin = min(origin, e.start)
+  var lanes = 0
+  var s = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+  for e in tl.events:
+    s.add "{\"ph\":\"X\",\"pid\":1,\"tid\":"
+    s.addInt e.lane
+    s.add ",\"cat\":"
+    s.add escapeJson(e.cat)
+    s.add ",\"name\":"
+    s.add escapeJson(e.name)
+    s.add ",\"ts\":"
+    s.addInt e.start - origin
+    s.add ",\"dur\":"
+    s.addInt e.duration
+    if e.detail.len > 0:
+      s.add ",\"args\":{\"detail\":"
+      s.add escapeJson(e.detail)
+      s.add "}"
+    s.add "},\n"
+    lanes = max(lanes, e.lane)
+  for lane in 0..lanes:
+    s.add "{\"ph\":\"M\",\"pid\":1,\"tid\":"
+    s.addInt lane
+    s.add ",\"name\":\"thread_name\",\"args\":{\"name\":"
+    s.add escapeJson(if lane == 0: "nim" else: "process " & $lane)
+    s.add "}}"
+    s.add(if lane < lanes: ",\n" else: "\n")
+  s.add "]}\n"
+  try:
+    writeFile(tl.file.string, s)
+  except IOError:
+    rawMessage(conf, errCannotOpenFile, tl.file.string)
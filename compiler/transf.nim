@@ -24,7 +24,7 @@ import
   options, ast, astalgo, trees, msgs,
   idents, renderer, types, semfold, magicsys, cgmeth,
   lowerings, liftlocals,
-  modulegraphs, lineinfos
+  modulegraphs, lineinfos, timeline, checkelim
 
 when defined(nimPreviewSlimSystem):
   import std/assertions
@@ -1250,13 +1250,15 @@ proc transformBody*(g: ModuleGraph; idgen: IdGenerator; prc: PSym; flags: Transf
   else:
     prc.transformedBody = newNode(nkEmpty) # protects from recursion
     var c = openTransf(g, prc.getModule, "", idgen, flags)
-    result = liftLambdas(g, prc, getBody(g, prc), c.tooEarly, c.idgen, flags)
-    result = processTransf(c, result, prc)
-    liftDefer(c, result)
-    result = liftLocalsIfRequested(prc, result, g.cache, g.config, c.idgen)
-
-    if prc.isIterator:
-      result = g.transformClosureIterator(c.idgen, prc, result)
+    traceTimeline(g.config, "transf", prc.name.s):
+      let body = elimChecks(g, prc, getBody(g, prc))
+      result = liftLambdas(g, prc, body, c.tooEarly, c.idgen, flags)
+      result = processTransf(c, result, prc)
+      liftDefer(c, result)
+      result = liftLocalsIfRequested(prc, result, g.cache, g.config, c.idgen)
+
+      if prc.isIterator:
+        result = g.transformClosureIterator(c.idgen, prc, result)
 
     incl(result.flags, nfTransf)
 
@@ -13,7 +13,7 @@ import
   ast, astalgo, trees, msgs, platform, renderer, options,
   lineinfos, int128, modulegraphs, astmsgs, wordrecg
 
-import std/[intsets, strutils]
+import std/[intsets, strutils, hashes]
 
 when defined(nimPreviewSlimSystem):
   import std/[assertions, formatfloat]
@@ -1435,6 +1435,51 @@ proc compareTypes*(x, y: PType,
   elif x.isNil or y.isNil: result = false
   else: result = sameTypeAux(x, y, c)
 
+proc sameTypeHash*(t: PType; h: var Hash; depth = 3): bool =
+  ## Mixes a hash of `t` into `h` that is the same for all types that
+  ## `compareTypes` with `dcEq` considers equal, which makes it usable as a
+  ## key for caches that are then confirmed with `compareTypes`. Returns
+  ## false if `t` contains a type whose hash could still change: a forward
+  ## declared type or a generic instance that is still being built, which
+  ## are completed in place, or a type class, which can become equal to
+  ## other types once it is resolved.
+  result = true
+  if t == nil:
+    h = h !& 0
+    return
+  let a = skipTypes(t, {tyAlias})
+  h = h !& ord(a.kind)
+  case a.kind
+  of tyForward, tyUserTypeClass, tyUserTypeClassInst:
+    result = false
+  of tyObject, tyDistinct:
+    # see `ifFastObjectTypeCheckFailed`: equal types share their symbol
+    h = h !& (if a.sym != nil: a.sym.id else: 0)
+  of tyEnum:
+    h = h !& a.id
+  of tyProc:
+    h = h !& ord(a.callConv)
+  of tyGenericInst:
+    # see `sameTypeAux`: equal instances share the generic body, then their
+    # arguments are compared
+    let g = a.skipGenericAlias
+    h = h !& (if g.kind == tyGenericInst and g.base != nil: g.base.id else: 0)
+    if depth > 0 and g.kind == tyGenericInst:
+      # `handleGenericInvocation` caches an instance before its arguments
+      # and its body are added
+      if g.base != nil and g.kidsLen != g.base.kidsLen + 1: return false
+      for i in 1..<g.kidsLen - 1:
+        if not sameTypeHash(g[i], h, depth - 1): return false
+  of tySequence, tyOpenArray, tySet, tyRef, tyPtr, tyVar, tyLent, tySink,
+     tyUncheckedArray, tyArray, tyVarargs, tyOrdinal, tyOwned, tyRange,
+     tyTuple:
+    if depth > 0:
+      for i in 0..<a.kidsLen:
+        if not sameTypeHash(a[i], h, depth - 1): return false
+  else:
+    # the kind is all that equal types of this kind are known to share
+    discard
+
 proc inheritanceDiff*(a, b: PType): int =
   # | returns: 0 iff `a` == `b`
   # | returns: -x iff `a` is the x'th direct superclass of `b`
@@ -88,7 +88,8 @@ type
     wGlobal = "global", wCodegenDecl = "codegenDecl", wUnchecked = "unchecked",
     wGuard = "guard", wLocks = "locks", wPartial = "partial", wExplain = "explain",
     wLiftLocals = "liftlocals", wEnforceNoRaises = "enforceNoRaises", wSystemRaisesDefect = "systemRaisesDefect",
-    wRedefine = "redefine", wCallsite = "callsite",
+    wRedefine = "redefine", wCallsite = "callsite", wCacheMacro = "cacheMacro",
+    wReorderFields = "reorderFields",
     wQuirky = "quirky",
 
     # codegen keywords, but first the ones that are also pragmas:
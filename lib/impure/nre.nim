@@ -80,6 +80,7 @@ type
     pcreExtra: ptr pcre.ExtraData  ## nil
 
     captureNameToId: Table[string, int]
+    captureCountCache: int  ## queried once in `initRegex`, needed per match
 
   Regex* = ref RegexDesc
     ## Represents the pattern that things are matched against, constructed with
@@ -269,6 +270,15 @@ proc getNameToNumberTable(pattern: Regex): Table[string, int] =
 
     result[name] = num
 
+var jitStack {.threadvar.}: ptr pcre.JitStack
+
+proc threadJitStack(data: pointer): ptr pcre.JitStack {.cdecl.} =
+  # A JIT stack must not be shared by concurrent matches, so each thread
+  # lazily allocates its own. A nil result makes PCRE use its default stack.
+  if jitStack == nil:
+    jitStack = pcre.jit_stack_alloc(32 * 1024, 1024 * 1024)
+  result = jitStack
+
 proc initRegex(pattern: string, flags: int, study = true): Regex =
   when defined(gcDestructors):
     result = Regex()
@@ -296,11 +306,14 @@ proc initRegex(pattern: string, flags: int, study = true): Regex =
     result.pcreExtra = pcre.study(result.pcreObj, options, addr errorMsg)
     if errorMsg != nil:
       raise StudyError(msg: $errorMsg)
+    if options != 0 and result.pcreExtra != nil:
+      pcre.assign_jit_stack(result.pcreExtra, threadJitStack, nil)
 
   result.captureNameToId = result.getNameToNumberTable()
+  result.captureCountCache = getinfo[cint](result, pcre.INFO_CAPTURECOUNT)
 
 proc captureCount*(pattern: Regex): int =
-  return getinfo[cint](pattern, pcre.INFO_CAPTURECOUNT)
+  return pattern.captureCountCache
 
 proc captureNameId*(pattern: Regex): Table[string, int] =
   return pattern.captureNameToId
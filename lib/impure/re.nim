@@ -36,7 +36,7 @@ runnableExamples:
     # can't match start of string since we're starting at 1
 
 import
-  std/[pcre, strutils, rtarrays]
+  std/[pcre, strutils, rtarrays, tables]
 
 when defined(nimPreviewSlimSystem):
   import std/syncio
@@ -98,6 +98,21 @@ proc finalizeRegEx(x: Regex) =
   if not isNil(x.e):
     pcre.free_study(x.e)
 
+const
+  JitStackStart = 32 * 1024
+  JitStackMax = 1024 * 1024
+
+var jitStack {.threadvar.}: ptr JitStack
+
+proc threadJitStack(data: pointer): ptr JitStack {.cdecl.} =
+  # PCRE asks for the stack right before a JIT match starts. A JIT stack
+  # must not be used by two matches at the same time, so every thread gets
+  # its own one. If the allocation fails PCRE falls back to its small
+  # default stack on the machine stack.
+  if jitStack == nil:
+    jitStack = pcre.jit_stack_alloc(JitStackStart, JitStackMax)
+  result = jitStack
+
 proc re*(s: string, flags = {reStudy}): Regex =
   ## Constructor of regular expressions.
   ##
@@ -122,6 +137,8 @@ proc re*(s: string, flags = {reStudy}): Regex =
         options = pcre.STUDY_JIT_COMPILE
     result.e = pcre.study(result.h, options, addr msg)
     if not isNil(msg): raiseInvalidRegex($msg)
+    if options != 0 and not isNil(result.e):
+      pcre.assign_jit_stack(result.e, threadJitStack, nil)
 
 proc rex*(s: string, flags = {reStudy, reExtended}): Regex =
   ## Constructor for extended regular expressions.
@@ -130,6 +147,52 @@ proc rex*(s: string, flags = {reStudy, reExtended}): Regex =
   ## whitespace are ignored.
   result = re(s, flags)
 
+const reCacheSize {.intdefine.} = 64
+  ## number of compiled patterns `cachedRe` keeps per thread.
+
+type
+  RegexCacheEntry = object
+    key: (string, set[RegexFlag])
+    regex: Regex
+    lastUse: int
+
+var
+  regexCache {.threadvar.}: seq[RegexCacheEntry]
+  regexCacheIndex {.threadvar.}: Table[(string, set[RegexFlag]), int]
+  regexCacheClock {.threadvar.}: int
+
+proc cachedRe*(s: string, flags = {reStudy}): Regex =
+  ## Like `re`, but looks `s` up in a cache of recently compiled patterns
+  ## first, so building a regular expression from a runtime string inside
+  ## a loop does not recompile it every time.
+  ##
+  ## The cache keeps the `reCacheSize` (default 64, change it with
+  ## `-d:reCacheSize=N`) least recently used patterns. It is thread local:
+  ## `Regex` is a `ref` and must not be shared between threads, so every
+  ## thread compiles and caches its own copy.
+  runnableExamples:
+    for line in ["a=1", "b=2"]:
+      doAssert line.match(cachedRe"\w+=\d+")
+    doAssert cachedRe"\w+=\d+" == cachedRe"\w+=\d+"
+  let key = (s, flags)
+  inc regexCacheClock
+  let i = regexCacheIndex.getOrDefault(key, -1)
+  if i >= 0:
+    regexCache[i].lastUse = regexCacheClock
+    return regexCache[i].regex
+  result = re(s, flags)
+  let entry = RegexCacheEntry(key: key, regex: result, lastUse: regexCacheClock)
+  if regexCache.len < max(reCacheSize, 1):
+    regexCacheIndex[key] = regexCache.len
+    regexCache.add entry
+  else:
+    var victim = 0
+    for j in 1..<regexCache.len:
+      if regexCache[j].lastUse < regexCache[victim].lastUse: victim = j
+    regexCacheIndex.del regexCache[victim].key
+    regexCacheIndex[key] = victim
+    regexCache[victim] = entry
+
 proc bufSubstr(b: cstring, sPos, ePos: int): string {.inline.} =
   ## Return a Nim string built from a slice of a cstring buffer.
   ## Don't assume cstring is '\0' terminated
@@ -198,22 +261,17 @@ proc findBounds*(s: string, pattern: Regex, matches: var openArray[string],
   result = findBounds(cstring(s), pattern, matches,
       min(start, MaxReBufSize), min(s.len, MaxReBufSize))
 
-proc findBounds*(buf: cstring, pattern: Regex,
-                 matches: var openArray[tuple[first, last: int]],
-                 start = 0, bufSize: int): tuple[first, last: int] =
-  ## returns the starting position and end position of `pattern` in `buf`
-  ## (where `buf` has length `bufSize` and is not necessarily `'\0'` terminated),
-  ## and the captured substrings in the array `matches`.
-  ## If it does not match, nothing is written into `matches` and
-  ## `(-1,0)` is returned.
-  ##
-  ## .. note:: The memory for `matches` needs to be allocated before this function is called, otherwise it will just remain empty.
+proc execBounds(buf: cstring, pattern: Regex,
+                matches: var openArray[tuple[first, last: int]],
+                start, bufSize, flags: cint): tuple[first, last: int] =
+  # Like `matchOrFind`, but only records where the captures are instead of
+  # copying them into new strings. On failure `first` is the PCRE error code.
   var
     rtarray = initRtArray[cint]((matches.len+1)*3)
     rawMatches = rtarray.getRawData
-    res = pcre.exec(pattern.h, pattern.e, buf, bufSize.cint, start.cint, 0'i32,
+    res = pcre.exec(pattern.h, pattern.e, buf, bufSize, start, flags,
       cast[ptr cint](rawMatches), (matches.len+1).cint*3)
-  if res < 0'i32: return (-1, 0)
+  if res < 0'i32: return (int(res), 0)
   for i in 1..int(res)-1:
     var a = rawMatches[i * 2]
     var b = rawMatches[i * 2 + 1]
@@ -221,6 +279,19 @@ proc findBounds*(buf: cstring, pattern: Regex,
     else: matches[i-1] = (-1,0)
   return (rawMatches[0].int, rawMatches[1].int - 1)
 
+proc findBounds*(buf: cstring, pattern: Regex,
+                 matches: var openArray[tuple[first, last: int]],
+                 start = 0, bufSize: int): tuple[first, last: int] =
+  ## returns the starting position and end position of `pattern` in `buf`
+  ## (where `buf` has length `bufSize` and is not necessarily `'\0'` terminated),
+  ## and the captured substrings in the array `matches`.
+  ## If it does not match, nothing is written into `matches` and
+  ## `(-1,0)` is returned.
+  ##
+  ## .. note:: The memory for `matches` needs to be allocated before this function is called, otherwise it will just remain empty.
+  result = execBounds(buf, pattern, matches, start.cint, bufSize.cint, 0'i32)
+  if result.first < 0: result = (-1, 0)
+
 proc findBounds*(s: string, pattern: Regex,
                  matches: var openArray[tuple[first, last: int]],
                  start = 0): tuple[first, last: int] {.inline.} =
@@ -302,6 +373,25 @@ proc matchLen*(buf: cstring, pattern: Regex, matches: var openArray[string],
   ## .. note:: The memory for `matches` needs to be allocated before this function is called, otherwise it will just remain empty.
   return matchOrFind(buf, pattern, matches, start.cint, bufSize.cint, pcre.ANCHORED)
 
+proc matchLen*(s: string, pattern: Regex,
+               matches: var openArray[tuple[first, last: int]],
+               start = 0): int {.inline.} =
+  ## the same as `matchLen` with `matches: var openArray[string]`, but
+  ## the captures are returned as `(first, last)` bounds into `s` instead of
+  ## new strings, so no allocation happens per match. Captures that did not
+  ## participate in the match are set to `(-1, 0)`.
+  ##
+  ## .. note:: The memory for `matches` needs to be allocated before this function is called, otherwise it will just remain empty.
+  runnableExamples:
+    var matches: array[2, tuple[first, last: int]]
+    doAssert matchLen("key=value", re"(\w+)=(\w+)", matches) == 9
+    doAssert matches[0] == (0, 2)
+    doAssert matches[1] == (4, 8)
+  let res = execBounds(cstring(s), pattern, matches,
+    min(start, MaxReBufSize).cint, min(s.len, MaxReBufSize).cint, pcre.ANCHORED)
+  if res.first < 0: result = res.first
+  else: result = res.last - res.first + 1
+
 proc matchLen*(s: string, pattern: Regex, start = 0): int {.inline.} =
   ## the same as `match`, but it returns the length of the match,
   ## if there is no match, `-1` is returned. Note that a match length
@@ -338,6 +428,17 @@ proc match*(s: string, pattern: Regex, matches: var openArray[string],
       doAssert toSeq(matches) == @["d", "g"]
   result = matchLen(cstring(s), pattern, matches, start, s.len) != -1
 
+proc match*(s: string, pattern: Regex,
+            matches: var openArray[tuple[first, last: int]],
+            start = 0): bool {.inline.} =
+  ## returns `true` if `s[start..]` matches the `pattern` and
+  ## the bounds of the captured substrings in the array `matches`.
+  ## If it does not match, nothing is written into `matches` and `false` is
+  ## returned.
+  ##
+  ## .. note:: The memory for `matches` needs to be allocated before this function is called, otherwise it will just remain empty.
+  result = matchLen(s, pattern, matches, start) != -1
+
 proc match*(buf: cstring, pattern: Regex, matches: var openArray[string],
            start = 0, bufSize: int): bool {.inline.} =
   ## returns `true` if `buf[start..<bufSize]` matches the `pattern` and
@@ -379,6 +480,21 @@ proc find*(s: string, pattern: Regex, matches: var openArray[string],
   ## .. note:: The memory for `matches` needs to be allocated before this function is called, otherwise it will just remain empty.
   result = find(cstring(s), pattern, matches, start, s.len)
 
+proc find*(s: string, pattern: Regex,
+           matches: var openArray[tuple[first, last: int]],
+           start = 0): int {.inline.} =
+  ## returns the starting position of `pattern` in `s` and the bounds of
+  ## the captured substrings in the array `matches`. If it does not match,
+  ## nothing is written into `matches` and `-1` is returned.
+  ##
+  ## .. note:: The memory for `matches` needs to be allocated before this function is called, otherwise it will just remain empty.
+  runnableExamples:
+    var matches: array[1, tuple[first, last: int]]
+    doAssert find("GET /index.html", re"/(\w+)", matches) == 4
+    doAssert matches[0] == (5, 9)
+  result = execBounds(cstring(s), pattern, matches,
+    min(start, MaxReBufSize).cint, min(s.len, MaxReBufSize).cint, 0'i32).first
+
 proc find*(buf: cstring, pattern: Regex, start = 0, bufSize: int): int =
   ## returns the starting position of `pattern` in `buf`,
   ## where `buf` has length `bufSize` (not necessarily `'\0'` terminated).
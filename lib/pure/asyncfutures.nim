@@ -19,12 +19,13 @@ when defined(nimPreviewSlimSystem):
 type
   CallbackFunc = proc () {.closure, gcsafe.}
 
-  CallbackList = object
+  CallbackList = object               # the first callback is stored inline
     function: CallbackFunc
     next: owned(ref CallbackList)
 
   FutureBase* = ref object of RootObj  ## Untyped future.
     callbacks: CallbackList
+    continuation: CallbackFunc         # resumes the async proc of this future
 
     finished: bool
     error*: ref Exception              ## Stored exception
@@ -36,6 +37,7 @@ type
 
   Future*[T] = ref object of FutureBase ## Typed future.
     value: T                            ## Stored value
+    iter: iterator (f: Future[T]): owned(FutureBase) # the suspended async proc
 
   FutureVar*[T] = distinct Future[T]
 
@@ -163,7 +165,8 @@ proc checkFinished[T](future: Future[T]) =
       raise err
 
 proc call(callbacks: var CallbackList) =
-  var current = callbacks
+  # callback will be called only once, let GC collect them afterwards
+  var current = move callbacks
   while true:
     if not current.function.isNil:
       callSoon(current.function)
@@ -172,9 +175,6 @@ proc call(callbacks: var CallbackList) =
       break
     else:
       current = current.next[]
-  # callback will be called only once, let GC collect them now
-  callbacks.next = nil
-  callbacks.function = nil
 
 proc add(callbacks: var CallbackList, function: CallbackFunc) =
   if callbacks.function.isNil:
@@ -200,6 +200,8 @@ proc completeImpl[T, U](future: Future[T], val: sink U, isVoid: static bool) =
   when not isVoid:
     future.value = val
   future.finished = true
+  future.continuation = nil
+  future.iter = nil
   future.callbacks.call()
   when isFutureLoggingEnabled: logFutureFinish(future)
 
@@ -236,12 +238,38 @@ proc fail*[T](future: Future[T], error: ref Exception) =
   #assert(not future.finished, "Future already finished, cannot finish twice.")
   checkFinished(future)
   future.finished = true
+  future.continuation = nil
+  future.iter = nil
   future.error = error
   future.errorStackTrace =
     if getStackTrace(error) == "": getStackTrace() else: getStackTrace(error)
   future.callbacks.call()
   when isFutureLoggingEnabled: logFutureFinish(future)
 
+proc setAsyncContinuation*(future: FutureBase, cb: proc () {.closure, gcsafe.}) =
+  ## For internal usage. Do not use.
+  ##
+  ## Sets the callback that resumes the async proc which completes `future`
+  ## after an `await`. It is created once per call, and dropped when
+  ## `future` completes, so that suspending does not allocate.
+  future.continuation = cb
+
+proc asyncContinuation*(future: FutureBase): (proc () {.closure, gcsafe.}) =
+  ## For internal usage. Do not use.
+  future.continuation
+
+proc parkAsyncIterator*[T](future: Future[T],
+                           it: iterator (f: Future[T]): owned(FutureBase)) =
+  ## For internal usage. Do not use.
+  ##
+  ## Keeps the state machine of the async proc that completes `future`
+  ## while it waits for another future.
+  future.iter = it
+
+proc takeAsyncIterator*[T](future: Future[T]): iterator (f: Future[T]): owned(FutureBase) =
+  ## For internal usage. Do not use.
+  result = move future.iter
+
 proc clearCallbacks*(future: FutureBase) =
   future.callbacks.function = nil
   future.callbacks.next = nil
@@ -313,7 +341,7 @@ proc isInternal(entry: StackTraceEntry): bool =
 
 proc `$`*(stackTraceEntries: seq[StackTraceEntry]): string =
   result = ""
-  when defined(nimStackTraceOverride):
+  when defined(nimStackTraceOverride) or defined(nimNativeStackTraces):
     let entries = addDebuggingInfo(stackTraceEntries)
   else:
     let entries = stackTraceEntries
@@ -26,7 +26,7 @@ type
   ClosureIt[T] = iterator(f: Future[T]): owned(FutureBase)
 
 template createCb(futTyp, strName, identName, futureVarCompletions: untyped) =
-  bind finished
+  bind finished, parkAsyncIterator, asyncContinuation
   {.push stackTrace: off.}
   proc identName(fut: Future[futTyp], it: ClosureIt[futTyp]) {.effectsOf: it.} =
     try:
@@ -43,9 +43,9 @@ template createCb(futTyp, strName, identName, futureVarCompletions: untyped) =
             let msg = "Async procedure ($1) yielded `nil`, are you await'ing a `nil` Future?"
             raise newException(AssertionDefect, msg % strName)
         else:
-          {.gcsafe.}:
-            next.addCallback(cast[proc() {.closure, gcsafe.}](proc =
-              identName(fut, it)))
+          # the state machine waits in `fut`, its continuation resumes it
+          parkAsyncIterator(fut, it)
+          next.addCallback(asyncContinuation(fut))
     except:
       futureVarCompletions
       if fut.finished:
@@ -270,6 +270,14 @@ proc asyncSingleProc(prc: NimNode): NimNode =
       {.pop.}
 
       var `needsCompletionSym` = false
+    # -> setAsyncContinuation(retFutParam, proc () = cb(retFutParam, ...))
+    # The continuation captures only the iterator's parameter and thus shares
+    # the iterator's environment, awaiting a future does not allocate.
+    var cbName = genSym(nskProc, prcName & NimAsyncContinueSuffix)
+    procBody.insert(0): quote do:
+      {.gcsafe.}:
+        setAsyncContinuation(`retFutParamSym`, cast[proc() {.closure, gcsafe.}](proc =
+          `cbName`(`retFutParamSym`, takeAsyncIterator(`retFutParamSym`))))
     procBody.add quote do:
       complete(`retFutParamSym`, `resultIdent`)
 
@@ -283,19 +291,19 @@ proc asyncSingleProc(prc: NimNode): NimNode =
     # If proc has an explicit gcsafe pragma, we add it to iterator as well.
     if prc.pragma.findChild(it.kind in {nnkSym, nnkIdent} and $it == "gcsafe") != nil:
       closureIterator.addPragma(newIdentNode("gcsafe"))
-    outerProcBody.add(closureIterator)
 
     # -> createCb()
     # NOTE: The NimAsyncContinueSuffix is checked for in asyncfutures.nim to produce
     # friendlier stack traces:
-    var cbName = genSym(nskProc, prcName & NimAsyncContinueSuffix)
     var procCb = getAst createCb(
       subRetType,
       newStrLitNode(prcName),
       cbName,
       createFutureVarCompletions(futureVarIdents, nil)
     )
+    # the iterator refers to the callback
     outerProcBody.add procCb
+    outerProcBody.add(closureIterator)
 
     # -> var retFuture = newFuture[T]()
     let retFutureSym = genSym(nskVar, "retFuture")
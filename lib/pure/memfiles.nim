@@ -530,6 +530,15 @@ proc mmsPeekData(s: Stream, buffer: pointer, bufLen: int): int =
   moveMem(buffer, cast[pointer](startAddress + p), l)
   result = l
 
+proc mmsPeekSlice(s: Stream, bufLen: int): StreamSlice =
+  let p = MemMapFileStream(s).pos
+  result = StreamSlice(len: min(bufLen, MemMapFileStream(s).mf.size - p))
+  if result.len > 0:
+    result.data = cast[ptr UncheckedArray[byte]](
+      cast[int](MemMapFileStream(s).mf.mem) + p)
+  else:
+    result.len = 0
+
 proc mmsReadData(s: Stream, buffer: pointer, bufLen: int): int =
   result = mmsPeekData(s, buffer, bufLen)
   inc(MemMapFileStream(s).pos, result)
@@ -562,6 +571,7 @@ proc newMemMapFileStream*(filename: string, mode: FileMode = fmRead,
     getPositionImpl: mmsGetPosition,
     readDataImpl: mmsReadData,
     peekDataImpl: mmsPeekData,
+    peekSliceImpl: mmsPeekSlice,
     writeDataImpl: mmsWriteData,
     flushImpl: mmsFlush
   )
@@ -338,6 +338,168 @@ proc countProcessors*(): int {.rtl, extern: "nosp$1", raises: [].} =
 when not defined(nimHasEffectsOf):
   {.pragma: effectsOf.}
 
+when not defined(windows):
+  type
+    CapturedOutput = object
+      ## Output of a process started by `execProcesses`, read while it runs.
+      fds: array[2, cint]  ## stdout and stderr; -1 when closed or not used
+      data: array[2, string]
+      pidfd: cint          ## readable once the process exits; -1 if the
+                           ## system has no pidfds
+
+  when defined(linux) and (defined(amd64) or defined(i386) or defined(arm) or
+      defined(arm64) or defined(riscv32) or defined(riscv64) or
+      defined(powerpc64) or defined(powerpc64el) or defined(loongarch64)):
+    proc syscall(nr: clong): clong {.varargs, importc, header: "<unistd.h>".}
+
+    const sysPidfdOpen = clong(434)
+      ## `pidfd_open` of Linux 5.3, the same number on these architectures;
+      ## older headers do not define it
+
+    proc pidfdOpen(pid: Pid): cint =
+      result = cint(syscall(sysPidfdOpen, cint(pid), cint(0)))
+  else:
+    proc pidfdOpen(pid: Pid): cint = -1
+
+  var
+    childPipe = [cint(-1), cint(-1)]
+      ## written by `onChild`, so that a `poll` wakes up when a child exits
+    oldChildAction: Sigaction
+
+  proc onChild(sig: cint) {.noconv.} =
+    let e = errno
+    var b = 'x'
+    discard write(childPipe[1], addr b, 1)
+    let old = oldChildAction.sa_handler
+    if old != SIG_DFL and old != SIG_IGN and
+        (oldChildAction.sa_flags and SA_SIGINFO) == 0:
+      old(sig)
+    errno = e
+
+  proc watchChildren() =
+    ## Installs `onChild` for SIGCHLD until `unwatchChildren`.
+    if childPipe[0] < 0:
+      var p: array[0..1, cint]
+      if pipe(p) != 0: raiseOSError(osLastError())
+      for fd in p:
+        discard fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) or O_NONBLOCK)
+        discard fcntl(fd, F_SETFD, FD_CLOEXEC)
+      childPipe = p
+    var act: Sigaction
+    act.sa_handler = onChild
+    discard sigemptyset(act.sa_mask)
+    act.sa_flags = SA_RESTART or SA_NOCLDSTOP
+    if sigaction(SIGCHLD, act, oldChildAction) != 0:
+      raiseOSError(osLastError())
+
+  proc unwatchChildren() =
+    discard sigaction(SIGCHLD, oldChildAction)
+
+  proc initCapture(p: Process): CapturedOutput =
+    result = CapturedOutput(fds: [cint(p.outHandle), cint(-1)],
+                            pidfd: pidfdOpen(p.id))
+    if poStdErrToStdOut notin p.options:
+      result.fds[1] = cint(p.errHandle)
+
+  proc finishCapture(p: Process, c: var CapturedOutput) =
+    ## Makes the captured output available through `outputStream` and
+    ## `errorStream`; the pipes are closed already.
+    p.outStream = newStringStream(move c.data[0])
+    p.errStream = if poStdErrToStdOut in p.options: p.outStream
+                  else: newStringStream(move c.data[1])
+
+  proc readCaptured(c: var CapturedOutput, k: int,
+                    buf: var array[8192, char]) =
+    ## Reads once from pipe `k` of `c` and closes it at the end of the file.
+    let got = read(c.fds[k], addr buf[0], buf.len)
+    if got > 0:
+      let old = c.data[k].len
+      c.data[k].setLen(old + got)
+      copyMem(addr c.data[k][old], addr buf[0], got)
+    elif got == 0 or errno != EINTR:
+      discard close(c.fds[k])
+      c.fds[k] = -1
+
+  proc drainCaptured(c: var CapturedOutput, buf: var array[8192, char]) =
+    ## Reads what an exited process left in its pipes and closes them. This
+    ## does not wait for the end of the file: a background grandchild may
+    ## still hold the pipes open.
+    for k in 0..1:
+      while c.fds[k] >= 0:
+        var fd = TPollfd(fd: c.fds[k], events: POLLIN)
+        let n = poll(addr fd, Tnfds(1), cint(0))
+        if n < 0 and osLastError() == OSErrorCode(EINTR): continue
+        if n <= 0:
+          discard close(c.fds[k])
+          c.fds[k] = -1
+        else:
+          readCaptured(c, k, buf)
+
+  proc waitCapturing(q: var seq[Process], cap: var seq[CapturedOutput]): int =
+    ## Reads the output of all running processes in `q` with a single `poll`
+    ## loop, so no child blocks on a full pipe, until one of them has exited.
+    ## Returns its index in `q`.
+    ##
+    ## An exit is not reported by the end of the output: a background
+    ## grandchild can keep the pipes open. So the poll set also contains the
+    ## pidfd of every process or, where there are none, a pipe written by a
+    ## SIGCHLD handler, and the wait has no timeout.
+    var fds = newSeq[TPollfd]()
+    var owners = newSeq[tuple[r, k: int]]() # k: the pipe; -1: the exit
+    var buf {.noinit.}: array[8192, char]
+    var watching = false
+    for r in 0..<q.len:
+      if q[r] != nil and cap[r].pidfd < 0: watching = true
+    # the handler is in place before the first `waitpid`, so no exit is missed
+    if watching: watchChildren()
+    try:
+      while true:
+        fds.setLen 0
+        owners.setLen 0
+        for r in 0..<q.len:
+          if q[r] == nil: continue
+          var status: cint = 1
+          let res = waitpid(q[r].id, status, WNOHANG)
+          if res == q[r].id:
+            if WIFEXITED(status) or WIFSIGNALED(status):
+              q[r].exitFlag = true
+              q[r].exitStatus = status
+              if cap[r].pidfd >= 0:
+                discard close(cap[r].pidfd)
+                cap[r].pidfd = -1
+              drainCaptured(cap[r], buf)
+              return r
+          elif res < 0:
+            # ECHILD means the child was reaped elsewhere and will never be
+            # reported here; every error but EINTR is final
+            let err = osLastError()
+            if err != OSErrorCode(EINTR): raiseOSError(err)
+          if cap[r].pidfd >= 0:
+            fds.add TPollfd(fd: cap[r].pidfd, events: POLLIN)
+            owners.add (r, -1)
+          for k in 0..1:
+            if cap[r].fds[k] >= 0:
+              fds.add TPollfd(fd: cap[r].fds[k], events: POLLIN)
+              owners.add (r, k)
+        if watching:
+          fds.add TPollfd(fd: childPipe[0], events: POLLIN)
+          owners.add (-1, -1)
+        let n = poll(addr fds[0], Tnfds(fds.len), cint(-1))
+        if n < 0:
+          let err = osLastError()
+          if err == OSErrorCode(EINTR): continue
+          raiseOSError(err)
+        for i in 0..<fds.len:
+          if fds[i].revents != 0:
+            let (r, k) = owners[i]
+            if r < 0:
+              while read(childPipe[0], addr buf[0], buf.len) > 0: discard
+            elif k >= 0:
+              readCaptured(cap[r], k, buf)
+            # an exit is picked up by `waitpid` in the next round
+    finally:
+      if watching: unwatchChildren()
+
 proc execProcesses*(cmds: openArray[string],
     options = {poStdErrToStdOut, poParentStreams}, n = countProcessors(),
     beforeRunEvent: proc(idx: int) = nil,
@@ -351,6 +513,14 @@ proc execProcesses*(cmds: openArray[string],
   ##
   ## The highest (absolute) return value of all processes is returned.
   ## Runs `beforeRunEvent` before running each command.
+  ##
+  ## On POSIX, when `poParentStreams` is not in `options` and `n > 1`, the
+  ## output of all running processes is read in one `poll` loop while
+  ## waiting, so a process never blocks on a full pipe; `afterRunEvent`
+  ## then gets the complete output from `outputStream` and `errorStream`.
+  ## Without Linux pidfds, a SIGCHLD handler is installed during the wait,
+  ## so `execProcesses` must not run in two threads at once; a handler that
+  ## was installed before is still called.
   result = 0
   assert n > 0
   if n > 1:
@@ -364,6 +534,10 @@ proc execProcesses*(cmds: openArray[string],
       var wcount = m
     else:
       var m = min(n, cmds.len)
+      # Without `poParentStreams` the children write into pipes; those are
+      # drained while waiting and handed to `afterRunEvent` as string streams.
+      let capture = poParentStreams notin options
+      var cap = newSeq[CapturedOutput](if capture: n else: 0)
 
     while i < m:
       if beforeRunEvent != nil:
@@ -372,6 +546,8 @@ proc execProcesses*(cmds: openArray[string],
       idxs[i] = i
       when defined(windows):
         w[i] = q[i].fProcessHandle
+      else:
+        if capture: cap[i] = initCapture(q[i])
       inc(i)
 
     var ecount = len(cmds)
@@ -396,33 +572,37 @@ proc execProcesses*(cmds: openArray[string],
               rexit = r
               break
       else:
-        var status: cint = 1
-        # waiting for all children, get result if any child exits
-        let res = waitpid(-1, status, 0)
-        if res > 0:
-          for r in 0..m-1:
-            if not isNil(q[r]) and q[r].id == res:
-              if WIFEXITED(status) or WIFSIGNALED(status):
-                q[r].exitFlag = true
-                q[r].exitStatus = status
-                rexit = r
-                break
+        if capture:
+          rexit = waitCapturing(q, cap)
+          finishCapture(q[rexit], cap[rexit])
         else:
-          let err = osLastError()
-          if err == OSErrorCode(ECHILD):
-            # some child exits, we need to check our childs exit codes
+          var status: cint = 1
+          # waiting for all children, get result if any child exits
+          let res = waitpid(-1, status, 0)
+          if res > 0:
             for r in 0..m-1:
-              if (not isNil(q[r])) and (not running(q[r])):
-                q[r].exitFlag = true
-                q[r].exitStatus = status
-                rexit = r
-                break
-          elif err == OSErrorCode(EINTR):
-            # signal interrupted our syscall, lets repeat it
-            continue
+              if not isNil(q[r]) and q[r].id == res:
+                if WIFEXITED(status) or WIFSIGNALED(status):
+                  q[r].exitFlag = true
+                  q[r].exitStatus = status
+                  rexit = r
+                  break
           else:
-            # all other errors are exceptions
-            raiseOSError(err)
+            let err = osLastError()
+            if err == OSErrorCode(ECHILD):
+              # some child exits, we need to check our childs exit codes
+              for r in 0..m-1:
+                if (not isNil(q[r])) and (not running(q[r])):
+                  q[r].exitFlag = true
+                  q[r].exitStatus = status
+                  rexit = r
+                  break
+            elif err == OSErrorCode(EINTR):
+              # signal interrupted our syscall, lets repeat it
+              continue
+            else:
+              # all other errors are exceptions
+              raiseOSError(err)
 
       if rexit >= 0:
         when defined(windows):
@@ -437,6 +617,8 @@ proc execProcesses*(cmds: openArray[string],
           idxs[rexit] = i
           when defined(windows):
             w[rexit] = q[rexit].fProcessHandle
+          else:
+            if capture: cap[rexit] = initCapture(q[rexit])
           inc(i)
         else:
           when defined(windows):
@@ -946,10 +1128,14 @@ elif not defined(useNimRtl):
 
   const useProcessAuxSpawn = declared(posix_spawn) and not defined(useFork) and
                              not defined(useClone) and not defined(linux)
-  when useProcessAuxSpawn:
+    # On Linux `posix_spawn` is only used when no `workingDir` is requested,
+    # see `startProcess`; otherwise the fork based version is needed too.
+  const useLinuxSpawn = declared(posix_spawn) and not defined(useFork) and
+                        not defined(useClone) and defined(linux)
+  when useProcessAuxSpawn or useLinuxSpawn:
     proc startProcessAuxSpawn(data: StartProcessData): Pid {.
       raises: [OSError], tags: [ExecIOEffect, ReadEnvEffect, ReadDirEffect, RootEffect], gcsafe.}
-  else:
+  when not useProcessAuxSpawn:
     proc startProcessAuxFork(data: StartProcessData): Pid {.
       raises: [OSError], tags: [ExecIOEffect, ReadEnvEffect, ReadDirEffect, RootEffect], gcsafe.}
     {.push stacktrace: off, profiler: off.}
@@ -1012,6 +1198,15 @@ elif not defined(useNimRtl):
       pid = startProcessAuxSpawn(data)
       if workingDir.len > 0:
         setCurrentDir(currentDir)
+    elif useLinuxSpawn:
+      # glibc (2.24+) and musl spawn with vfork semantics and report exec
+      # failures, so a big parent like the compiler does not pay for copying
+      # its page tables. Changing the directory would affect the whole
+      # process though, so that still needs fork.
+      if workingDir.len == 0:
+        pid = startProcessAuxSpawn(data)
+      else:
+        pid = startProcessAuxFork(data)
     else:
       pid = startProcessAuxFork(data)
 
@@ -1041,7 +1236,7 @@ elif not defined(useNimRtl):
       discard close(pStdin[readIdx])
       discard close(pStdout[writeIdx])
 
-  when useProcessAuxSpawn:
+  when useProcessAuxSpawn or useLinuxSpawn:
     proc startProcessAuxSpawn(data: StartProcessData): Pid =
       var attr: Tposix_spawnattr
       var fops: Tposix_spawn_file_actions
@@ -1092,7 +1287,8 @@ elif not defined(useNimRtl):
       if res != 0'i32: raiseOSError(OSErrorCode(res), data.sysCommand)
 
       return pid
-  else:
+
+  when not useProcessAuxSpawn:
     proc startProcessAuxFork(data: StartProcessData): Pid =
       if pipe(data.pErrorPipe) != 0:
         raiseOSError(osLastError())
@@ -10,7 +10,8 @@
 ## This module provides a stream interface and two implementations thereof:
 ## the `FileStream <#FileStream>`_ and the `StringStream <#StringStream>`_
 ## which implement the stream interface for Nim file objects (`File`) and
-## strings.
+## strings. A `BufferedStream <#BufferedStream>`_ adds a read buffer to any
+## other stream.
 ##
 ## Other modules may provide other implementations for this standard
 ## stream interface.
@@ -110,6 +111,13 @@ proc newEIO(msg: string): owned(ref IOError) =
   result.msg = msg
 
 type
+  StreamSlice* = object
+    ## A view of bytes owned by a stream, as returned by
+    ## `peekSlice <#peekSlice,Stream,int>`_. It stays valid until the
+    ## stream is read from, written to, repositioned or closed.
+    data*: ptr UncheckedArray[byte]
+    len*: int
+
   Stream* = ref StreamObj
     ## All procedures of this module use this type.
     ## Procedures don't directly use `StreamObj <#StreamObj>`_.
@@ -144,6 +152,24 @@ type
     flushImpl*: proc (s: Stream)
       {.nimcall, raises: [Defect, IOError, OSError], tags: [WriteIOEffect], gcsafe.}
 
+    peekSliceImpl*: proc (s: Stream, bufLen: int): StreamSlice
+      {.nimcall, raises: [Defect, IOError, OSError], tags: [ReadIOEffect], gcsafe.}
+      ## Optional; only for streams that keep their data in memory.
+
+  BufferedStream* = ref BufferedStreamObj
+    ## A stream that reads another stream in large blocks and serves
+    ## small reads from its buffer.
+    ##
+    ## **Note:** Not available for JS backend.
+  BufferedStreamObj* = object of StreamObj
+    ## A buffered stream object.
+    ##
+    ## **Note:** Not available for JS backend.
+    source: Stream
+    buf: seq[byte]
+    first, last: int ## unread data is `buf[first..<last]`
+    pos: int ## position of `buf[first]` in `source`
+
 proc flush*(s: Stream) =
   ## Flushes the buffers that the stream `s` might use.
   ##
@@ -326,6 +352,61 @@ proc peekData*(s: Stream, buffer: pointer, bufLen: int): int =
 
   result = s.peekDataImpl(s, buffer, bufLen)
 
+when not defined(js):
+  proc readInto*(s: Stream, buffer: var openArray[byte]): int {.since: (2, 3).} =
+    ## Reads up to `buffer.len` bytes from the stream `s` directly into
+    ## `buffer` and returns the number of bytes read.
+    ##
+    ## **Note:** Not available for JS backend.
+    ##
+    ## See also:
+    ## * `peekSlice proc <#peekSlice,Stream,int>`_
+    runnableExamples:
+      var strm = newStringStream("abcde")
+      var buffer: array[3, byte]
+      doAssert strm.readInto(buffer) == 3
+      doAssert buffer == [byte 'a', byte 'b', byte 'c']
+      doAssert strm.readInto(buffer) == 2
+      strm.close()
+
+    if buffer.len > 0:
+      result = readData(s, addr buffer[0], buffer.len)
+    else:
+      result = 0
+
+  proc peekSlice*(s: Stream, n: int): StreamSlice {.since: (2, 3).} =
+    ## Returns a view of the next `n` bytes of the stream `s` without
+    ## copying them and without moving the stream position. The view is
+    ## shorter than `n` at the end of the stream.
+    ##
+    ## The view points into the stream's own memory and is only valid until
+    ## the next operation on `s`. It is supported by `StringStream`,
+    ## `BufferedStream` and `MemMapFileStream`; other streams, such as a
+    ## `FileStream`, can be wrapped with
+    ## `newBufferedStream <#newBufferedStream,Stream,int>`_.
+    ##
+    ## **Note:** Not available for JS backend.
+    runnableExamples:
+      var strm = newStringStream("abcde")
+      let v = strm.peekSlice(2)
+      doAssert v.len == 2 and char(v.data[1]) == 'b'
+      strm.skip(v.len)
+      doAssert strm.readStr(3) == "cde"
+      doAssert strm.peekSlice(4).len == 0
+      strm.close()
+
+    if s.peekSliceImpl == nil:
+      raise newEIO("stream does not support peekSlice")
+    result = s.peekSliceImpl(s, n)
+
+  template toOpenArray*(x: StreamSlice): untyped =
+    ## Accesses the bytes of `x` as an `openArray[byte]`.
+    toOpenArray(x.data, 0, x.len - 1)
+
+proc skip*(s: Stream, n: int) {.since: (2, 3).} =
+  ## Moves the position of the stream `s` forward by `n` bytes.
+  setPosition(s, getPosition(s) + n)
+
 proc writeData*(s: Stream, buffer: pointer, bufLen: int) =
   ## Low level proc that writes an untyped `buffer` of `bufLen` size
   ## to the stream `s`.
@@ -411,6 +492,18 @@ proc writeLine*(s: Stream, args: varargs[string, `$`]) =
   for str in args: write(s, str)
   write(s, "\n")
 
+template bufferedFastPath(s: Stream, dest: pointer, size: int, consume: bool) =
+  # Serves fixed-size reads of a `BufferedStream` without the indirect calls.
+  when not defined(js):
+    if s of BufferedStream:
+      let b = BufferedStream(s)
+      if b.last - b.first >= size:
+        copyMem(dest, addr b.buf[b.first], size)
+        when consume:
+          inc b.first, size
+          inc b.pos, size
+        return
+
 proc read*[T](s: Stream, result: var T) =
   ## Generic read procedure. Reads `result` from the stream `s`.
   ##
@@ -427,6 +520,7 @@ proc read*[T](s: Stream, result: var T) =
     doAssert buffer == ['1', '2']
     strm.close()
 
+  bufferedFastPath(s, addr(result), sizeof(T), consume = true)
   if readData(s, addr(result), sizeof(T)) != sizeof(T):
     raise newEIO("cannot read from stream")
 
@@ -446,6 +540,7 @@ proc peek*[T](s: Stream, result: var T) =
     doAssert buffer == ['0', '1']
     strm.close()
 
+  bufferedFastPath(s, addr(result), sizeof(T), consume = false)
   if peekData(s, addr(result), sizeof(T)) != sizeof(T):
     raise newEIO("cannot read from stream")
 
@@ -468,6 +563,7 @@ proc readChar*(s: Stream): char =
     if readDataStr(s, str, 0..0) != 1: result = '\0'
     else: result = str[0]
   do:
+    bufferedFastPath(s, addr(result), 1, consume = true)
     if readData(s, addr(result), sizeof(result)) != 1: result = '\0'
 
 proc peekChar*(s: Stream): char =
@@ -487,6 +583,7 @@ proc peekChar*(s: Stream): char =
     if peekData(s, addr(str), sizeof(result)) != 1: result = '\0'
     else: result = str[0]
   else:
+    bufferedFastPath(s, addr(result), 1, consume = false)
     if peekData(s, addr(result), sizeof(result)) != 1: result = '\0'
 
 proc readBool*(s: Stream): bool =
@@ -1264,6 +1361,15 @@ else: # after 1.3 or JS not defined
     else:
       result = 0
 
+  when not defined(js):
+    proc ssPeekSlice(s: Stream, bufLen: int): StreamSlice =
+      var s = StringStream(s)
+      result = StreamSlice(len: min(bufLen, s.data.len - s.pos))
+      if result.len > 0:
+        result.data = cast[ptr UncheckedArray[byte]](addr s.data[s.pos])
+      else:
+        result.len = 0
+
   proc ssWriteData(s: Stream, buffer: pointer, bufLen: int) =
     var s = StringStream(s)
     if bufLen <= 0:
@@ -1320,6 +1426,8 @@ else: # after 1.3 or JS not defined
       result.readDataImpl = ssReadData
       result.peekDataImpl = ssPeekData
       result.writeDataImpl = ssWriteData
+      when not defined(js):
+        result.peekSliceImpl = ssPeekSlice
 
 type
   FileStream* = ref FileStreamObj
@@ -1475,6 +1583,168 @@ proc openFileStream*(filename: string, mode: FileMode = fmRead,
   else:
     raise newEIO("cannot open file stream: " & filename)
 
+when not defined(js):
+  proc bsFill(b: BufferedStream, n: int): int =
+    ## Makes at least `n` bytes available in the buffer unless the source
+    ## ends first. Returns the number of bytes available.
+    result = b.last - b.first
+    if result >= n: return
+    if b.first > 0:
+      if result > 0: moveMem(addr b.buf[0], addr b.buf[b.first], result)
+      b.first = 0
+      b.last = result
+    if n > b.buf.len: b.buf.setLen(n)
+    while b.last < n:
+      let r = readData(b.source, addr b.buf[b.last], b.buf.len - b.last)
+      if r <= 0: break
+      inc b.last, r
+    result = b.last
+
+  proc bsDiscardBuffer(b: BufferedStream) =
+    # the source is ahead by the unread part of the buffer
+    if b.last > b.first: setPosition(b.source, b.pos)
+    b.first = 0
+    b.last = 0
+
+  proc bsClose(s: Stream) =
+    let b = BufferedStream(s)
+    if b.source != nil:
+      close(b.source)
+      b.source = nil
+    b.buf = @[]
+    b.first = 0
+    b.last = 0
+
+  proc bsFlush(s: Stream) = flush(BufferedStream(s).source)
+
+  proc bsAtEnd(s: Stream): bool =
+    let b = BufferedStream(s)
+    result = b.first == b.last and atEnd(b.source)
+
+  proc bsSetPosition(s: Stream, pos: int) =
+    let b = BufferedStream(s)
+    if pos >= b.pos - b.first and pos <= b.pos + b.last - b.first:
+      # still inside the buffer, the source does not have to move
+      b.first += pos - b.pos
+    else:
+      setPosition(b.source, pos)
+      b.first = 0
+      b.last = 0
+    b.pos = pos
+
+  proc bsGetPosition(s: Stream): int = BufferedStream(s).pos
+
+  proc bsPeekData(s: Stream, buffer: pointer, bufLen: int): int =
+    let b = BufferedStream(s)
+    result = min(bufLen, bsFill(b, bufLen))
+    if result > 0:
+      copyMem(buffer, addr b.buf[b.first], result)
+    else:
+      result = 0
+
+  proc bsReadData(s: Stream, buffer: pointer, bufLen: int): int =
+    let b = BufferedStream(s)
+    result = min(bufLen, b.last - b.first)
+    if result > 0:
+      copyMem(buffer, addr b.buf[b.first], result)
+      inc b.first, result
+    else:
+      result = 0
+    let rest = bufLen - result
+    if rest > 0:
+      let dest = cast[pointer](cast[int](buffer) + result)
+      if rest >= b.buf.len:
+        # large reads go straight into the caller's buffer
+        b.first = 0
+        b.last = 0
+        inc result, max(readData(b.source, dest, rest), 0)
+      else:
+        let n = min(rest, bsFill(b, rest))
+        if n > 0:
+          copyMem(dest, addr b.buf[b.first], n)
+          inc b.first, n
+          inc result, n
+    inc b.pos, result
+
+  proc bsReadLine(s: Stream, line: var string): bool =
+    let b = BufferedStream(s)
+    line.setLen(0)
+    result = false
+    while b.first < b.last or bsFill(b, 1) > 0:
+      result = true
+      var i = b.first
+      while i < b.last and b.buf[i] notin {byte '\L', byte '\c'}: inc i
+      let n = i - b.first
+      if n > 0:
+        let old = line.len
+        line.setLen(old + n)
+        copyMem(addr line[old], addr b.buf[b.first], n)
+      inc b.pos, i - b.first
+      b.first = i
+      if i < b.last:
+        let c = b.buf[i]
+        inc b.first
+        inc b.pos
+        if c == byte '\c' and (b.first < b.last or bsFill(b, 1) > 0) and
+            b.buf[b.first] == byte '\L':
+          inc b.first
+          inc b.pos
+        break
+
+  proc bsPeekSlice(s: Stream, bufLen: int): StreamSlice =
+    let b = BufferedStream(s)
+    result = StreamSlice(len: min(bufLen, bsFill(b, bufLen)))
+    if result.len > 0:
+      result.data = cast[ptr UncheckedArray[byte]](addr b.buf[b.first])
+    else:
+      result.len = 0
+
+  proc bsWriteData(s: Stream, buffer: pointer, bufLen: int) =
+    let b = BufferedStream(s)
+    bsDiscardBuffer(b)
+    writeData(b.source, buffer, bufLen)
+    inc b.pos, bufLen
+
+  proc newBufferedStream*(s: Stream, bufSize = 64 * 1024): owned BufferedStream {.
+      since: (2, 3).} =
+    ## Creates a stream that reads `s` in blocks of `bufSize` bytes. Small
+    ## reads like `readInt32 <#readInt32,Stream>`_ or `readChar
+    ## <#readChar,Stream>`_ are then served from memory, `readLine` scans the
+    ## buffer instead of reading character by character and `peekSlice
+    ## <#peekSlice,Stream,int>`_ hands out views of the buffer. Reads of at
+    ## least `bufSize` bytes bypass the buffer.
+    ##
+    ## Closing the buffered stream closes `s`. Writes go straight to `s`.
+    ##
+    ## **Note:** Not available for JS backend.
+    runnableExamples:
+      var strm = newBufferedStream(newStringStream("\x01rest\nof it"))
+      doAssert strm.readInt8() == 1
+      doAssert strm.peekSlice(4).len == 4
+      doAssert strm.readLine() == "rest"
+      doAssert strm.readAll() == "of it"
+      strm.close()
+
+    new(result)
+    result.source = s
+    result.buf = newSeq[byte](max(bufSize, 1))
+    if s.getPositionImpl != nil:
+      try:
+        result.pos = getPosition(s)
+      except IOError:
+        result.pos = 0 # not seekable, e.g. a pipe
+    result.closeImpl = bsClose
+    result.atEndImpl = bsAtEnd
+    result.setPositionImpl = bsSetPosition
+    result.getPositionImpl = bsGetPosition
+    result.readDataImpl = bsReadData
+    result.readLineImpl = bsReadLine
+    result.peekDataImpl = bsPeekData
+    result.peekSliceImpl = bsPeekSlice
+    result.writeDataImpl = bsWriteData
+    if s.flushImpl != nil:
+      result.flushImpl = bsFlush
+
 when false:
   type
     FileHandleStream* = ref FileHandleStreamObj
@@ -86,6 +86,46 @@ from std/private/strimpl import cmpIgnoreStyleImpl, cmpIgnoreCaseImpl,
 when defined(nimPreviewSlimSystem):
   import std/assertions
 
+when not (defined(js) or defined(nimdoc) or defined(nimscript)):
+  from system/ansi_c import c_memchr
+
+  const hasCStringBuiltin = true
+else:
+  const hasCStringBuiltin = false
+
+when defined(linux):
+  proc memmem(haystack: pointer, haystacklen: csize_t,
+              needle: pointer, needlelen: csize_t): pointer {.importc, header: """#define _GNU_SOURCE
+#include <string.h>""".}
+elif defined(bsd) or (defined(macosx) and not defined(ios)):
+  proc memmem(haystack: pointer, haystacklen: csize_t,
+              needle: pointer, needlelen: csize_t): pointer {.importc, header: "#include <string.h>".}
+
+when hasCStringBuiltin:
+  # Word-at-a-time ("SIMD within a register") helpers for the byte loops
+  # below. They process 8 bytes per step without any CPU specific code; the
+  # libc `memchr` and `memmem` used elsewhere bring their own vectorization.
+  const
+    swarLo = 0x0101_0101_0101_0101'u64
+    swarHi = 0x8080_8080_8080_8080'u64
+
+  template loadWord(s: string, i: int): uint64 =
+    var w {.noinit.}: uint64
+    copyMem(addr w, s[i].unsafeAddr, sizeof(w))
+    w
+
+  template asciiRangeMask(w: uint64, lo, hi: char): uint64 =
+    ## Sets the high bit of every byte of `w` that is in `lo..hi`.
+    let v = w
+    let x = v and not swarHi
+    (x + swarLo * uint64(0x80 - ord(lo))) and
+      not (x + swarLo * uint64(0x7f - ord(hi))) and not v and swarHi
+
+  template zeroByteMask(w: uint64): uint64 =
+    ## Sets the high bit of every byte of `w` that is zero.
+    let v = w
+    not (((v and not swarHi) + not swarHi) or v) and swarHi
+
 
 const
   Whitespace* = {' ', '\t', '\v', '\r', '\l', '\f'}
@@ -224,6 +264,26 @@ template toImpl(call) =
   for i in 0..len(s) - 1:
     result[i] = call(s[i])
 
+template toCaseImpl(call; lo, hi: char) =
+  ## `toImpl` for the ASCII case mappings; flips bit 5 of every byte in
+  ## `lo..hi`, 8 bytes at a time.
+  when nimvm:
+    toImpl call
+  else:
+    when hasCStringBuiltin:
+      result = newString(len(s))
+      var i = 0
+      while i + sizeof(uint64) <= len(s):
+        var w = loadWord(s, i)
+        w = w xor (asciiRangeMask(w, lo, hi) shr 2)
+        copyMem(addr result[i], addr w, sizeof(w))
+        inc i, sizeof(uint64)
+      while i < len(s):
+        result[i] = call(s[i])
+        inc i
+    else:
+      toImpl call
+
 func toLowerAscii*(s: string): string {.rtl, extern: "nsuToLowerAsciiStr".} =
   ## Converts string `s` into lower case.
   ##
@@ -235,7 +295,7 @@ func toLowerAscii*(s: string): string {.rtl, extern: "nsuToLowerAsciiStr".} =
   ## * `normalize func<#normalize,string>`_
   runnableExamples:
     doAssert toLowerAscii("FooBar!") == "foobar!"
-  toImpl toLowerAscii
+  toCaseImpl toLowerAscii, 'A', 'Z'
 
 func toUpperAscii*(c: char): char {.rtl, extern: "nsuToUpperAsciiChar".} =
   ## Converts character `c` into upper case.
@@ -267,7 +327,7 @@ func toUpperAscii*(s: string): string {.rtl, extern: "nsuToUpperAsciiStr".} =
   ## * `capitalizeAscii func<#capitalizeAscii,string>`_
   runnableExamples:
     doAssert toUpperAscii("FooBar!") == "FOOBAR!"
-  toImpl toUpperAscii
+  toCaseImpl toUpperAscii, 'a', 'z'
 
 func capitalizeAscii*(s: string): string {.rtl, extern: "nsuCapitalizeAscii".} =
   ## Converts the first character of string `s` into upper case.
@@ -384,6 +444,29 @@ template stringHasSep(s: string, index: int, sep: char): bool =
 template stringHasSep(s: string, index: int, sep: string): bool =
   s.substrEq(index, sep)
 
+template skipToSep(s: string, last: var int, sep: typed) =
+  ## Advances `last` to the next occurrence of `sep` or to `len(s)`.
+  template scan =
+    while last < len(s) and not stringHasSep(s, last, sep):
+      inc(last)
+  when nimvm:
+    scan()
+  else:
+    when hasCStringBuiltin and sep is char:
+      if last < len(s):
+        let found = c_memchr(s[last].unsafeAddr, cint(sep),
+                             cast[csize_t](len(s) - last))
+        last = if found.isNil: len(s) else: cast[int](found) -% cast[int](s.cstring)
+    elif declared(memmem) and sep is string:
+      if last < len(s) and sep.len > 0:
+        let found = memmem(s[last].unsafeAddr, csize_t(len(s) - last),
+                           sep.cstring, csize_t(sep.len))
+        last = if found.isNil: len(s) else: cast[int](found) -% cast[int](s.cstring)
+      else:
+        last = len(s)
+    else:
+      scan()
+
 template splitCommon(s, sep, maxsplit, sepLen) =
   ## Common code for split procs
   var last = 0
@@ -391,8 +474,7 @@ template splitCommon(s, sep, maxsplit, sepLen) =
 
   while last <= len(s):
     var first = last
-    while last < len(s) and not stringHasSep(s, last, sep):
-      inc(last)
+    skipToSep(s, last, sep)
     if splits == 0: last = len(s)
     yield substr(s, first, last-1)
     if splits == 0: break
@@ -1949,13 +2031,6 @@ func find*(a: SkipTable, s, sub: string, start: Natural = 0, last = -1): int {.
       dec i
     inc skip, a[s[skip + subLast]]
 
-when not (defined(js) or defined(nimdoc) or defined(nimscript)):
-  from system/ansi_c import c_memchr
-
-  const hasCStringBuiltin = true
-else:
-  const hasCStringBuiltin = false
-
 func find*(s: string, sub: char, start: Natural = 0, last = -1): int {.rtl,
     extern: "nsuFindChar".} =
   ## Searches for `sub` in `s` inside range `start..last` (both ends included).
@@ -2006,14 +2081,6 @@ func find*(s: string, chars: set[char], start: Natural = 0, last = -1): int {.
     if s[i] in chars:
       return i
 
-when defined(linux):
-  proc memmem(haystack: pointer, haystacklen: csize_t,
-              needle: pointer, needlelen: csize_t): pointer {.importc, header: """#define _GNU_SOURCE
-#include <string.h>""".}
-elif defined(bsd) or (defined(macosx) and not defined(ios)):
-  proc memmem(haystack: pointer, haystacklen: csize_t,
-              needle: pointer, needlelen: csize_t): pointer {.importc, header: "#include <string.h>".}
-
 func find*(s, sub: string, start: Natural = 0, last = -1): int {.rtl,
     extern: "nsuFindStr".} =
   ## Searches for `sub` in `s` inside range `start..last` (both ends included).
@@ -2037,8 +2104,9 @@ func find*(s, sub: string, start: Natural = 0, last = -1): int {.rtl,
   else:
     when declared(memmem):
       let subLen = sub.len
-      if last < 0 and start < s.len and subLen != 0:
-        let found = memmem(s[start].unsafeAddr, csize_t(s.len - start), sub.cstring, csize_t(subLen))
+      let last = if last < 0: s.high else: last
+      if start <= last and last < s.len and subLen != 0:
+        let found = memmem(s[start].unsafeAddr, csize_t(last - start + 1), sub.cstring, csize_t(subLen))
         result = if not found.isNil:
             cast[int](found) -% cast[int](s.cstring)
           else:
@@ -2120,8 +2188,21 @@ func count*(s: string, sub: char): int {.rtl, extern: "nsuCountChar".} =
   ## See also:
   ## * `countLines func<#countLines,string>`_
   result = 0
-  for c in s:
-    if c == sub: inc result
+  when nimvm:
+    for c in s:
+      if c == sub: inc result
+  else:
+    var i = 0
+    when hasCStringBuiltin:
+      let pattern = swarLo * uint64(sub)
+      while i + sizeof(uint64) <= s.len:
+        # one bit per matching byte, summed up by the multiplication
+        let matches = zeroByteMask(loadWord(s, i) xor pattern) shr 7
+        result += int((matches * swarLo) shr 56)
+        inc i, sizeof(uint64)
+    while i < s.len:
+      if s[i] == sub: inc result
+      inc i
 
 func count*(s: string, subs: set[char]): int {.rtl,
     extern: "nsuCountCharSet".} =
@@ -2222,17 +2303,24 @@ func replace*(s, sub: string, by = ""): string {.rtl,
     # copy the rest:
     add result, substr(s, i)
   else:
-    var a = initSkipTable(sub)
-    let last = s.high
-    var i = 0
-    while true:
-      let j = find(a, s, sub, i, last)
-      if j < 0: break
-      add result, substr(s, i, j - 1)
-      add result, by
-      i = j + subLen
-    # copy the rest:
-    add result, substr(s, i)
+    template replaceImpl(findNext) =
+      var i {.inject.} = 0
+      while true:
+        let j = findNext
+        if j < 0: break
+        add result, substr(s, i, j - 1)
+        add result, by
+        i = j + subLen
+      # copy the rest:
+      add result, substr(s, i)
+
+    when declared(memmem):
+      # `find` can hand the whole rest of `s` to `memmem`
+      replaceImpl(find(s, sub, i))
+    else:
+      var a = initSkipTable(sub)
+      let last = s.high
+      replaceImpl(find(a, s, sub, i, last))
 
 func replace*(s: string, sub, by: char): string {.rtl,
     extern: "nsuReplaceChar".} =
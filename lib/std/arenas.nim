@@ -0,0 +1,87 @@
+#
+#
+#            Nim's Runtime Library
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+## This module implements scoped arenas for `--mm:arc`, `--mm:orc` and
+## `--mm:atomicArc`. While an arena is open, every heap allocation of the
+## current thread, refs, seqs and strings included, is served by bumping a
+## pointer in the arena's chunks. Destructors run as usual but freeing is
+## almost free; the chunks are returned to the heap in one go when the
+## arena is closed. This suits code that allocates many short-lived objects
+## per unit of work, like a request handler.
+##
+## Allocations that outlive the arena, because they are stored in a global,
+## sent over a channel or returned, stay valid: the arena keeps its chunks
+## until the last of them is freed. Such escapes defeat the purpose of the
+## arena, so `withArena` checks for them when assertions are enabled.
+##
+## Arena memory can be freed by any thread; the arena's chunks go back to
+## the heap with the last of its allocations. This holds with `--threads:on`
+## too, where the payloads of refs, seqs and strings are shared memory.
+## Memory from explicit `allocShared` calls and allocations larger than
+## 2 MB are never taken from an arena.
+##
+## With other memory managers or `-d:useMalloc` arenas do nothing.
+##
+## .. warning:: This module is experimental and its interface may change.
+##
+
+runnableExamples:
+  import std/strutils
+
+  proc handle(request: string): int =
+    var parts: seq[string] = @[]
+    for part in request.split(' '): parts.add part
+    result = parts.len
+
+  withArena:
+    doAssert handle("GET /index.html HTTP/1.1") == 3
+
+const hasArenas = defined(gcDestructors) and not defined(useMalloc) and
+  not defined(useNimRtl) and not defined(js) and not defined(nimscript)
+
+type
+  Arena* = object ## An open arena. Arenas must be closed in reverse order.
+    p: pointer
+
+proc `=copy`*(dest: var Arena; src: Arena) {.error.}
+
+when hasArenas:
+  proc nimArenaOpen(): pointer {.importCompilerProc.}
+  proc nimArenaClose(ar: pointer): int {.importCompilerProc.}
+
+proc openArena*(): Arena =
+  ## Opens an arena. The allocations of the thread are taken from it until
+  ## it is closed or another arena is opened.
+  when hasArenas:
+    result = Arena(p: nimArenaOpen())
+  else:
+    result = Arena(p: nil)
+
+proc close*(a: var Arena): int {.discardable.} =
+  ## Closes `a`, which must be the innermost open arena, and returns the
+  ## number of its allocations that are still alive.
+  result = 0
+  when hasArenas:
+    if a.p != nil:
+      result = nimArenaClose(a.p)
+      a.p = nil
+
+template withArena*(body: untyped) =
+  ## Runs `body` with an open arena. When assertions are enabled and `body`
+  ## completes normally, every allocation made in `body` must have been
+  ## freed by then.
+  var arena = openArena()
+  var escaped = 0
+  try:
+    body
+  finally:
+    escaped = close(arena)
+  when compileOption("assertions"):
+    if escaped != 0:
+      raiseAssert $escaped & " allocations escaped the arena"
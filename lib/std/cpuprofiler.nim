@@ -0,0 +1,375 @@
+#
+#
+#            Nim's Runtime Library
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+## Sampling CPU profiler for release builds. Unlike `nimprof` it does not
+## need `--profiler:on` or `--stackTrace:on`: a `SIGPROF` timer interrupts
+## the thread that is running and its call stack is taken by following the
+## frame pointers. Compile with `--framePointers:on`, otherwise the stacks
+## end after the first proc:
+##
+##   ```cmd
+##   nim c -d:release --framePointers:on --debugger:native app.nim
+##   ./app   # calls startCpuProfile() and writeCpuProfile()
+##   pprof -http=: app cpu.pb
+##   ```
+##
+## The pprof profile holds addresses; pprof symbolizes them with the debug
+## information of the executable, whose `#line` directives lead back to the
+## Nim sources. `writeCollapsedStacks` resolves the procs itself, with the
+## resolver of `--stackTrace:native`, and writes the format of
+## `flamegraph.pl` and speedscope.
+##
+## Supported are Linux on x86, x86_64 and ARM64 and macOS on x86_64 and
+## ARM64. The timer counts the CPU time of the whole process, so all
+## threads are sampled.
+
+runnableExamples("--framePointers:on"):
+  import std/os
+  proc fib(n: int): int = (if n < 2: n else: fib(n - 1) + fib(n - 2))
+  startCpuProfile()
+  doAssert fib(25) == 75025
+  stopCpuProfile()
+  doAssert writeCollapsedStacks(getTempDir() / "cpu.folded")
+
+when not defined(posix) and not defined(nimdoc):
+  {.error: "The CPU profiler needs a POSIX system.".}
+when not compileOption("framePointers") and not defined(nimdoc):
+  {.warning: "Compile with `--framePointers:on` to get complete stacks from the CPU profiler.".}
+
+import std/[monotimes, oserrors, posix, strutils, tables, times]
+
+when defined(nimPreviewSlimSystem):
+  import std/[syncio, sysatomics]
+
+{.push stackTrace: off, profiler: off.}
+
+const
+  MaxDepth = 64
+  Slots = 1 shl 12     # distinct stacks that can be recorded
+  MaxProbes = 64
+  MaxFrameSize = 1'u shl 20
+
+type
+  Sample = object
+    state: int # 0: free, 1: being written, 2: ready
+    count: int
+    hash: uint
+    depth: int
+    stack: array[MaxDepth, pointer] # stack[0] is the interrupted instruction
+
+  Itimerval {.importc: "struct itimerval", header: "<sys/time.h>",
+              final, pure.} = object
+    it_interval, it_value: Timeval
+
+var
+  ITIMER_PROF {.importc, header: "<sys/time.h>".}: cint
+
+proc setitimer(which: cint; value: var Itimerval; old: ptr Itimerval): cint {.
+  importc, header: "<sys/time.h>".}
+
+{.emit: """/*TYPESECTION*/
+#if defined(__linux__)
+#  include <ucontext.h>
+#elif defined(__APPLE__)
+#  include <sys/ucontext.h>
+#endif
+static void nimCpuProfRegisters(void* context, void** pc, void** fp, void** sp) {
+  ucontext_t* uc = (ucontext_t*)context;
+#if defined(__linux__) && defined(__x86_64__)
+  *pc = (void*)uc->uc_mcontext.gregs[REG_RIP];
+  *fp = (void*)uc->uc_mcontext.gregs[REG_RBP];
+  *sp = (void*)uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__linux__) && defined(__i386__)
+  *pc = (void*)uc->uc_mcontext.gregs[REG_EIP];
+  *fp = (void*)uc->uc_mcontext.gregs[REG_EBP];
+  *sp = (void*)uc->uc_mcontext.gregs[REG_ESP];
+#elif defined(__linux__) && defined(__aarch64__)
+  *pc = (void*)uc->uc_mcontext.pc;
+  *fp = (void*)uc->uc_mcontext.regs[29];
+  *sp = (void*)uc->uc_mcontext.sp;
+#elif defined(__APPLE__) && defined(__x86_64__)
+  *pc = (void*)uc->uc_mcontext->__ss.__rip;
+  *fp = (void*)uc->uc_mcontext->__ss.__rbp;
+  *sp = (void*)uc->uc_mcontext->__ss.__rsp;
+#elif defined(__APPLE__) && defined(__aarch64__)
+  *pc = (void*)uc->uc_mcontext->__ss.__pc;
+  *fp = (void*)uc->uc_mcontext->__ss.__fp;
+  *sp = (void*)uc->uc_mcontext->__ss.__sp;
+#else
+  (void)uc;
+  *pc = 0; *fp = 0; *sp = 0;
+#endif
+}
+""".}
+
+proc registers(context: pointer; pc, fp, sp: var pointer) {.
+  importc: "nimCpuProfRegisters", nodecl.}
+
+proc nimNativeSymbolize(pc: uint; procname, filename: var cstring;
+                        line: var int): bool {.importCompilerProc.}
+
+var
+  samples: ptr UncheckedArray[Sample]
+  dropped: int # samples that did not fit or had no stack
+  interval: int # in microseconds
+  started, stopped: MonoTime
+  running: bool
+
+proc onSignal(sig: cint; info: ptr SigInfo; context: pointer) {.noconv.} =
+  # runs in a signal handler: no allocations, no locks
+  let t = samples
+  if t == nil: return
+  var stack {.noinit.}: array[MaxDepth, pointer]
+  var pc, fp, sp: pointer
+  registers(context, pc, fp, sp)
+  if pc == nil:
+    atomicInc dropped
+    return
+  stack[0] = pc
+  var depth = 1
+  var frame = cast[uint](fp)
+  # every frame starts with the caller's frame pointer and the return address
+  if frame < cast[uint](sp) or frame - cast[uint](sp) >= MaxFrameSize: frame = 0
+  while depth < MaxDepth and frame != 0 and (frame and uint(sizeof(pointer) - 1)) == 0:
+    let f = cast[ptr UncheckedArray[uint]](frame)
+    if f[1] == 0: break
+    stack[depth] = cast[pointer](f[1])
+    inc depth
+    let next = f[0]
+    if next <= frame or next - frame >= MaxFrameSize: break
+    frame = next
+
+  var h = 0xcbf29ce484222325'u
+  for i in 0..<depth: h = (h xor cast[uint](stack[i])) * 0x100000001b3'u
+  var i = int(h and uint(Slots - 1))
+  for probe in 0..<MaxProbes:
+    let s = addr t[i]
+    let state = atomicLoadN(addr s.state, ATOMIC_ACQUIRE)
+    if state == 0 and cas(addr s.state, 0, 1):
+      s.hash = h
+      s.depth = depth
+      copyMem(addr s.stack[0], addr stack[0], depth * sizeof(pointer))
+      s.count = 1
+      atomicStoreN(addr s.state, 2, ATOMIC_RELEASE)
+      return
+    if state == 2 and s.hash == h and s.depth == depth and
+        equalMem(addr s.stack[0], addr stack[0], depth * sizeof(pointer)):
+      atomicInc s.count
+      return
+    # another thread may write the same stack into the slot; that only
+    # splits its count into two entries
+    i = (i + 1) and (Slots - 1)
+  atomicInc dropped
+
+proc stopCpuProfile*() =
+  ## Stops sampling. The samples are kept until the next `startCpuProfile`.
+  if not running: return
+  var timer: Itimerval
+  discard setitimer(ITIMER_PROF, timer, nil)
+  # a signal may still be pending
+  signal(SIGPROF, SIG_IGN)
+  stopped = getMonoTime()
+  running = false
+
+proc startCpuProfile*(frequency = 100) =
+  ## Discards the samples taken so far and starts sampling the stack of the
+  ## running thread `frequency` times per second of the CPU time of the
+  ## process.
+  doAssert frequency in 1..1_000_000
+  if running: stopCpuProfile()
+  if samples == nil:
+    samples = cast[ptr UncheckedArray[Sample]](allocShared0(Slots * sizeof(Sample)))
+  else:
+    zeroMem(samples, Slots * sizeof(Sample))
+  dropped = 0
+  interval = 1_000_000 div frequency
+  var action: Sigaction
+  action.sa_sigaction = onSignal
+  action.sa_flags = SA_SIGINFO or SA_RESTART
+  discard sigemptyset(action.sa_mask)
+  if sigaction(SIGPROF, action, nil) != 0: raiseOSError(osLastError())
+  var timer: Itimerval
+  timer.it_interval.tv_sec = posix.Time(interval div 1_000_000)
+  timer.it_interval.tv_usec = Suseconds(interval mod 1_000_000)
+  timer.it_value = timer.it_interval
+  started = getMonoTime()
+  if setitimer(ITIMER_PROF, timer, nil) != 0: raiseOSError(osLastError())
+  running = true
+
+iterator readySamples(): ptr Sample =
+  if samples != nil:
+    for i in 0..<Slots:
+      let s = addr samples[i]
+      if atomicLoadN(addr s.state, ATOMIC_ACQUIRE) == 2: yield s
+
+template frameAddress(s: ptr Sample; i: int): uint =
+  # return addresses point after the call
+  if i == 0: cast[uint](s.stack[i]) else: cast[uint](s.stack[i]) - 1
+
+proc frameName(a: uint; lineNumbers: bool): string =
+  var procname, file: cstring = nil
+  var line = 0
+  if nimNativeSymbolize(a, procname, file, line):
+    result = $procname
+    if lineNumbers and line > 0: result.add ":" & $line
+  else:
+    result = "0x" & toHex(a)
+
+proc writeCollapsedStacks*(filename = "cpu.folded"; lineNumbers = false): bool =
+  ## Writes the samples as one line per stack, the procs from the outermost
+  ## to the innermost separated by `;` and followed by the number of
+  ## samples. A proc is written as `module.proc`, a C function by its name.
+  ## With `lineNumbers` every frame is followed by its line, `module.proc:12`,
+  ## which needs `--debugger:native` and Linux. Returns false if the file
+  ## could not be written.
+  var names = initTable[uint, string]()
+  var stacks = initCountTable[string]()
+  for s in readySamples():
+    var line = ""
+    for i in countdown(s.depth - 1, 0):
+      let a = frameAddress(s, i)
+      var name = names.getOrDefault(a)
+      if name.len == 0:
+        name = frameName(a, lineNumbers)
+        names[a] = name
+      if line.len > 0: line.add ';'
+      line.add name
+    stacks.inc(line, atomicLoadN(addr s.count, ATOMIC_RELAXED))
+  if dropped > 0: stacks.inc("(dropped)", dropped)
+  var f: File
+  if not open(f, filename, fmWrite): return false
+  try:
+    for line, count in stacks:
+      f.write line, ' ', count, '\n'
+    result = true
+  except IOError:
+    result = false
+  finally:
+    close f
+
+# ---------------------- pprof output ---------------------------------------
+
+# The profile is an uncompressed `perftools.profiles.Profile` protocol buffer,
+# see https://github.com/google/pprof/blob/main/proto/profile.proto
+
+proc pbVarint(b: var string; x: uint64) =
+  var x = x
+  while x >= 0x80'u64:
+    b.add char((x and 0x7f) or 0x80)
+    x = x shr 7
+  b.add char(x)
+
+proc pbInt(b: var string; field: int; x: int64) =
+  if x != 0:
+    b.pbVarint(uint64(field shl 3))
+    b.pbVarint(cast[uint64](x))
+
+proc pbBytes(b: var string; field: int; s: string) =
+  b.pbVarint(uint64(field shl 3 or 2))
+  b.pbVarint(uint64(s.len))
+  b.add s
+
+type
+  Mapping = object
+    start, limit, offset: uint64
+    file: string
+
+proc readMappings(): seq[Mapping] =
+  ## The executable mappings of the process, needed to symbolize addresses.
+  result = @[]
+  when defined(linux):
+    try:
+      for line in lines("/proc/self/maps"):
+        let parts = line.splitWhitespace()
+        if parts.len >= 5 and parts[1].len >= 3 and parts[1][2] == 'x':
+          let bounds = parts[0].split('-')
+          result.add Mapping(start: fromHex[uint64](bounds[0]),
+                             limit: fromHex[uint64](bounds[1]),
+                             offset: fromHex[uint64](parts[2]),
+                             file: if parts.len >= 6: parts[5] else: "")
+    except IOError, ValueError:
+      discard
+
+proc writeCpuProfile*(filename = "cpu.pb"): bool =
+  ## Writes the samples in pprof's format: the number of samples and the
+  ## CPU time of every stack. Returns false if the file could not be
+  ## written.
+  var strs = initTable[string, int]()
+  var strList: seq[string] = @[]
+  proc str(s: string): int64 =
+    result = strs.getOrDefault(s, -1)
+    if result < 0:
+      result = strList.len
+      strs[s] = strList.len
+      strList.add s
+  discard str("")
+
+  var prof, msg = ""
+  for (t, u) in [("samples", "count"), ("cpu", "nanoseconds")]:
+    msg.pbInt(1, str(t))
+    msg.pbInt(2, str(u))
+    prof.pbBytes(1, msg)
+    msg.setLen 0
+
+  let mappings = readMappings()
+  for i, m in mappings:
+    msg.pbInt(1, i + 1)
+    msg.pbInt(2, cast[int64](m.start))
+    msg.pbInt(3, cast[int64](m.limit))
+    msg.pbInt(4, cast[int64](m.offset))
+    msg.pbInt(5, str(m.file))
+    prof.pbBytes(3, msg)
+    msg.setLen 0
+
+  let period = interval * 1000
+  var locations = initTable[uint, int]()
+  var ids, values = ""
+  for s in readySamples():
+    for i in 0..<s.depth:
+      let a = frameAddress(s, i)
+      var id = locations.getOrDefault(a)
+      if id == 0:
+        id = locations.len + 1
+        locations[a] = id
+        msg.pbInt(1, id)
+        for j, m in mappings:
+          if a >= m.start and a < m.limit:
+            msg.pbInt(2, j + 1)
+            break
+        msg.pbInt(3, cast[int64](a))
+        prof.pbBytes(4, msg)
+        msg.setLen 0
+      ids.pbVarint(uint64(id))
+    let count = atomicLoadN(addr s.count, ATOMIC_RELAXED)
+    values.pbVarint(uint64(count))
+    values.pbVarint(uint64(count * period))
+    msg.pbBytes(1, ids)
+    msg.pbBytes(2, values)
+    prof.pbBytes(2, msg)
+    msg.setLen 0
+    ids.setLen 0
+    values.setLen 0
+
+  let last = if running: getMonoTime() else: stopped
+  prof.pbInt(10, inNanoseconds(last - started))
+  msg.pbInt(1, str("cpu"))
+  msg.pbInt(2, str("nanoseconds"))
+  prof.pbBytes(11, msg)
+  prof.pbInt(12, period)
+  if dropped > 0: prof.pbInt(13, str("dropped samples: " & $dropped))
+  # the string table comes last, after all strings were added
+  for s in strList: prof.pbBytes(6, s)
+
+  result = true
+  try:
+    writeFile(filename, prof)
+  except IOError:
+    result = false
+
+{.pop.}
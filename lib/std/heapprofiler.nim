@@ -0,0 +1,68 @@
+#
+#
+#            Nim's Runtime Library
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+## Sampling heap profiler for `--mm:arc`, `--mm:orc` and `--mm:atomicArc`.
+## It needs `-d:nimHeapProfiler`, which makes the runtime sample about one
+## in every 512 KB of the bytes allocated for refs, seqs and strings (set
+## `-d:nimHeapProfileRate=bytes` or call `setHeapProfileRate` to change it).
+## A sample records the type, the size and the call stack of the
+## allocation and lives until the allocation is freed. Unlike
+## `memProfiler` it does not need `--stackTrace:on`; the stacks are
+## addresses, symbolized by pprof with the help of the executable:
+##
+##   ```cmd
+##   nim c -d:release -d:nimHeapProfiler --debugger:native app.nim
+##   pprof -http=: app heap.pb
+##   ```
+##
+## The profile has the `inuse_objects` and `inuse_space` sample types,
+## scaled to estimate all allocations, and `type` and `bytes` labels
+## (`pprof -tagfocus type=Node`).
+##
+## Stacks are captured with `backtrace` on Linux and macOS only.
+
+runnableExamples("-d:nimHeapProfiler"):
+  import std/os
+  var nodes: seq[ref array[64, int]] = @[]
+  for i in 0..<10_000: nodes.add new(array[64, int])
+  doAssert dumpHeapProfile(getTempDir() / "heap.pb")
+
+when not defined(nimHeapProfiler) and not defined(nimdoc):
+  {.error: "Heap profiling is turned off! Enable it with `-d:nimHeapProfiler`.".}
+when not defined(gcDestructors) and not defined(nimdoc):
+  {.error: "The heap profiler needs `--mm:arc`, `--mm:orc` or `--mm:atomicArc`.".}
+
+proc nimHeapProfDump(filename: cstring): bool {.importCompilerProc.}
+proc nimHeapProfRequestDump(filename: cstring) {.importCompilerProc.}
+proc nimHeapProfSetRate(bytes: int) {.importCompilerProc.}
+
+proc dumpHeapProfile*(filename = "heap.pb"): bool =
+  ## Writes the sampled allocations that are still alive to `filename` in
+  ## pprof's format. Returns false if the file could not be written.
+  result = nimHeapProfDump(filename)
+
+proc setHeapProfileRate*(bytes: int) =
+  ## Sets the average number of allocated bytes between two samples. The
+  ## calling thread's next allocation is sampled.
+  nimHeapProfSetRate(bytes)
+
+when defined(posix):
+  import std/posix
+
+  var signalFile: string # must outlive the handler
+
+  proc onSignal(sig: cint) {.noconv.} =
+    nimHeapProfRequestDump(cstring(signalFile))
+
+  proc dumpHeapProfileOnSignal*(filename = "heap.pb"; sig = SIGUSR2) =
+    ## Writes the profile to `filename` whenever the process receives
+    ## `sig`. The profile is written by the thread that makes the next
+    ## sampled allocation.
+    signalFile = filename
+    signal(sig, onSignal)
@@ -523,10 +523,11 @@ type
                             ## rendered at a later time, we should ensure the stacktrace
                             ## data isn't invalidated; any pointer into PFrame is
                             ## subject to being invalidated so shouldn't be stored.
-    when defined(nimStackTraceOverride):
+    when defined(nimStackTraceOverride) or defined(nimNativeStackTraces):
       programCounter*: uint ## Program counter - will be used to get the rest of the info,
                             ## when `$` is called on this type. We can't use
                             ## "cuintptr_t" in here.
+    when defined(nimStackTraceOverride):
       procnameStr*, filenameStr*: string ## GC-ed alternatives to "procname" and "filename"
 
   Exception* {.compilerproc, magic: "Exception".} = object of RootObj ## \
@@ -1618,7 +1619,7 @@ when not defined(js) and defined(nimV2):
       align: int16
       depth: int16
       display: ptr UncheckedArray[uint32] # classToken
-      when defined(nimTypeNames) or defined(nimArcIds):
+      when defined(nimTypeNames) or defined(nimArcIds) or defined(nimHeapProfiler):
         name: cstring
       traceImpl: pointer
       typeInfoV1: pointer # for backwards compat, usually nil
@@ -1633,6 +1634,8 @@ when not defined(js) and defined(nimV2):
 proc supportsCopyMem(t: typedesc): bool {.magic: "TypeTrait".}
 
 when notJSnotNims and defined(nimSeqsV2):
+  when defined(nimHeapProfiler):
+    include "system/heapprof"
   include "system/strs_v2"
   include "system/seqs_v2"
 
@@ -1700,7 +1703,7 @@ when not defined(js):
         let s = cast[ptr NimStringV2](addr result)
         if len > 0:
           s.len = len
-          s.p.data[len] = '\0'
+          strData(s[])[len] = '\0'
       else:
         let s = cast[NimString](result)
         s.len = len
@@ -66,6 +66,12 @@ const
   MaxBigChunkSize = int(1'i32 shl MaxFli - 1'i32 shl (MaxFli-MaxLog2Sli-1))
   HugeChunkSize = MaxBigChunkSize + 1
 
+when defined(gcDestructors) and declared(osTryReallocPages):
+  const
+    RemapChunkSize = min(4 * 1024 * 1024, HugeChunkSize)
+      # `realloc` moves a block that grows beyond this size to pages of its
+      # own, a remap chunk, which `remapHugeChunk` can then resize
+
 type
   PTrunk = ptr Trunk
   Trunk = object
@@ -160,6 +166,8 @@ type
     matrix: array[RealFli, array[MaxSli, PBigChunk]]
     llmem: PLLChunk
     currMem, maxMem, freeMem, occ: int # memory sizes (allocated from OS)
+    when defined(nimHugePages):
+      hugeMem: int # the part of `currMem` that can be backed by huge pages
     lastSize: int # needed for the case that OS gives us pages linearly
     when RegionHasLock:
       lock: SysLock
@@ -167,6 +175,8 @@ type
       sharedFreeListBigChunks: PBigChunk # make no attempt at avoiding false sharing for now for this object field
 
     chunkStarts: IntSet
+    when declared(RemapChunkSize):
+      remapChunks: IntSet # the remap chunks below `HugeChunkSize`
     when not defined(gcDestructors):
       root, deleted, last, freeAvlNodes: PAvlNode
     lockActive, locked, blockChunkSizeIncrease: bool # if locked, we cannot free pages.
@@ -525,6 +535,11 @@ proc requestOsChunks(a: var MemRegion, size: int): PBigChunk =
         a.nextChunkSize = min(a.nextChunkSize, MaxBigChunkSize).int
 
   var size = size
+  when declared(osHugePageBytes):
+    # grow the heap in whole huge pages
+    if osHugePagesEnabled():
+      a.nextChunkSize = roundup(a.nextChunkSize, HugePageSize)
+      size = roundup(size, HugePageSize)
   if size > a.nextChunkSize:
     result = cast[PBigChunk](allocPages(a, size))
   else:
@@ -537,6 +552,8 @@ proc requestOsChunks(a: var MemRegion, size: int): PBigChunk =
 
   incCurrMem(a, size)
   inc(a.freeMem, size)
+  when declared(osHugePageBytes):
+    inc(a.hugeMem, osHugePageBytes(result, size))
   let heapLink = a.addHeapLink(result, size)
   when defined(debugHeapLinks):
     cprintf("owner: %p; result: %p; next pointer %p; size: %ld\n", addr(a),
@@ -718,6 +735,8 @@ proc getHugeChunk(a: var MemRegion; size: int): PBigChunk =
       initSysLock(a.lock)
     acquireSys a.lock
   incCurrMem(a, size)
+  when declared(osHugePageBytes):
+    inc(a.hugeMem, osHugePageBytes(result, size))
   # XXX add this to the heap links. But also remove it from it later.
   when false: a.addHeapLink(result, size)
   sysAssert((cast[int](result) and PageMask) == 0, "getHugeChunk")
@@ -731,13 +750,67 @@ proc getHugeChunk(a: var MemRegion; size: int): PBigChunk =
   when RegionHasLock:
     releaseSys a.lock
 
+proc isHugeChunk(a: MemRegion; c: PBigChunk): bool {.inline.} =
+  ## Whether `c` has pages of its own, which go back to the OS when it is
+  ## freed.
+  result = c.size >= HugeChunkSize
+  when declared(RemapChunkSize):
+    if not result and c.size >= RemapChunkSize:
+      result = contains(a.remapChunks, pageIndex(c))
+
 proc freeHugeChunk(a: var MemRegion; c: PBigChunk) =
   let size = c.size
-  sysAssert(size >= HugeChunkSize, "freeHugeChunk: invalid size")
+  sysAssert(isHugeChunk(a, c), "freeHugeChunk: invalid size")
   excl(a.chunkStarts, pageIndex(c))
+  when declared(RemapChunkSize):
+    excl(a.remapChunks, pageIndex(c))
   decCurrMem(a, size)
+  when declared(osHugePageBytes):
+    dec(a.hugeMem, osHugePageBytes(c, size))
   osDeallocPages(c, size)
 
+when declared(RemapChunkSize):
+  proc remapHugeChunk(a: var MemRegion; p: pointer; newSize: int): pointer =
+    ## Resizes the huge or remap chunk that starts with `p` without copying
+    ## its data. Returns nil if `p` is not such a chunk of `a` or would
+    ## shrink below `RemapChunkSize`.
+    result = nil
+    let c = cast[PBigChunk](pageAddr(p))
+    if isSmallChunk(c) or c.owner != addr a or p != addr(c.data) or
+        not isHugeChunk(a, c):
+      return
+    let size = roundup(newSize + bigChunkOverhead(), PageSize)
+    if size < RemapChunkSize: return
+    let oldSize = c.size
+    if size == oldSize: return p
+    when RegionHasLock:
+      acquireSys a.lock
+    let n = cast[PBigChunk](osTryReallocPages(c, oldSize, size))
+    if n != nil:
+      excl(a.chunkStarts, pageIndex(c))
+      excl(a.remapChunks, pageIndex(c))
+      incl(a, a.chunkStarts, pageIndex(n))
+      if size < HugeChunkSize: incl(a, a.remapChunks, pageIndex(n))
+      n.size = size
+      decCurrMem(a, oldSize)
+      incCurrMem(a, size)
+      when declared(osHugePageBytes):
+        # the pages may have moved to an address that is not aligned to
+        # huge pages
+        inc(a.hugeMem, osHugePageBytes(n, size) - osHugePageBytes(c, oldSize))
+      inc(a.occ, size - oldSize)
+      result = addr(n.data)
+    when RegionHasLock:
+      releaseSys a.lock
+
+  proc allocRemapChunk(a: var MemRegion; size: int): pointer =
+    ## Allocates a block of `size` bytes on pages of its own.
+    let c = getHugeChunk(a, roundup(size + bigChunkOverhead(), PageSize))
+    if c.size < HugeChunkSize: incl(a, a.remapChunks, pageIndex(c))
+    inc a.occ, c.size
+    trackSize(c.size)
+    result = addr(c.data)
+
 proc getSmallChunk(a: var MemRegion): PSmallChunk =
   var res = getBigChunk(a, PageSize)
   sysAssert res.prev == nil, "getSmallChunk 1"
@@ -802,7 +875,7 @@ proc deallocBigChunk(a: var MemRegion, c: PBigChunk) =
   when not defined(gcDestructors):
     a.deleted = getBottom(a)
     del(a, a.root, cast[int](addr(c.data)))
-  if c.size >= HugeChunkSize: freeHugeChunk(a, c)
+  if isHugeChunk(a, c): freeHugeChunk(a, c)
   else: freeBigChunk(a, c)
   when RegionHasLock:
     releaseSys a.lock
@@ -968,8 +1041,13 @@ proc rawAlloc(a: var MemRegion, requestedSize: int): pointer =
         freeDeferredObjects(a, deferredFrees)
 
     size = requestedSize + bigChunkOverhead() #  roundup(requestedSize+bigChunkOverhead(), PageSize)
-    # allocate a large block
-    var c = if size >= HugeChunkSize: getHugeChunk(a, size)
+    # allocate a large block; `getBigChunk` rounds up to its size classes and
+    # must never return a chunk that `deallocBigChunk` takes for a huge one
+    var rounded = size
+    var fl, sl = 0
+    mappingSearch(rounded, fl, sl)
+    var c = if size >= HugeChunkSize or rounded >= HugeChunkSize:
+              getHugeChunk(a, max(roundup(size, PageSize), HugeChunkSize))
             else: getBigChunk(a, size)
     sysAssert c.prev == nil, "rawAlloc 10"
     sysAssert c.next == nil, "rawAlloc 11"
@@ -1167,6 +1245,17 @@ proc dealloc(allocator: var MemRegion, p: pointer) =
 proc realloc(allocator: var MemRegion, p: pointer, newsize: Natural): pointer =
   result = nil
   if newsize > 0:
+    when declared(remapHugeChunk):
+      # big payloads are resized by remapping their pages instead of copying;
+      # one that grows beyond `RemapChunkSize` moves to pages of its own
+      if p != nil and newsize >= RemapChunkSize - bigChunkOverhead():
+        result = remapHugeChunk(allocator, p, newsize)
+        if result != nil: return
+        if newsize > ptrSize(p):
+          result = allocRemapChunk(allocator, newsize)
+          copyMem(result, p, ptrSize(p))
+          dealloc(allocator, p)
+          return
     result = alloc(allocator, newsize)
     if p != nil:
       copyMem(result, p, min(ptrSize(p), newsize))
@@ -1190,6 +1279,8 @@ proc deallocOsPages(a: var MemRegion) =
         cprintf("owner %p; dealloc A: %p size: %ld; next: %p\n", addr(a),
           it, size, next)
       sysAssert size >= PageSize, "origSize too small"
+      when declared(osHugePageBytes):
+        dec(a.hugeMem, osHugePageBytes(p, size))
       osDeallocPages(p, size)
     it = next
     if it == nil: break
@@ -1206,6 +1297,184 @@ when defined(nimTypeNames):
   proc getMemCounters(a: MemRegion): (int, int) {.inline.} =
     (a.allocCounter, a.deallocCounter)
 
+# ---------------------- arenas ---------------------------------------------
+
+when defined(gcDestructors):
+  # While an arena is open the allocations of its thread are taken from its
+  # chunks by bumping `pos`. Freeing only counts, except for the latest
+  # allocation whose space is reused. A closed arena that still holds live
+  # allocations is freed with the last of them, by whichever thread frees it.
+  #
+  # Arena chunks are aligned to `ArenaBlockSize` and registered block by
+  # block in a process wide table, so that `dealloc` on any thread can tell
+  # an arena pointer with a bounded number of probes. The table is written
+  # under a lock; readers only need to see the blocks of pointers they got
+  # from their owner, which the hand-over orders.
+  const
+    ArenaChunkSize = 64 * 1024
+    MaxArenaChunkSize = 4 * 1024 * 1024
+    ArenaBlockShift = 16 # 64 KiB
+    ArenaBlockSize = 1 shl ArenaBlockShift
+    ArenaTableSize = 4096 # blocks, 256 MiB of chunks
+    ArenaMaxProbes = 16
+    ArenaTombstone = -1
+
+  type
+    ArenaBlockEntry = object
+      key: int                # the block number, 0 if unused
+      chunk: ptr ArenaChunk
+
+  var
+    arenaBlocks: array[ArenaTableSize, ArenaBlockEntry]
+    arenaBlockCount: int      # registered blocks, 0 skips the lookup
+    arenaTableLock: int
+
+  template arenaSlot(key, i: int): int =
+    ((key xor (key shr 12)) +% i) and (ArenaTableSize - 1)
+
+  proc unregisterArenaChunk(c: ptr ArenaChunk; blocks: int) =
+    let first = cast[int](c) shr ArenaBlockShift
+    while not cas(addr arenaTableLock, 0, 1): cpuRelax()
+    for b in first ..< first + blocks:
+      for i in 0 ..< ArenaMaxProbes:
+        let slot = arenaSlot(b, i)
+        if arenaBlocks[slot].key == b:
+          atomicStoreN(addr arenaBlocks[slot].key, ArenaTombstone, ATOMIC_RELEASE)
+          discard atomicDec(arenaBlockCount)
+          break
+    atomicStoreN(addr arenaTableLock, 0, ATOMIC_RELEASE)
+
+  proc registerArenaChunk(c: ptr ArenaChunk): bool =
+    let first = cast[int](c) shr ArenaBlockShift
+    let blocks = c.size shr ArenaBlockShift
+    var done = 0
+    while not cas(addr arenaTableLock, 0, 1): cpuRelax()
+    for b in first ..< first + blocks:
+      var found = false
+      for i in 0 ..< ArenaMaxProbes:
+        let slot = arenaSlot(b, i)
+        let key = arenaBlocks[slot].key
+        if key == 0 or key == ArenaTombstone:
+          arenaBlocks[slot].chunk = c
+          atomicStoreN(addr arenaBlocks[slot].key, b, ATOMIC_RELEASE)
+          discard atomicInc(arenaBlockCount)
+          found = true
+          break
+      if not found: break
+      inc done
+    atomicStoreN(addr arenaTableLock, 0, ATOMIC_RELEASE)
+    result = done == blocks
+    if not result: unregisterArenaChunk(c, done)
+
+  proc arenaChunkOf(p: pointer): ptr ArenaChunk {.inline.} =
+    ## The arena chunk containing `p` or nil, from any thread.
+    result = nil
+    if atomicLoadN(addr arenaBlockCount, ATOMIC_RELAXED) != 0:
+      let b = cast[int](p) shr ArenaBlockShift
+      for i in 0 ..< ArenaMaxProbes:
+        let slot = arenaSlot(b, i)
+        let key = atomicLoadN(addr arenaBlocks[slot].key, ATOMIC_ACQUIRE)
+        if key == b: return arenaBlocks[slot].chunk
+        if key == 0: return nil
+
+  proc addArenaChunk(a: var MemRegion; ar: ptr MemArena; size: int): bool =
+    let chunkSize = roundup(max(ar.nextChunkSize, size + sizeof(ArenaChunk)),
+                            ArenaBlockSize)
+    # big chunks are only page aligned
+    let raw = alloc(a, chunkSize + ArenaBlockSize)
+    let c = cast[ptr ArenaChunk](roundup(cast[int](raw), ArenaBlockSize))
+    c.raw = raw
+    c.arena = ar
+    c.size = chunkSize
+    if not registerArenaChunk(c):
+      dealloc(a, raw)
+      return false
+    c.next = ar.chunks
+    ar.chunks = c
+    ar.pos = cast[int](c) +% sizeof(ArenaChunk)
+    ar.limit = cast[int](c) +% chunkSize
+    ar.nextChunkSize = min(ar.nextChunkSize * 2, MaxArenaChunkSize)
+    result = true
+
+  proc arenaAlloc(a: var MemRegion; ar: ptr MemArena; size: Natural): pointer =
+    # zero sized allocations must not share the address of the next one
+    let rsize = roundup(max(size, 1), MemAlign)
+    if ar.pos +% rsize >% ar.limit:
+      # large blocks and a full block table are served by the heap
+      if rsize > MaxArenaChunkSize div 2 or not addArenaChunk(a, ar, rsize):
+        return alloc(a, size)
+    result = cast[pointer](ar.pos)
+    ar.last = ar.pos
+    ar.pos = ar.pos +% rsize
+    inc ar.live
+
+  proc freeArena(a: var MemRegion; ar: ptr MemArena) =
+    var c = ar.chunks
+    while c != nil:
+      let next = c.next
+      unregisterArenaChunk(c, c.size shr ArenaBlockShift)
+      dealloc(a, c.raw)
+      c = next
+    dealloc(a, ar)
+
+  proc arenaDealloc(a: var MemRegion; c: ptr ArenaChunk; p: pointer) =
+    let ar = c.arena
+    if ar.owner == addr(a) and ar.open:
+      let x = cast[int](p)
+      if x == ar.last:
+        ar.pos = x
+        ar.last = 0
+      dec ar.live
+    elif atomicInc(ar.foreign) == 0:
+      # the last allocation of a closed arena
+      freeArena(a, ar)
+
+  proc arenaRealloc(a: var MemRegion; c: ptr ArenaChunk; p: pointer;
+                    newSize: Natural): pointer =
+    let x = cast[int](p)
+    if newSize == 0:
+      arenaDealloc(a, c, p)
+      return nil
+    let ar = c.arena
+    let isLast = ar.owner == addr(a) and ar.open and x == ar.last
+    if isLast and x +% roundup(newSize, MemAlign) <=% ar.limit:
+      ar.pos = x +% roundup(newSize, MemAlign)
+      return p
+    let top = arenaState.top
+    if top != nil: result = arenaAlloc(a, top, newSize)
+    else: result = alloc(a, newSize)
+    # the old size is unknown; the rest of the chunk is readable
+    let oldSize = if isLast: ar.pos -% x else: cast[int](c) +% c.size -% x
+    copyMem(result, p, min(oldSize, newSize))
+    arenaDealloc(a, c, p)
+
+  proc openArena(a: var MemRegion): ptr MemArena =
+    result = cast[ptr MemArena](alloc0(a, sizeof(MemArena)))
+    result.owner = addr(a)
+    result.open = true
+    result.nextChunkSize = ArenaChunkSize
+    result.next = arenaState.top
+    arenaState.top = result
+
+  proc closeArena(a: var MemRegion; ar: ptr MemArena): int =
+    sysAssert(arenaState.top == ar, "closeArena: arenas must be closed in LIFO order")
+    arenaState.top = ar.next
+    ar.open = false
+    # `foreign` counts the frees of other threads so far; from now on every
+    # free counts there and the one that brings it to 0 frees the arena
+    result = -atomicDec(ar.foreign, ar.live)
+    if result == 0: freeArena(a, ar)
+
+template noArena(body) =
+  # shared memory may be freed by any thread at any time
+  when defined(gcDestructors):
+    let ar = arenaState.top
+    arenaState.top = nil
+    body
+    arenaState.top = ar
+  else:
+    body
+
 # ---------------------- thread memory region -------------------------------
 
 template instantiateForRegion(allocator: untyped) {.dirty.} =
@@ -1222,22 +1491,49 @@ template instantiateForRegion(allocator: untyped) {.dirty.} =
   proc deallocOsPages = deallocOsPages(allocator)
 
   proc allocImpl(size: Natural): pointer =
+    when defined(gcDestructors):
+      let ar = arenaState.top
+      if ar != nil: return arenaAlloc(allocator, ar, size)
     result = alloc(allocator, size)
 
   proc alloc0Impl(size: Natural): pointer =
-    result = alloc0(allocator, size)
+    result = allocImpl(size)
+    zeroMem(result, size)
 
   proc deallocImpl(p: pointer) =
+    when declared(heapProfFree):
+      heapProfFree(p)
+    when defined(gcDestructors):
+      let c = arenaChunkOf(p)
+      if c != nil:
+        arenaDealloc(allocator, c, p)
+        return
     dealloc(allocator, p)
 
   proc reallocImpl(p: pointer, newSize: Natural): pointer =
+    when declared(heapProfFree):
+      # the caller samples the result again
+      if p != nil: heapProfFree(p)
+    when defined(gcDestructors):
+      if p != nil:
+        let c = arenaChunkOf(p)
+        if c != nil:
+          return arenaRealloc(allocator, c, p, newSize)
     result = realloc(allocator, p, newSize)
 
   proc realloc0Impl(p: pointer, oldSize, newSize: Natural): pointer =
-    result = realloc(allocator, p, newSize)
+    result = reallocImpl(p, newSize)
     if newSize > oldSize:
       zeroMem(cast[pointer](cast[uint](result) + uint(oldSize)), newSize - oldSize)
 
+  when defined(gcDestructors):
+    proc nimArenaOpen(): pointer {.compilerproc.} =
+      result = openArena(allocator)
+
+    proc nimArenaClose(ar: pointer): int {.compilerproc.} =
+      ## Returns the number of allocations that outlive the arena.
+      result = closeArena(allocator, cast[ptr MemArena](ar))
+
   when false:
     proc countFreeMem(): int =
       # only used for assertions
@@ -1267,6 +1563,13 @@ template instantiateForRegion(allocator: untyped) {.dirty.} =
   proc getMaxMem*(): int =
     result = getMaxMem(allocator)
 
+  when defined(nimHugePages):
+    proc getHugePageMem*(): int =
+      ## Returns the number of bytes owned by the thread's heap that are
+      ## aligned and advised for huge pages. Compare it to `getTotalMem`.
+      when declared(osHugePageBytes): result = allocator.hugeMem
+      else: result = 0
+
   when defined(nimTypeNames):
     proc getMemCounters*(): (int, int) = getMemCounters(allocator)
 
@@ -1278,7 +1581,8 @@ template instantiateForRegion(allocator: untyped) {.dirty.} =
       result = alloc(sharedHeap, size)
       releaseSys(heapLock)
     else:
-      result = allocImpl(size)
+      noArena:
+        result = allocImpl(size)
 
   proc allocShared0Impl(size: Natural): pointer =
     result = allocSharedImpl(size)
@@ -1298,7 +1602,8 @@ template instantiateForRegion(allocator: untyped) {.dirty.} =
       result = realloc(sharedHeap, p, newSize)
       releaseSys(heapLock)
     else:
-      result = reallocImpl(p, newSize)
+      noArena:
+        result = reallocImpl(p, newSize)
 
   proc reallocShared0Impl(p: pointer, oldSize, newSize: Natural): pointer =
     when hasThreadSupport and not defined(gcDestructors):
@@ -1306,7 +1611,8 @@ template instantiateForRegion(allocator: untyped) {.dirty.} =
       result = realloc0(sharedHeap, p, oldSize, newSize)
       releaseSys(heapLock)
     else:
-      result = realloc0Impl(p, oldSize, newSize)
+      noArena:
+        result = realloc0Impl(p, oldSize, newSize)
 
   when hasThreadSupport:
     when defined(gcDestructors):
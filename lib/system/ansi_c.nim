@@ -217,6 +217,15 @@ proc c_fwrite*(buf: pointer, size, n: csize_t, f: CFilePtr): csize_t {.
 proc c_fflush*(f: CFilePtr): cint {.
   importc: "fflush", header: "<stdio.h>".}
 
+proc c_fopen*(filename, mode: cstring): CFilePtr {.
+  importc: "fopen", header: "<stdio.h>".}
+proc c_fclose*(f: CFilePtr): cint {.
+  importc: "fclose", header: "<stdio.h>".}
+proc c_fread*(buf: pointer, size, n: csize_t, f: CFilePtr): csize_t {.
+  importc: "fread", header: "<stdio.h>".}
+proc c_fseek*(f: CFilePtr, offset: clong, whence: cint): cint {.
+  importc: "fseek", header: "<stdio.h>".}
+
 proc rawWriteString*(f: CFilePtr, s: cstring, length: int) {.compilerproc, nonReloadable, inline.} =
   # we cannot throw an exception here!
   discard c_fwrite(s, 1, cast[csize_t](length), f)
@@ -28,6 +28,24 @@ else:
 
 const
   orcLeakDetector = defined(nimOrcLeakDetector)
+  biasedRc = defined(gcAtomicArc) and hasThreadSupport and
+    hostOS != "standalone" and not defined(nimNoBiasedRc)
+
+when biasedRc:
+  # see brc.nim
+  const
+    sharedMerged = 0b01  # `shared` counts all references
+    sharedQueued = 0b10  # the object waits in its owner's merge queue
+    sharedIncrement = 0b100
+    sharedShift = 2
+
+  type
+    BiasedOwner = object
+      lock: int
+      alive: bool
+      len, cap: int
+      queue: ptr UncheckedArray[pointer] # cells to merge
+      next: ptr BiasedOwner # in the list of retired owners
 
 type
   RefHeader = object
@@ -37,6 +55,10 @@ type
     when defined(gcOrc):
       rootIdx: int # thanks to this we can delete potential cycle roots
                    # in O(1) without doubly linked lists
+    when biasedRc:
+      shared: int # counter of the other threads, can be negative until merged
+      owner: ptr BiasedOwner # nil once the counters are merged
+      rti: PNimTypeV2 # destroys objects whose last reference is dropped by a merge
     when defined(nimArcDebug) or defined(nimArcIds):
       refId: int
     when defined(gcOrc) and orcLeakDetector:
@@ -72,7 +94,18 @@ elif defined(nimArcIds):
 
   const traceId = -1
 
-when defined(gcAtomicArc) and hasThreadSupport:
+when biasedRc:
+  include brc
+
+  template decrement(cell: Cell): untyped =
+    if isOwner(cell): dec(cell.rc, rcIncrement)
+    else: discard atomicDec(cell.shared, sharedIncrement)
+  template increment(cell: Cell): untyped =
+    if isOwner(cell): inc(cell.rc, rcIncrement)
+    else: discard atomicInc(cell.shared, sharedIncrement)
+  template count(x: Cell): untyped =
+    (x.rc shr rcShift) + (atomicLoadN(x.shared.addr, ATOMIC_ACQUIRE) shr sharedShift)
+elif defined(gcAtomicArc) and hasThreadSupport:
   template decrement(cell: Cell): untyped =
     discard atomicDec(cell.rc, rcIncrement)
   template increment(cell: Cell): untyped =
@@ -97,6 +130,8 @@ proc nimNewObj(size, alignment: int): pointer {.compilerRtl.} =
     discard
   else:
     result = alignedAlloc0(s, alignment) +! hdrSize
+  when biasedRc:
+    head(result).shared = sharedMerged
   when defined(nimArcDebug) or defined(nimArcIds):
     head(result).refId = gRefId
     atomicInc gRefId
@@ -119,6 +154,10 @@ proc nimNewObjUninit(size, alignment: int): pointer {.compilerRtl.} =
   head(result).rc = 0
   when defined(gcOrc):
     head(result).rootIdx = 0
+  when biasedRc:
+    head(result).shared = sharedMerged
+    head(result).owner = nil
+    head(result).rti = nil
   when defined(nimArcDebug):
     head(result).refId = gRefId
     atomicInc gRefId
@@ -130,6 +169,26 @@ proc nimNewObjUninit(size, alignment: int): pointer {.compilerRtl.} =
     cprintf("[Allocated] %p result: %p\n", result -! sizeof(RefHeader), result)
   setFrameInfo head(result)
 
+when biasedRc or defined(nimHeapProfiler):
+  template typedObj(result: pointer; size, alignment: int; rti: PNimTypeV2) =
+    when biasedRc:
+      setOwner(head(result), rti)
+    when defined(nimHeapProfiler):
+      let hdrSize = align(sizeof(RefHeader), alignment)
+      heapProfAlloc(heapProfBlock(result -! hdrSize, alignment), size + hdrSize,
+        rti.name)
+
+  proc nimNewObjTyped(size, alignment: int; rti: PNimTypeV2): pointer {.compilerRtl.} =
+    # Used by `new` when the runtime needs the type: with biased reference
+    # counting the result belongs to the calling thread and the destructor
+    # is needed after merging, the heap profiler records the type's name.
+    result = nimNewObj(size, alignment)
+    typedObj(result, size, alignment, rti)
+
+  proc nimNewObjUninitTyped(size, alignment: int; rti: PNimTypeV2): pointer {.compilerRtl.} =
+    result = nimNewObjUninit(size, alignment)
+    typedObj(result, size, alignment, rti)
+
 proc nimDecWeakRef(p: pointer) {.compilerRtl, inl.} =
   decrement head(p)
 
@@ -143,7 +202,10 @@ proc isUniqueRef*[T](x: ref T): bool {.inline.} =
   ## Nevertheless it can be used as a very valuable debugging tool and can
   ## be used to specify the constraints of a threading related API
   ## via `assert isUniqueRef(x)`.
-  head(cast[pointer](x)).rc == 0
+  when biasedRc:
+    head(cast[pointer](x)).count == 0
+  else:
+    head(cast[pointer](x)).rc == 0
 
 proc nimIncRef(p: pointer) {.compilerRtl, inl.} =
   when defined(nimArcDebug):
@@ -223,7 +285,16 @@ proc nimDecRefIsLast(p: pointer): bool {.compilerRtl, inl.} =
         writeStackTrace()
         cfprintf(cstderr, "[DecRef] %p %ld\n", p, cell.count)
 
-    when defined(gcAtomicArc) and hasThreadSupport:
+    when biasedRc:
+      if not isOwner(cell):
+        result = sharedDecRefIsLast(cell)
+      elif cell.rc != 0:
+        dec(cell.rc, rcIncrement)
+      else:
+        result = releaseBias(cell)
+      when traceCollector:
+        if result: cprintf("[ABOUT TO DESTROY] %p\n", cell)
+    elif defined(gcAtomicArc) and hasThreadSupport:
       # `atomicDec` returns the new value
       if atomicDec(cell.rc, rcIncrement) == -rcIncrement:
         result = true
@@ -249,7 +320,13 @@ proc GC_ref*[T](x: ref T) =
   ## New runtime only supports this operation for 'ref T'.
   if x != nil: nimIncRef(cast[pointer](x))
 
-when not defined(gcOrc):
+when biasedRc:
+  proc GC_fullCollect* =
+    ## Forces a full garbage collection pass. With `--mm:atomicArc` this
+    ## merges the reference counts other threads queued for the current
+    ## thread, which can free objects that are no longer referenced.
+    if brcSelf != nil: mergeQueued(brcSelf)
+elif not defined(gcOrc):
   template GC_fullCollect* =
     ## Forces a full garbage collection pass. With `--mm:arc` a nop.
     discard
@@ -258,9 +335,15 @@ template setupForeignThreadGc* =
   ## With `--mm:arc` a nop.
   discard
 
-template tearDownForeignThreadGc* =
-  ## With `--mm:arc` a nop.
-  discard
+when biasedRc:
+  template tearDownForeignThreadGc* =
+    ## With `--mm:atomicArc` this hands the objects the thread allocated
+    ## over to the other threads.
+    retireBiasedOwner()
+else:
+  template tearDownForeignThreadGc* =
+    ## With `--mm:arc` a nop.
+    discard
 
 proc isObjDisplayCheck(source: PNimTypeV2, targetDepth: int16, token: uint32): bool {.compilerRtl, inl.} =
   result = targetDepth <= source.depth and source.display[targetDepth] == token
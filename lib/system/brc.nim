@@ -0,0 +1,172 @@
+#
+#
+#            Nim's Runtime Library
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+# included from arc.nim
+
+#[
+Biased reference counting for `--mm:atomicArc`, see "Biased Reference
+Counting: Minimizing Atomic Operations in Garbage Collection" by Choi,
+Shull and Torrellas.
+
+An owned object has `rc div rcIncrement + 1` references counted by its
+owner and `shared shr sharedShift` references counted by the other threads.
+The owner's count can become negative when the owner drops references that
+another thread added. When the owner drops the last reference it counted,
+the counters are merged right away. When the other threads drop more
+references than they added, the sum can reach zero while the owner still
+counts some, so the first such decrement puts the object into its owner's
+merge queue. The owner merges its queue when it allocates, in
+`GC_fullCollect` and when it exits. An object that waits in a queue is only
+freed by the merge.
+
+Once merged, `shared shr sharedShift` is the number of references minus
+one like `rc` of the other modes. Objects allocated without a type info
+(`nimNewObj` called by the runtime itself) start out merged.
+]#
+
+proc nimRawDispose(p: pointer, alignment: int) {.compilerRtl.}
+
+var
+  brcSelf {.threadvar.}: ptr BiasedOwner
+  brcRetired: ptr BiasedOwner
+  brcRetiredLock: int
+
+template acquireSpin(lock: var int) =
+  while not cas(addr lock, 0, 1): cpuRelax()
+
+template releaseSpin(lock: var int) =
+  atomicStoreN(addr lock, 0, ATOMIC_RELEASE)
+
+template isOwner(cell: Cell): bool =
+  # only the owner writes `owner`, the others can only see that it is not them
+  let o = atomicLoadN(addr cell.owner, ATOMIC_RELAXED)
+  o != nil and o == brcSelf
+
+proc currentOwner(): ptr BiasedOwner =
+  result = brcSelf
+  if result == nil:
+    acquireSpin brcRetiredLock
+    result = brcRetired
+    if result != nil: brcRetired = result.next
+    releaseSpin brcRetiredLock
+    if result == nil:
+      result = cast[ptr BiasedOwner](c_calloc(1, csize_t(sizeof(BiasedOwner))))
+    # the new thread adopts the objects of the thread that retired the record
+    acquireSpin result.lock
+    result.alive = true
+    result.next = nil
+    releaseSpin result.lock
+    brcSelf = result
+
+proc mergeBias(cell: Cell): bool =
+  ## Folds `rc` into `shared`. Returns true if no references are left.
+  let delta = (cell.rc div rcIncrement) * sharedIncrement + sharedMerged
+  cell.rc = 0
+  atomicStoreN(addr cell.owner, nil, ATOMIC_RELAXED)
+  result = (atomicInc(cell.shared, delta) shr sharedShift) == -1
+
+proc destroyMerged(cell: Cell) =
+  let p = cast[pointer](cast[int](cell) +% sizeof(RefHeader))
+  let rti = cell.rti
+  if rti.destructor != nil:
+    cast[DestructorProc](rti.destructor)(p)
+  nimRawDispose(p, rti.align)
+
+proc mergeQueued(o: ptr BiasedOwner) =
+  while true:
+    var cell: Cell = nil
+    acquireSpin o.lock
+    if o.len > 0:
+      dec o.len
+      cell = cast[Cell](o.queue[o.len])
+    releaseSpin o.lock
+    if cell == nil: break
+    if mergeBias(cell): destroyMerged(cell)
+
+proc setOwner(cell: Cell; rti: PNimTypeV2) {.inline.} =
+  let o = currentOwner()
+  cell.shared = 0
+  cell.owner = o
+  cell.rti = rti
+  if atomicLoadN(addr o.len, ATOMIC_RELAXED) > 0: mergeQueued(o)
+
+proc queueMerge(cell: Cell) =
+  var old = atomicLoadN(addr cell.shared, ATOMIC_ACQUIRE)
+  while true:
+    if (old and (sharedQueued or sharedMerged)) != 0: return
+    if cas(addr cell.shared, old, old or sharedQueued): break
+    old = atomicLoadN(addr cell.shared, ATOMIC_ACQUIRE)
+  # the owner clears `owner` while it tries to merge and restores it when it
+  # sees the queued bit
+  var o = atomicLoadN(addr cell.owner, ATOMIC_ACQUIRE)
+  while o == nil:
+    cpuRelax()
+    o = atomicLoadN(addr cell.owner, ATOMIC_ACQUIRE)
+  var dead = false
+  acquireSpin o.lock
+  if o.alive:
+    if o.len == o.cap:
+      o.cap = max(16, o.cap * 2)
+      o.queue = cast[ptr UncheckedArray[pointer]](c_realloc(o.queue,
+        csize_t(o.cap * sizeof(pointer))))
+    o.queue[o.len] = cell
+    inc o.len
+  else:
+    # `rc` does not change anymore; the lock orders the owner's last writes
+    dead = mergeBias(cell)
+  releaseSpin o.lock
+  if dead: destroyMerged(cell)
+
+proc sharedDecRefIsLast(cell: Cell): bool =
+  let n = atomicDec(cell.shared, sharedIncrement)
+  if (n and sharedMerged) != 0:
+    result = (n shr sharedShift) == -1
+  else:
+    result = false
+    if n < 0 and (n and sharedQueued) == 0: queueMerge(cell)
+
+proc releaseBias(cell: Cell): bool =
+  ## The owner drops the last reference it counted. Unless the object waits
+  ## in the merge queue already, `shared` becomes the only counter.
+  # `owner` is cleared before the merge: once it is visible another thread
+  # may free the cell
+  let o = cell.owner
+  atomicStoreN(addr cell.owner, nil, ATOMIC_RELAXED)
+  while true:
+    let old = atomicLoadN(addr cell.shared, ATOMIC_ACQUIRE)
+    if (old and sharedQueued) != 0:
+      dec(cell.rc, rcIncrement)
+      atomicStoreN(addr cell.owner, o, ATOMIC_RELEASE)
+      return false
+    if cas(addr cell.shared, old, old - sharedIncrement + sharedMerged):
+      return (old shr sharedShift) == 0
+
+proc retireBiasedOwner() =
+  ## Called when a thread exits. The objects it owns stay alive; merges
+  ## requested from now on are done by the requesting thread until a new
+  ## thread takes over the record.
+  let o = brcSelf
+  if o != nil:
+    # Drain the queue while the record is alive: the destructors run here
+    # write `rc` of owned objects without atomics, so no other thread may
+    # merge these cells before the queue is empty. The record dies in the
+    # same critical section that sees the queue empty and stops being ours.
+    while true:
+      mergeQueued(o)
+      acquireSpin o.lock
+      let empty = o.len == 0
+      if empty:
+        brcSelf = nil
+        o.alive = false
+      releaseSpin o.lock
+      if empty: break
+    acquireSpin brcRetiredLock
+    o.next = brcRetired
+    brcRetired = o
+    releaseSpin brcRetiredLock
@@ -16,13 +16,24 @@ type
     len, cap: int
     d: CellArray[T]
 
+template outsideArena(body) =
+  # the cycle collector's buffers outlive any arena
+  when declared(arenaState):
+    let ar = arenaState.top
+    arenaState.top = nil
+    body
+    arenaState.top = ar
+  else:
+    body
+
 proc resize[T](s: var CellSeq[T]) =
   s.cap = s.cap div 2 + s.cap
   var newSize = s.cap * sizeof(CellTuple[T])
-  when compileOption("threads"):
-    s.d = cast[CellArray[T]](reallocShared(s.d, newSize))
-  else:
-    s.d = cast[CellArray[T]](realloc(s.d, newSize))
+  outsideArena:
+    when compileOption("threads"):
+      s.d = cast[CellArray[T]](reallocShared(s.d, newSize))
+    else:
+      s.d = cast[CellArray[T]](realloc(s.d, newSize))
 
 proc add[T](s: var CellSeq[T], c: T, t: PNimTypeV2) {.inline.} =
   if s.len >= s.cap:
@@ -33,10 +44,11 @@ proc add[T](s: var CellSeq[T], c: T, t: PNimTypeV2) {.inline.} =
 proc init[T](s: var CellSeq[T], cap: int = 1024) =
   s.len = 0
   s.cap = cap
-  when compileOption("threads"):
-    s.d = cast[CellArray[T]](allocShared(uint(s.cap * sizeof(CellTuple[T]))))
-  else:
-    s.d = cast[CellArray[T]](alloc(s.cap * sizeof(CellTuple[T])))
+  outsideArena:
+    when compileOption("threads"):
+      s.d = cast[CellArray[T]](allocShared(uint(s.cap * sizeof(CellTuple[T]))))
+    else:
+      s.d = cast[CellArray[T]](alloc(s.cap * sizeof(CellTuple[T])))
 
 proc deinit[T](s: var CellSeq[T]) =
   if s.d != nil:
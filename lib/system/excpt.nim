@@ -169,6 +169,7 @@ const
   nativeStackTraceSupported = (defined(macosx) or defined(linux)) and
                               not NimStackTrace
   hasSomeStackTrace = NimStackTrace or defined(nimStackTraceOverride) or
+    defined(nimNativeStackTraces) or
     (defined(nativeStackTrace) and nativeStackTraceSupported)
 
 
@@ -270,7 +271,7 @@ template addFrameEntry(s: var string, f: StackTraceEntry|PFrame) =
   add(s, "\n")
 
 proc `$`(stackTraceEntries: seq[StackTraceEntry]): string =
-  when defined(nimStackTraceOverride):
+  when defined(nimStackTraceOverride) or defined(nimNativeStackTraces):
     let s = addDebuggingInfo(stackTraceEntries)
   else:
     let s = stackTraceEntries
@@ -338,6 +339,15 @@ when hasSomeStackTrace:
       else:
         add(s, "Traceback (most recent call last)\n")
         auxWriteStackTrace(framePtr, s)
+    elif defined(nimNativeStackTraces):
+      var entries: seq[StackTraceEntry] = @[]
+      nativeCaptureStackTrace(entries)
+      nativeResolveStackTrace(entries)
+      if entries.len == 0:
+        add(s, noStacktraceAvailable)
+      else:
+        add(s, "Traceback (most recent call last)\n")
+        for i in 0..<entries.len: addFrameEntry(s, entries[i])
     elif defined(nativeStackTrace) and nativeStackTraceSupported:
       add(s, "Traceback from system (most recent call last)\n")
       auxWriteStackTraceWithBacktrace(s)
@@ -349,6 +359,8 @@ when hasSomeStackTrace:
       auxWriteStackTraceWithOverride(s)
     elif NimStackTrace:
       auxWriteStackTrace(framePtr, s)
+    elif defined(nimNativeStackTraces):
+      nativeCaptureStackTrace(s)
     else:
       s = @[]
 
@@ -360,6 +372,8 @@ when hasSomeStackTrace:
         result = false
       else:
         result = true
+    elif defined(nimNativeStackTraces):
+      result = true
     elif defined(nativeStackTrace) and nativeStackTraceSupported:
       result = true
     else:
@@ -375,6 +389,8 @@ var onUnhandledException*: (proc (errorMsg: string) {.
   ## Unstable API.
 
 proc reportUnhandledErrorAux(e: ref Exception) {.nodestroy, gcsafe.} =
+  when defined(nimNativeStackTraces):
+    nativeResolveStackTrace(e.trace)
   when hasSomeStackTrace:
     var buf = newStringOfCap(2000)
     if e.trace.len == 0:
@@ -499,6 +515,14 @@ proc raiseExceptionEx(e: sink(ref Exception), ename, procname, filename: cstring
         e.trace.add reraisedFrom(reraisedFromBegin)
         auxWriteStackTrace(framePtr, e.trace)
         e.trace.add reraisedFrom(reraisedFromEnd)
+    elif defined(nimNativeStackTraces):
+      # only the addresses, they are resolved when the trace is looked at
+      if e.trace.len == 0:
+        nativeCaptureStackTrace(e.trace)
+      else:
+        e.trace.add reraisedFrom(reraisedFromBegin)
+        nativeCaptureStackTrace(e.trace)
+        e.trace.add reraisedFrom(reraisedFromEnd)
   else:
     if procname != nil and filename != nil:
       e.trace.add StackTraceEntry(procname: procname, filename: filename, line: line)
@@ -541,6 +565,8 @@ proc getStackTrace(): string =
 
 proc getStackTrace(e: ref Exception): string =
   if not isNil(e):
+    when defined(nimNativeStackTraces):
+      nativeResolveStackTrace(e.trace)
     result = $e.trace
   else:
     result = ""
@@ -548,6 +574,8 @@ proc getStackTrace(e: ref Exception): string =
 proc getStackTraceEntries*(e: ref Exception): lent seq[StackTraceEntry] =
   ## Returns the attached stack trace to the exception `e` as
   ## a `seq`. This is not yet available for the JS backend.
+  when defined(nimNativeStackTraces):
+    nativeResolveStackTrace(e.trace)
   e.trace
 
 proc getStackTraceEntries*(): seq[StackTraceEntry] =
@@ -555,6 +583,8 @@ proc getStackTraceEntries*(): seq[StackTraceEntry] =
   ## This is not yet available for the JS backend.
   when hasSomeStackTrace:
     rawWriteStackTrace(result)
+    when defined(nimNativeStackTraces):
+      nativeResolveStackTrace(result)
 
 const nimCallDepthLimit {.intdefine.} = 2000
 
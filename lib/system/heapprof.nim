@@ -0,0 +1,334 @@
+#
+#
+#            Nim's Runtime Library
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+# included from system.nim
+
+#[
+Sampling heap profiler for the `nimSeqsV2` memory managers, enabled with
+`-d:nimHeapProfiler`. Every thread counts down the bytes it allocates for
+refs, seqs and strings; when the count drops below zero the allocation is
+sampled with its type name and call stack, and the next distance is drawn
+from an exponential distribution with a mean of `heapProfRate` bytes. The
+samples that are still alive are kept in a hash table keyed by the address
+of the block, the allocator removes them when the block is freed.
+
+`std/heapprofiler` writes the live samples as a pprof profile. All of this
+uses C's allocator so that it can run inside Nim's.
+]#
+
+{.push stackTrace: off, profiler: off.}
+
+const
+  nimHeapProfileRate {.intdefine.} = 512 * 1024
+  HeapProfMaxDepth = 32
+  HeapProfBuckets = 1 shl 20
+
+type
+  HeapSample = object
+    p: pointer       # the block as the allocator sees it
+    size: int
+    name: cstring
+    depth: int
+    stack: array[HeapProfMaxDepth, pointer]
+    next: ptr HeapSample
+
+  HeapSampleTable = ptr UncheckedArray[ptr HeapSample]
+
+var
+  heapProfRate = nimHeapProfileRate
+  heapProfTable: HeapSampleTable # allocated with the first sample
+  heapProfLock: int
+  heapProfDumpFile: pointer # a cstring set by a signal handler, see `std/heapprofiler`
+  heapProfNext {.threadvar.}: int
+  heapProfRandom {.threadvar.}: uint32
+
+proc c_log(x: float): float {.importc: "log", header: "<math.h>", noSideEffect.}
+
+when defined(linux) or defined(macosx):
+  proc backtrace(buffer: ptr pointer; size: cint): cint {.
+    importc, header: "<execinfo.h>".}
+
+template heapProfAcquire() =
+  when hasThreadSupport:
+    while not cas(addr heapProfLock, 0, 1): cpuRelax()
+
+template heapProfRelease() =
+  when hasThreadSupport:
+    atomicStoreN(addr heapProfLock, 0, ATOMIC_RELEASE)
+
+template heapProfBucket(p: pointer): int =
+  let x = cast[uint](p) shr 4
+  int((x xor (x shr 20)) and uint(HeapProfBuckets - 1))
+
+proc heapProfDistance(): int =
+  ## The number of bytes until the next sample.
+  if heapProfRandom == 0:
+    heapProfRandom = uint32(cast[uint](addr heapProfRandom) shr 4) or 1
+  var x = heapProfRandom # xorshift32
+  x = x xor (x shl 13)
+  x = x xor (x shr 17)
+  x = x xor (x shl 5)
+  heapProfRandom = x
+  let u = (float(x shr 8) + 1.0) / 16777217.0
+  result = int(-c_log(u) * float(heapProfRate)) + 1
+
+proc heapProfDumpPending()
+
+proc heapProfSample(p: pointer; size: int; name: cstring) {.noinline.} =
+  let first = heapProfNext == 0 and heapProfRandom == 0
+  heapProfNext = heapProfDistance()
+  # the first call of a thread only starts the count down
+  if first: return
+  let s = cast[ptr HeapSample](c_malloc(csize_t(sizeof(HeapSample))))
+  if s == nil: return
+  s.p = p
+  s.size = size
+  s.name = name
+  when declared(backtrace):
+    s.depth = int(backtrace(addr s.stack[0], HeapProfMaxDepth))
+  else:
+    s.depth = 0
+  heapProfAcquire()
+  if heapProfTable == nil:
+    heapProfTable = cast[HeapSampleTable](c_calloc(HeapProfBuckets,
+      csize_t(sizeof(pointer))))
+  if heapProfTable != nil:
+    let h = heapProfBucket(p)
+    s.next = heapProfTable[h]
+    heapProfTable[h] = s
+  heapProfRelease()
+  if heapProfTable == nil: c_free(s)
+  if heapProfDumpFile != nil: heapProfDumpPending()
+
+template heapProfAlloc(p: pointer; size: int; name: cstring) =
+  ## Called for every allocation of a ref, seq or string payload.
+  heapProfNext -= size
+  if heapProfNext < 0: heapProfSample(p, size, name)
+
+template heapProfBlock(p: pointer; align: int): pointer =
+  # see `alignedAlloc`
+  if align <= MemAlign: p
+  else: p -! int(cast[ptr uint16](p -! sizeof(uint16))[])
+
+proc heapProfForget(p: pointer) {.noinline.} =
+  heapProfAcquire()
+  var it = addr heapProfTable[heapProfBucket(p)]
+  while it[] != nil:
+    let s = it[]
+    if s.p == p:
+      it[] = s.next
+      heapProfRelease()
+      c_free(s)
+      return
+    it = addr s.next
+  heapProfRelease()
+
+template heapProfFree(p: pointer) =
+  ## Called by the allocator for every block it frees or resizes.
+  let t = heapProfTable
+  if t != nil and t[heapProfBucket(p)] != nil: heapProfForget(p)
+
+# ---------------------- pprof output ---------------------------------------
+
+# The profile is an uncompressed `perftools.profiles.Profile` protocol buffer,
+# see https://github.com/google/pprof/blob/main/proto/profile.proto
+
+type
+  PbBuffer = object
+    data: ptr UncheckedArray[byte]
+    len, cap: int
+
+proc pbByte(b: var PbBuffer; x: byte) =
+  if b.len == b.cap:
+    b.cap = max(256, b.cap * 2)
+    b.data = cast[ptr UncheckedArray[byte]](c_realloc(b.data, csize_t(b.cap)))
+  b.data[b.len] = x
+  inc b.len
+
+proc pbVarint(b: var PbBuffer; x: uint64) =
+  var x = x
+  while x >= 0x80'u64:
+    b.pbByte(byte(x and 0x7f) or 0x80)
+    x = x shr 7
+  b.pbByte(byte(x))
+
+proc pbInt(b: var PbBuffer; field: int; x: int64) =
+  if x != 0:
+    b.pbVarint(uint64(field shl 3))
+    b.pbVarint(cast[uint64](x))
+
+proc pbBytes(b: var PbBuffer; field: int; p: pointer; len: int) =
+  b.pbVarint(uint64(field shl 3 or 2))
+  b.pbVarint(uint64(len))
+  for i in 0..<len: b.pbByte(cast[ptr UncheckedArray[byte]](p)[i])
+
+proc pbMessage(b: var PbBuffer; field: int; msg: var PbBuffer) =
+  ## Appends `msg` as a field of `b` and clears `msg` for reuse.
+  b.pbBytes(field, msg.data, msg.len)
+  msg.len = 0
+
+proc pbFree(b: var PbBuffer) =
+  if b.data != nil: c_free(b.data)
+  b = PbBuffer()
+
+type
+  PbStrings = object
+    ## The string table; the index of a string is its position.
+    items: ptr UncheckedArray[cstring]
+    len, cap: int
+
+proc strIndex(t: var PbStrings; s: cstring): int64 =
+  for i in 0..<t.len:
+    if t.items[i] == s or c_strcmp(t.items[i], s) == 0: return i
+  if t.len == t.cap:
+    t.cap = max(32, t.cap * 2)
+    t.items = cast[ptr UncheckedArray[cstring]](c_realloc(t.items,
+      csize_t(t.cap * sizeof(cstring))))
+  t.items[t.len] = s
+  result = t.len
+  inc t.len
+
+type
+  ProcMapping = object
+    start, limit, offset: uint64
+    file: array[256, char]
+
+proc c_fgets(buf: cstring; n: cint; f: CFilePtr): cstring {.
+  importc: "fgets", header: "<stdio.h>".}
+proc c_sscanf(s, frmt: cstring): cint {.importc: "sscanf", header: "<stdio.h>", varargs.}
+
+proc readMappings(n: var int): ptr UncheckedArray[ProcMapping] =
+  ## The executable mappings of the process, needed to symbolize addresses.
+  result = nil
+  n = 0
+  when defined(linux):
+    let f = c_fopen("/proc/self/maps", "r")
+    if f == nil: return
+    var cap = 0
+    var line: array[512, char]
+    while c_fgets(cast[cstring](addr line), line.len.cint, f) != nil:
+      var m: ProcMapping
+      var perms: array[8, char]
+      m.file[0] = '\0'
+      if c_sscanf(cast[cstring](addr line), "%llx-%llx %4s %llx %*s %*s %255s",
+          addr m.start, addr m.limit, addr perms, addr m.offset, addr m.file) >= 4 and
+          perms[2] == 'x':
+        if n == cap:
+          cap = max(16, cap * 2)
+          result = cast[ptr UncheckedArray[ProcMapping]](c_realloc(result,
+            csize_t(cap * sizeof(ProcMapping))))
+        result[n] = m
+        inc n
+    discard c_fclose(f)
+
+proc c_exp(x: float): float {.importc: "exp", header: "<math.h>", noSideEffect.}
+
+proc heapProfWrite(filename: cstring): bool =
+  ## Writes the live samples to `filename`. Must be called with the lock
+  ## held.
+  var strs = PbStrings()
+  discard strs.strIndex("")
+  var prof, msg, inner = PbBuffer()
+  let
+    objectsStr = strs.strIndex("inuse_objects")
+    countStr = strs.strIndex("count")
+    spaceStr = strs.strIndex("inuse_space")
+    bytesStr = strs.strIndex("bytes")
+    typeStr = strs.strIndex("type")
+    unknownStr = strs.strIndex("?")
+  for (t, u) in [(objectsStr, countStr), (spaceStr, bytesStr)]:
+    msg.pbInt(1, t)
+    msg.pbInt(2, u)
+    prof.pbMessage(1, msg)
+
+  var mappingCount = 0
+  let mappings = readMappings(mappingCount)
+  for i in 0..<mappingCount:
+    let m = addr mappings[i]
+    msg.pbInt(1, i + 1)
+    msg.pbInt(2, cast[int64](m.start))
+    msg.pbInt(3, cast[int64](m.limit))
+    msg.pbInt(4, cast[int64](m.offset))
+    msg.pbInt(5, strs.strIndex(cast[cstring](addr m.file)))
+    prof.pbMessage(3, msg)
+
+  # every frame gets its own location; pprof merges equal addresses
+  var locId = 0'i64
+  let rate = float(heapProfRate)
+  for h in 0..<HeapProfBuckets:
+    var s = heapProfTable[h]
+    while s != nil:
+      let first = locId + 1
+      for i in 0..<s.depth:
+        inc locId
+        let address = cast[uint64](s.stack[i])
+        msg.pbInt(1, locId)
+        for j in 0..<mappingCount:
+          if address >= mappings[j].start and address < mappings[j].limit:
+            msg.pbInt(2, j + 1)
+            break
+        # return addresses point after the call
+        msg.pbInt(3, cast[int64](if i == 0: address else: address - 1))
+        prof.pbMessage(4, msg)
+      for id in first..locId: inner.pbVarint(uint64(id))
+      msg.pbMessage(1, inner)
+      # the sample stands for all the bytes its count down skipped
+      let weight = 1.0 / (1.0 - c_exp(-float(s.size) / rate))
+      inner.pbVarint(uint64(weight + 0.5))
+      inner.pbVarint(uint64(float(s.size) * weight + 0.5))
+      msg.pbMessage(2, inner)
+      inner.pbInt(1, typeStr)
+      inner.pbInt(2, if s.name != nil: strs.strIndex(s.name) else: unknownStr)
+      msg.pbMessage(3, inner)
+      inner.pbInt(1, bytesStr)
+      inner.pbInt(3, s.size)
+      msg.pbMessage(3, inner)
+      prof.pbMessage(2, msg)
+      s = s.next
+
+  for i in 0..<strs.len:
+    prof.pbBytes(6, strs.items[i], int(c_strlen(strs.items[i])))
+  msg.pbInt(1, spaceStr)
+  msg.pbInt(2, bytesStr)
+  prof.pbMessage(11, msg)
+  prof.pbInt(12, heapProfRate)
+
+  let f = c_fopen(filename, "wb")
+  result = f != nil
+  if result:
+    result = c_fwrite(prof.data, 1, csize_t(prof.len), f) == csize_t(prof.len)
+    result = c_fclose(f) == 0 and result
+  pbFree prof
+  pbFree msg
+  pbFree inner
+  if strs.items != nil: c_free(strs.items)
+  if mappings != nil: c_free(mappings)
+
+proc nimHeapProfDump(filename: cstring): bool {.compilerproc.} =
+  heapProfAcquire()
+  if heapProfTable == nil:
+    heapProfTable = cast[HeapSampleTable](c_calloc(HeapProfBuckets,
+      csize_t(sizeof(pointer))))
+  result = heapProfTable != nil and heapProfWrite(filename)
+  heapProfRelease()
+
+proc heapProfDumpPending() =
+  let file = atomicExchangeN(addr heapProfDumpFile, nil, ATOMIC_ACQ_REL)
+  if file != nil: discard nimHeapProfDump(cast[cstring](file))
+
+proc nimHeapProfRequestDump(filename: cstring) {.compilerproc.} =
+  ## Async signal safe: the next sampled allocation writes the profile.
+  atomicStoreN(addr heapProfDumpFile, cast[pointer](filename), ATOMIC_RELEASE)
+
+proc nimHeapProfSetRate(bytes: int) {.compilerproc.} =
+  heapProfRate = max(bytes, 1)
+  # the calling thread draws its next distance with the new rate
+  heapProfNext = 0
+
+{.pop.}
@@ -60,6 +60,28 @@ when hasAlloc and not defined(js):
   proc reallocSharedImpl*(p: pointer, newSize: Natural): pointer {.noconv, rtl, tags: [], benign, raises: [].}
   proc reallocShared0Impl*(p: pointer, oldSize, newSize: Natural): pointer {.noconv, rtl, tags: [], benign, raises: [].}
 
+  when defined(gcDestructors) and not defined(useMalloc):
+    type
+      ArenaChunk = object
+        arena: ptr MemArena
+        raw: pointer           # the heap block the chunk is aligned in
+        next: ptr ArenaChunk
+        size: int              # including this header
+      MemArena = object
+        owner: pointer         # the thread's MemRegion
+        chunks: ptr ArenaChunk # the current chunk comes first
+        pos, limit: int        # the free part of the current chunk
+        last: int              # the latest allocation, it can grow in place
+        live: int              # allocations not freed by the owner yet
+        foreign: int           # atomic, frees by other threads or after closing
+        open: bool
+        nextChunkSize: int
+        next: ptr MemArena     # the enclosing arena
+      ArenaState = object
+        top: ptr MemArena     # the innermost open arena, see `std/arenas`
+
+    var arenaState {.rtlThreadVar.}: ArenaState
+
   # Allocator statistics for memory leak tests
 
   {.push stackTrace: off.}
@@ -317,6 +339,38 @@ when hasAlloc and not defined(js):
     ## or other memory may be corrupted.
     deallocShared(p)
 
+  # The payloads of refs, strings and seqs. With threads they can be freed
+  # by any thread, like memory from `allocShared`, but unlike that they are
+  # taken from the thread's open arena, see `std/arenas`.
+  when defined(gcDestructors) and not defined(useMalloc):
+    template payloadAlloc(size: Natural): pointer =
+      incStat(allocCount)
+      allocImpl(size)
+
+    template payloadAlloc0(size: Natural): pointer =
+      incStat(allocCount)
+      alloc0Impl(size)
+
+    template payloadRealloc(p: pointer, newSize: Natural): pointer =
+      reallocImpl(p, newSize)
+
+    template payloadRealloc0(p: pointer, oldSize, newSize: Natural): pointer =
+      realloc0Impl(p, oldSize, newSize)
+  elif compileOption("threads"):
+    template payloadAlloc(size: Natural): pointer = allocShared(size)
+    template payloadAlloc0(size: Natural): pointer = allocShared0(size)
+    template payloadRealloc(p: pointer, newSize: Natural): pointer =
+      reallocShared(p, newSize)
+    template payloadRealloc0(p: pointer, oldSize, newSize: Natural): pointer =
+      reallocShared0(p, oldSize, newSize)
+  else:
+    template payloadAlloc(size: Natural): pointer = alloc(size)
+    template payloadAlloc0(size: Natural): pointer = alloc0(size)
+    template payloadRealloc(p: pointer, newSize: Natural): pointer =
+      realloc(p, newSize)
+    template payloadRealloc0(p: pointer, oldSize, newSize: Natural): pointer =
+      realloc0(p, oldSize, newSize)
+
   include bitmasks
 
   template `+!`(p: pointer, s: SomeInteger): pointer =
@@ -327,17 +381,11 @@ when hasAlloc and not defined(js):
 
   proc alignedAlloc(size, align: Natural): pointer =
     if align <= MemAlign:
-      when compileOption("threads"):
-        result = allocShared(size)
-      else:
-        result = alloc(size)
+      result = payloadAlloc(size)
     else:
       # allocate (size + align - 1) necessary for alignment,
       # plus 2 bytes to store offset
-      when compileOption("threads"):
-        let base = allocShared(size + align - 1 + sizeof(uint16))
-      else:
-        let base = alloc(size + align - 1 + sizeof(uint16))
+      let base = payloadAlloc(size + align - 1 + sizeof(uint16))
       # memory layout: padding + offset (2 bytes) + user_data
       # in order to deallocate: read offset at user_data - 2 bytes,
       # then deallocate user_data - offset
@@ -347,16 +395,10 @@ when hasAlloc and not defined(js):
 
   proc alignedAlloc0(size, align: Natural): pointer =
     if align <= MemAlign:
-      when compileOption("threads"):
-        result = allocShared0(size)
-      else:
-        result = alloc0(size)
+      result = payloadAlloc0(size)
     else:
       # see comments for alignedAlloc
-      when compileOption("threads"):
-        let base = allocShared0(size + align - 1 + sizeof(uint16))
-      else:
-        let base = alloc0(size + align - 1 + sizeof(uint16))
+      let base = payloadAlloc0(size + align - 1 + sizeof(uint16))
       let offset = align - (cast[int](base) and (align - 1))
       cast[ptr uint16](base +! (offset - sizeof(uint16)))[] = uint16(offset)
       result = base +! offset
@@ -377,10 +419,7 @@ when hasAlloc and not defined(js):
 
   proc alignedRealloc(p: pointer, oldSize, newSize, align: Natural): pointer =
     if align <= MemAlign:
-      when compileOption("threads"):
-        result = reallocShared(p, newSize)
-      else:
-        result = realloc(p, newSize)
+      result = payloadRealloc(p, newSize)
     else:
       result = alignedAlloc(newSize, align)
       copyMem(result, p, oldSize)
@@ -388,10 +427,7 @@ when hasAlloc and not defined(js):
 
   proc alignedRealloc0(p: pointer, oldSize, newSize, align: Natural): pointer =
     if align <= MemAlign:
-      when compileOption("threads"):
-        result = reallocShared0(p, oldSize, newSize)
-      else:
-        result = realloc0(p, oldSize, newSize)
+      result = payloadRealloc0(p, oldSize, newSize)
     else:
       result = alignedAlloc(newSize, align)
       copyMem(result, p, oldSize)
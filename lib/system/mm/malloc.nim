@@ -14,6 +14,8 @@ proc alloc0Impl(size: Natural): pointer =
       raiseOutOfMem()
 
 proc reallocImpl(p: pointer, newSize: Natural): pointer =
+  when declared(heapProfFree):
+    if p != nil: heapProfFree(p)
   result = c_realloc(p, newSize.csize_t)
   when defined(zephyr):
     if result == nil:
@@ -25,6 +27,8 @@ proc realloc0Impl(p: pointer, oldsize, newSize: Natural): pointer =
     zeroMem(cast[pointer](cast[uint](result) + uint(oldSize)), newSize - oldSize)
 
 proc deallocImpl(p: pointer) =
+  when declared(heapProfFree):
+    heapProfFree(p)
   c_free(p)
 
 
@@ -0,0 +1,124 @@
+#
+#
+#            Nim's Runtime Library
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+# included from stacktraces.nim
+
+#[
+Stack traces for `--stackTrace:native`. The generated code keeps no frames
+of its own: a stack trace is the list of return addresses found by following
+the frame pointers, which costs nothing until something is raised. The
+addresses are turned into procs, files and lines by `nativesymbols.nim`, only
+when the trace is printed or inspected. Walking the frames needs
+`__builtin_frame_address`, that is GCC or Clang; the walk ends at the top of
+the thread's stack, as reported by pthreads on Linux and macOS.
+]#
+
+when not (defined(gcc) or defined(clang) or defined(llvm_gcc)):
+  {.error: "--stackTrace:native needs GCC or Clang".}
+
+when defined(linux) and not compileOption("threads"):
+  {.passl: "-pthread".} # `pthread_getattr_np` is in libpthread before glibc 2.34
+
+{.emit: """/*TYPESECTION*/
+#if defined(__linux__) || defined(__APPLE__)
+#  include <pthread.h>
+#endif
+#if defined(__linux__)
+extern int pthread_getattr_np(pthread_t, pthread_attr_t*);
+#endif
+static NU nimNativeStackEnd(void) {
+  NU result = ~(NU)0;
+#if defined(__linux__)
+  pthread_attr_t attr;
+  void* addr;
+  size_t size;
+  if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0) result = (NU)addr + size;
+    pthread_attr_destroy(&attr);
+  }
+#elif defined(__APPLE__)
+  result = (NU)pthread_get_stackaddr_np(pthread_self());
+#endif
+  return result;
+}
+""".}
+
+proc stackEnd(): uint {.importc: "nimNativeStackEnd", nodecl.}
+
+const
+  nativeMaxFrameSize = 1'u shl 20 # a larger step is not a frame of this stack
+
+var nativeStackEnd {.threadvar.}: uint # the highest address of the stack; 0: not known yet
+
+proc nativeCaptureStackTrace*(s: var seq[StackTraceEntry]) {.noinline.} =
+  ## Appends the return addresses on the stack of the calling thread to `s`,
+  ## the outermost call first.
+  var frame: pointer = nil
+  {.emit: "`frame` = __builtin_frame_address(0);".}
+  if nativeStackEnd == 0: nativeStackEnd = stackEnd()
+  let last = nativeStackEnd - uint(2 * sizeof(pointer))
+  var pcs {.noinit.}: array[maxStackTraceLines, uint]
+  var n = 0
+  var fp = cast[uint](frame)
+  # every frame starts with the caller's frame pointer and the return address
+  while n < pcs.len and fp != 0 and fp <= last and
+      (fp and uint(sizeof(pointer) - 1)) == 0:
+    let f = cast[ptr array[2, uint]](fp)
+    if f[1] == 0: break
+    pcs[n] = f[1]
+    inc n
+    let next = f[0]
+    if next <= fp or next - fp >= nativeMaxFrameSize: break
+    fp = next
+  let first = s.len
+  s.setLen(first + n)
+  for i in 0..<n:
+    s[first + i] = StackTraceEntry(programCounter: pcs[n - 1 - i])
+
+proc isRuntimeFile(file: string): bool =
+  ## The frames of raising and capturing are not shown.
+  let name = baseName(file)
+  result = name == "excpt.nim" or name == "stacktraces.nim" or
+    name == "nativestacktraces.nim"
+
+proc nativeResolveStackTrace*(s: var seq[StackTraceEntry]) =
+  ## Fills in the procs, files and lines of the entries added by
+  ## `nativeCaptureStackTrace` and removes the frames that are not Nim code.
+  var frames: seq[NativeFrame] = @[]
+  for i in 0..<s.len:
+    if s[i].programCounter != 0 and s[i].procname == nil:
+      # return addresses point after the call
+      frames.add NativeFrame(pc: s[i].programCounter - 1, entry: i)
+  if frames.len == 0: return
+
+  var keep = newSeq[bool](s.len)
+  for i in 0..<s.len: keep[i] = true
+  withNativeLock:
+    nativeSymbolize(frames)
+    var module = ""
+    for fr in frames:
+      if (defined(linux) and not fr.file.endsWith(".nim")) or isRuntimeFile(fr.file):
+        keep[fr.entry] = false
+      else:
+        s[fr.entry].procname = intern(nativeProcName(fr.sym, fr.file, module))
+        s[fr.entry].filename = intern(
+          when compileOption("excessiveStackTrace"): fr.file else: baseName(fr.file))
+        s[fr.entry].line = fr.line
+
+  var j = 0
+  for i in 0..<s.len:
+    if keep[i]:
+      if i != j: s[j] = move s[i]
+      inc j
+  s.setLen(j)
+
+proc addDebuggingInfo*(s: seq[StackTraceEntry]): seq[StackTraceEntry] =
+  ## Returns `s` with the procs, files and lines resolved.
+  result = s
+  nativeResolveStackTrace(result)
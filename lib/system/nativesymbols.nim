@@ -0,0 +1,590 @@
+#
+#
+#            Nim's Runtime Library
+#        (c) Copyright 2024 Nim contributors
+#
+#    See the file "copying.txt", included in this
+#    distribution, for details about the copyright.
+#
+
+# included from stacktraces.nim
+
+#[
+Turns code addresses of the running program into procs, files and lines, for
+`--stackTrace:native` and for `std/cpuprofiler` via `nimNativeSymbolize`.
+The symbol table and the DWARF line table of the executable are read once
+per process, the first time an address is resolved, into sorted tables
+outside of the GC'ed heap. Thanks to the `#line` directives in the generated
+C code the line table refers to the Nim sources.
+
+Resolving files and lines needs Linux and an ELF executable; addresses in
+shared libraries, and all addresses on other POSIX systems, only get the
+names of exported functions, via `dladdr`.
+]#
+
+import ansi_c
+
+when compileOption("threads"):
+  import std/sysatomics
+
+type
+  NativeFrame = object
+    pc: uint       # the address of the call
+    entry: int     # the index in the stack trace
+    sym: string    # the C function
+    file: string
+    line: int
+
+when defined(linux):
+  type
+    DlPhdrInfo {.importc: "struct dl_phdr_info", header: "<link.h>",
+                 final, pure.} = object
+      dlpi_addr: uint
+
+    ElfHeader = object
+      ident: array[16, uint8]
+      kind, machine: uint16
+      version: uint32
+      entry, phoff, shoff: uint64
+      flags: uint32
+      ehsize, phentsize, phnum, shentsize, shnum, shstrndx: uint16
+
+    ElfSection = object
+      name, kind: uint32
+      flags, address, offset, size: uint64
+      link, info: uint32
+      addralign, entsize: uint64
+
+    ElfSym = object
+      name: uint32
+      info, other: uint8
+      shndx: uint16
+      value, size: uint64
+
+    Section = object
+      data: ptr UncheckedArray[uint8] # followed by a zero byte
+      size: int
+
+  const
+    ShtSymtab = 2'u32
+    ShtDynsym = 11'u32
+    ShfCompressed = 0x800'u64
+    SttFunc = 2'u8
+
+  proc dl_iterate_phdr(callback: proc (info: ptr DlPhdrInfo; size: csize_t;
+                       data: pointer): cint {.cdecl.}; data: pointer): cint {.
+    importc, header: "<link.h>".}
+
+  proc mainProgramBias(info: ptr DlPhdrInfo; size: csize_t;
+                       data: pointer): cint {.cdecl.} =
+    # the main program comes first
+    cast[ptr uint](data)[] = info.dlpi_addr
+    result = 1
+
+  proc readAt(f: CFilePtr; offset: uint64; p: pointer; size: int): bool =
+    result = c_fseek(f, clong(offset), 0) == 0 and
+      c_fread(p, 1, csize_t(size), f) == csize_t(size)
+
+  proc readSection(f: CFilePtr; sh: ElfSection): Section =
+    result = Section()
+    if sh.size == 0 or (sh.flags and ShfCompressed) != 0: return
+    let p = cast[ptr UncheckedArray[uint8]](c_malloc(csize_t(sh.size + 1)))
+    if p == nil: return
+    if readAt(f, sh.offset, p, int(sh.size)):
+      p[sh.size] = 0
+      result = Section(data: p, size: int(sh.size))
+    else:
+      c_free(p)
+
+  proc free(s: Section) =
+    if s.data != nil: c_free(s.data)
+
+  proc at(s: Section; offset: uint64): cstring =
+    if offset < uint64(s.size): cast[cstring](addr s.data[offset]) else: nil
+
+  # ---------------------- the tables of the process ------------------------
+
+  type
+    NativeArray[T] = object
+      data: ptr UncheckedArray[T]
+      len, cap: int
+
+    NativeFunc = object
+      start, size: uint # relative to the load address
+      name: cstring     # points into the kept string table
+
+    NativeRow = object
+      address: uint # relative to the load address, the row covers the
+                    # addresses up to the next row
+      file: int32   # index in `nativeFiles`; -1: no Nim code or the end
+                    # of a sequence
+      line: int32
+
+  var
+    nativeTablesBuilt: bool # guarded by `nativeLock`, like the tables
+    nativeBias: uint
+    nativeFuncs: NativeArray[NativeFunc]
+    nativeRows: NativeArray[NativeRow]
+    nativeFiles: NativeArray[cstring]
+
+  proc add[T](a: var NativeArray[T]; x: T) =
+    if a.len == a.cap:
+      let cap = max(64, a.cap * 2)
+      let p = c_realloc(a.data, csize_t(cap * sizeof(T)))
+      if p == nil: return
+      a.data = cast[ptr UncheckedArray[T]](p)
+      a.cap = cap
+    a.data[a.len] = x
+    inc a.len
+
+  proc less(a, b: NativeFunc): bool {.inline.} = a.start < b.start
+  proc less(a, b: NativeRow): bool {.inline.} =
+    # the end of a sequence comes before a sequence that starts there
+    a.address < b.address or (a.address == b.address and a.file < b.file)
+
+  proc siftDown[T](a: var NativeArray[T]; start, n: int) =
+    var i = start
+    while true:
+      var c = 2 * i + 1
+      if c >= n: break
+      if c + 1 < n and less(a.data[c], a.data[c + 1]): inc c
+      if not less(a.data[i], a.data[c]): break
+      swap(a.data[i], a.data[c])
+      i = c
+
+  proc sort[T](a: var NativeArray[T]) =
+    ## Heapsort; the tables are mostly sorted already and then left alone.
+    var sorted = true
+    for i in 1..<a.len:
+      if less(a.data[i], a.data[i - 1]):
+        sorted = false
+        break
+    if sorted: return
+    for i in countdown(a.len div 2 - 1, 0): siftDown(a, i, a.len)
+    for n in countdown(a.len - 1, 1):
+      swap(a.data[0], a.data[n])
+      siftDown(a, 0, n)
+
+  proc lastAtOrBelow[T](a: NativeArray[T]; pc: uint): int =
+    ## The index of the last entry that starts at or below `pc`, or -1.
+    var lo = 0
+    var hi = a.len
+    while lo < hi:
+      let m = (lo + hi) div 2
+      let start = when T is NativeFunc: a.data[m].start else: a.data[m].address
+      if start <= pc: lo = m + 1
+      else: hi = m
+    result = lo - 1
+
+  proc readSymbols(f: CFilePtr; sections: seq[ElfSection]; symtab: int) =
+    let sh = sections[symtab]
+    if sh.entsize != uint64(sizeof(ElfSym)) or int(sh.link) >= sections.len: return
+    let syms = readSection(f, sh)
+    let strs = readSection(f, sections[sh.link])
+    if syms.data != nil and strs.data != nil:
+      for i in 0..<syms.size div sizeof(ElfSym):
+        let sym = cast[ptr ElfSym](addr syms.data[i * sizeof(ElfSym)])
+        if (sym.info and 0xf) == SttFunc and sym.size != 0:
+          let name = strs.at(sym.name)
+          if name != nil:
+            nativeFuncs.add NativeFunc(start: uint(sym.value),
+                                       size: uint(sym.size), name: name)
+    free syms
+    # the names of the functions point into it
+    if nativeFuncs.len == 0: free strs
+
+  # ---------------------- DWARF line tables --------------------------------
+
+  type
+    DwarfReader = object
+      data: ptr UncheckedArray[uint8]
+      pos, limit: int
+
+    LineFile = object
+      name: cstring
+      dir: int
+
+  proc u8(r: var DwarfReader): uint64 =
+    if r.pos < r.limit:
+      result = r.data[r.pos]
+      inc r.pos
+    else:
+      result = 0
+
+  proc fixed(r: var DwarfReader; size: int): uint64 =
+    result = 0
+    for i in 0..<size: result = result or (r.u8 shl (8 * i))
+
+  proc uleb(r: var DwarfReader): uint64 =
+    result = 0
+    var shift = 0
+    while true:
+      let b = r.u8
+      if shift < 64: result = result or ((b and 0x7f) shl shift)
+      shift += 7
+      if (b and 0x80) == 0 or r.pos >= r.limit: break
+
+  proc sleb(r: var DwarfReader): int64 =
+    var x = 0'u64
+    var shift = 0
+    var b = 0'u64
+    while true:
+      b = r.u8
+      if shift < 64: x = x or ((b and 0x7f) shl shift)
+      shift += 7
+      if (b and 0x80) == 0 or r.pos >= r.limit: break
+    if shift < 64 and (b and 0x40) != 0: x = x or (not 0'u64 shl shift)
+    result = cast[int64](x)
+
+  proc str(r: var DwarfReader): cstring =
+    if r.pos >= r.limit: return nil
+    result = cast[cstring](addr r.data[r.pos])
+    while r.pos < r.limit and r.data[r.pos] != 0: inc r.pos
+    inc r.pos
+
+  proc readEntries(r: var DwarfReader; offsetSize: int;
+                   lineStr, debugStr: Section; entries: var seq[LineFile]): bool =
+    ## Reads the directory or file entries of a version 5 line table.
+    var formats: array[16, (uint64, uint64)]
+    let formatCount = int(r.u8)
+    if formatCount > formats.len: return false
+    for i in 0..<formatCount: formats[i] = (r.uleb, r.uleb)
+    let count = int(r.uleb)
+    for i in 0..<count:
+      if r.pos >= r.limit: return false
+      var e = LineFile()
+      for j in 0..<formatCount:
+        let (content, form) = formats[j]
+        var s: cstring = nil
+        var n = 0'u64
+        case int(form)
+        of 0x08: s = r.str                                # DW_FORM_string
+        of 0x1f: s = lineStr.at(r.fixed(offsetSize))      # DW_FORM_line_strp
+        of 0x0e: s = debugStr.at(r.fixed(offsetSize))     # DW_FORM_strp
+        of 0x0b: n = r.fixed(1)                           # DW_FORM_data1
+        of 0x05: n = r.fixed(2)                           # DW_FORM_data2
+        of 0x06: n = r.fixed(4)                           # DW_FORM_data4
+        of 0x07: n = r.fixed(8)                           # DW_FORM_data8
+        of 0x1e: r.pos += 16                              # DW_FORM_data16
+        of 0x0f: n = r.uleb                               # DW_FORM_udata
+        of 0x09: r.pos += int(r.uleb)                     # DW_FORM_block
+        else: return false
+        if content == 1: e.name = s                       # DW_LNCT_path
+        elif content == 2: e.dir = int(n)                 # DW_LNCT_directory_index
+      entries.add e
+    result = r.pos <= r.limit
+
+  proc endsWith(s: cstring; suffix: string): bool =
+    let n = s.len
+    result = n >= suffix.len and
+      equalMem(cast[pointer](cast[uint](s) + uint(n - suffix.len)),
+               unsafeAddr suffix[0], suffix.len)
+
+  proc nimFile(files, dirs: seq[LineFile]; file: int): int32 =
+    ## Adds the path of `file` to `nativeFiles` if it is a Nim file and
+    ## returns its index there, or -1.
+    result = -1
+    if file < 0 or file >= files.len or files[file].name == nil: return
+    let name = files[file].name
+    if not name.endsWith(".nim"): return
+    let dir = files[file].dir
+    let prefix = if name[0] != '/' and dir >= 0 and dir < dirs.len and
+                     dirs[dir].name != nil: dirs[dir].name
+                 else: cstring("")
+    let n = prefix.len + ord(prefix.len > 0) + name.len
+    let p = cast[cstring](c_malloc(csize_t(n + 1)))
+    if p == nil: return
+    var i = 0
+    if prefix.len > 0:
+      copyMem(cast[pointer](p), cast[pointer](prefix), prefix.len)
+      p[prefix.len] = '/'
+      i = prefix.len + 1
+    copyMem(addr p[i], cast[pointer](name), name.len + 1)
+    result = int32(nativeFiles.len)
+    nativeFiles.add p
+
+  proc readLines(lines, lineStr, debugStr: Section) =
+    var r = DwarfReader(data: lines.data, pos: 0, limit: lines.size)
+    while r.pos < r.limit:
+      var offsetSize = 4
+      var unitLength = r.fixed(4)
+      if unitLength == 0xffff_ffff'u64:
+        offsetSize = 8
+        unitLength = r.fixed(8)
+      if unitLength == 0 or unitLength > uint64(r.limit - r.pos): break
+      let unitEnd = r.pos + int(unitLength)
+      let version = int(r.fixed(2))
+      if version < 2 or version > 5:
+        r.pos = unitEnd
+        continue
+      var addressSize = sizeof(pointer)
+      if version >= 5:
+        addressSize = int(r.u8)
+        discard r.u8 # segment selector size
+      let headerLength = r.fixed(offsetSize)
+      let programStart = r.pos + int(headerLength)
+      let minInstLength = r.u8
+      if version >= 4: discard r.u8 # maximum operations per instruction
+      discard r.u8 # default_is_stmt
+      let lineBase = int64(cast[int8](r.u8))
+      let lineRange = r.u8
+      let opcodeBase = r.u8
+      var opcodeLengths: array[256, uint8]
+      for i in 1'u64..<opcodeBase: opcodeLengths[i] = uint8(r.u8)
+      var dirs, files: seq[LineFile] = @[]
+      if version >= 5:
+        if not readEntries(r, offsetSize, lineStr, debugStr, dirs) or
+            not readEntries(r, offsetSize, lineStr, debugStr, files):
+          r.pos = unitEnd
+          continue
+      else:
+        # index 0 is the compilation directory, respectively unused
+        dirs.add LineFile()
+        files.add LineFile()
+        while r.pos < unitEnd and r.data[r.pos] != 0: dirs.add LineFile(name: r.str)
+        inc r.pos
+        while r.pos < unitEnd and r.data[r.pos] != 0:
+          var e = LineFile(name: r.str)
+          e.dir = int(r.uleb)
+          discard r.uleb # modification time
+          discard r.uleb # length
+          files.add e
+      if lineRange == 0 or programStart > unitEnd:
+        r.pos = unitEnd
+        continue
+
+      # the indexes of the unit's files in `nativeFiles`, added when first
+      # used; -2: not looked at yet
+      var fileIds = newSeq[int32](files.len)
+      for i in 0..<fileIds.len: fileIds[i] = -2
+
+      r.pos = programStart
+      r.limit = unitEnd
+      var
+        address = 0'u64
+        file = 1'u64
+        line = 1'i64
+        lastFile = -1'i32
+        lastLine = -1'i32
+        hasLast = false
+      template row() =
+        var id = -1'i32
+        if file < uint64(files.len):
+          let k = int(file)
+          if fileIds[k] == -2: fileIds[k] = nimFile(files, dirs, k)
+          id = fileIds[k]
+        let l = int32(clamp(line, 0'i64, int64(high(int32))))
+        # consecutive rows of the same line are one row
+        if not hasLast or id != lastFile or l != lastLine:
+          nativeRows.add NativeRow(address: uint(address), file: id, line: l)
+          lastFile = id
+          lastLine = l
+          hasLast = true
+
+      while r.pos < r.limit:
+        let op = r.u8
+        if op >= opcodeBase:
+          let adjusted = op - opcodeBase
+          address += (adjusted div lineRange) * minInstLength
+          line += lineBase + int64(adjusted mod lineRange)
+          row()
+        elif op == 0: # extended opcodes
+          let length = int(r.uleb)
+          let next = r.pos + length
+          case int(r.u8)
+          of 1: # DW_LNE_end_sequence
+            nativeRows.add NativeRow(address: uint(address), file: -1, line: 0)
+            hasLast = false
+            address = 0
+            file = 1
+            line = 1
+          of 2: # DW_LNE_set_address
+            address = r.fixed(length - 1)
+          else: discard
+          r.pos = next
+        else:
+          case int(op)
+          of 1: row()                                      # DW_LNS_copy
+          of 2: address += r.uleb * minInstLength          # DW_LNS_advance_pc
+          of 3: line += r.sleb                             # DW_LNS_advance_line
+          of 4: file = r.uleb                              # DW_LNS_set_file
+          of 5, 12: discard r.uleb                         # set_column, set_isa
+          of 6, 7, 10, 11: discard
+          of 8: # DW_LNS_const_add_pc
+            address += ((255 - opcodeBase) div lineRange) * minInstLength
+          of 9: address += r.fixed(2)                      # DW_LNS_fixed_advance_pc
+          else:
+            for i in 0'u8..<opcodeLengths[op]: discard r.uleb
+      r.limit = lines.size
+      r.pos = unitEnd
+
+  proc buildNativeTables() =
+    ## Reads the function symbols and the line table of the executable.
+    discard dl_iterate_phdr(mainProgramBias, addr nativeBias)
+    let f = c_fopen("/proc/self/exe", "rb")
+    if f == nil: return
+    var h: ElfHeader
+    if readAt(f, 0, addr h, sizeof(h)) and h.ident[0] == 0x7f and
+        h.ident[1] == uint8('E') and h.ident[4] == 2 and # 64 bit
+        int(h.shentsize) == sizeof(ElfSection) and h.shnum > 0'u16:
+      var sections = newSeq[ElfSection](int(h.shnum))
+      if readAt(f, h.shoff, addr sections[0], sections.len * sizeof(ElfSection)) and
+          int(h.shstrndx) < sections.len:
+        let names = readSection(f, sections[h.shstrndx])
+        var symtab, dynsym, lines, lineStr, debugStr = -1
+        for i in 0..<sections.len:
+          let name = names.at(sections[i].name)
+          if sections[i].kind == ShtSymtab: symtab = i
+          elif sections[i].kind == ShtDynsym: dynsym = i
+          elif name == nil: discard
+          elif c_strcmp(name, ".debug_line") == 0: lines = i
+          elif c_strcmp(name, ".debug_line_str") == 0: lineStr = i
+          elif c_strcmp(name, ".debug_str") == 0: debugStr = i
+        free names
+        # stripped executables only have the exported symbols
+        if symtab < 0: symtab = dynsym
+        if symtab >= 0: readSymbols(f, sections, symtab)
+        if lines >= 0:
+          let ls = readSection(f, sections[lines])
+          let lss = if lineStr >= 0: readSection(f, sections[lineStr]) else: Section()
+          let ds = if debugStr >= 0: readSection(f, sections[debugStr]) else: Section()
+          if ls.data != nil: readLines(ls, lss, ds)
+          free ls
+          free lss
+          free ds
+    discard c_fclose(f)
+    sort nativeFuncs
+    sort nativeRows
+
+when defined(posix):
+  type
+    DlInfo {.importc: "Dl_info", header: "<dlfcn.h>", final, pure.} = object
+      dli_fname: cstring
+      dli_fbase: pointer
+      dli_sname: cstring
+      dli_saddr: pointer
+
+  proc dladdr(address: pointer; info: ptr DlInfo): cint {.
+    importc: "dladdr", header: "<dlfcn.h>".}
+
+proc nativeSymbolize(frames: var seq[NativeFrame]) =
+  ## Called with `nativeLock` held.
+  when defined(linux):
+    if not nativeTablesBuilt:
+      buildNativeTables()
+      nativeTablesBuilt = true
+  for fr in mitems(frames):
+    when defined(linux):
+      let pc = fr.pc - nativeBias
+      let i = lastAtOrBelow(nativeFuncs, pc)
+      if i >= 0 and pc < nativeFuncs.data[i].start + nativeFuncs.data[i].size:
+        fr.sym = $nativeFuncs.data[i].name
+      let j = lastAtOrBelow(nativeRows, pc)
+      if j >= 0 and nativeRows.data[j].file >= 0:
+        fr.file = $nativeFiles.data[nativeRows.data[j].file]
+        fr.line = nativeRows.data[j].line
+    when defined(posix):
+      if fr.sym.len == 0:
+        # not in the executable, or no symbol table
+        var info: DlInfo
+        if dladdr(cast[pointer](fr.pc), addr info) != 0 and info.dli_sname != nil:
+          fr.sym = $info.dli_sname
+
+proc endsWith(s, suffix: string): bool =
+  result = s.len >= suffix.len and
+    equalMem(unsafeAddr s[s.len - suffix.len], unsafeAddr suffix[0], suffix.len)
+
+proc baseName(path: string): string =
+  var i = path.len
+  while i > 0 and path[i - 1] != '/': dec i
+  result = path.substr(i)
+
+proc nativeProcName(sym, file: string; module: var string): string =
+  ## The Nim name of the C function `sym`, see `mangleProcNameExt` and
+  ## `mangleProc` in the compiler. `module` is set to the name of its module
+  ## if that is known, from `file` or else from `sym`.
+  module = baseName(file)
+  if module.endsWith(".nim"): module.setLen(module.len - 4)
+  if sym == "NimMainModule" or sym.endsWith("Init000"):
+    # the top level statements of a module
+    result = module
+  elif sym.len > 3 and sym[0] == '_' and sym[1] == 'Z' and sym[2] == 'N':
+    # _ZN<len><module><len><name>E<params> with --debugger:native
+    var i = 3
+    result = ""
+    for part in 0..1:
+      var n = 0
+      while i < sym.len and sym[i] in {'0'..'9'}:
+        n = n * 10 + ord(sym[i]) - ord('0')
+        inc i
+      result = sym.substr(i, i + n - 1)
+      if part == 0 and module.len == 0: module = result
+      i += n
+  else:
+    # <name>__<module>_u<id>
+    result = sym
+    var i = sym.len - 1
+    while i > 0 and sym[i] in {'0'..'9'}: dec i
+    if i > 1 and i < sym.len - 1 and sym[i] == 'u' and sym[i - 1] == '_':
+      var j = i - 2
+      while j > 0 and not (sym[j] == '_' and sym[j - 1] == '_'): dec j
+      if j > 0:
+        result = sym.substr(0, j - 2)
+        if module.len == 0:
+          # the last part of the path, see `uniqueModuleName` in the compiler
+          var k = i - 2
+          while k > j + 1 and sym[k - 1] != 'Z': dec k
+          module = sym.substr(k, i - 2)
+          for c in mitems(module):
+            if c == 'O': c = '.'
+  if result.len == 0: result = "???"
+
+type
+  NativeString = object
+    next: ptr NativeString
+    s: cstring
+
+var
+  nativeStrings: ptr NativeString # never freed, stack trace entries point to them
+  nativeLock: int
+
+proc intern(s: string): cstring =
+  var it = nativeStrings
+  while it != nil:
+    if c_strcmp(it.s, cstring(s)) == 0: return it.s
+    it = it.next
+  let n = cast[ptr NativeString](c_malloc(csize_t(sizeof(NativeString) + s.len + 1)))
+  if n == nil: return "???"
+  n.s = cast[cstring](cast[uint](n) + uint(sizeof(NativeString)))
+  copyMem(n.s, cstring(s), s.len + 1)
+  n.next = nativeStrings
+  nativeStrings = n
+  result = n.s
+
+
+template withNativeLock(body: untyped) =
+  {.gcsafe.}:
+    when compileOption("threads"):
+      while not cas(addr nativeLock, 0, 1): cpuRelax()
+    body
+    when compileOption("threads"):
+      atomicStoreN(addr nativeLock, 0, ATOMIC_RELEASE)
+
+proc nimNativeSymbolize(pc: uint; procname, filename: var cstring;
+                        line: var int): bool {.compilerproc.} =
+  ## Resolves the code address `pc`: `procname` is `module.proc` for Nim
+  ## code and the C function otherwise, `filename` and `line` are set where
+  ## the line table covers `pc`. The strings are never freed. Returns false
+  ## if nothing is known about `pc`.
+  var frames = @[NativeFrame(pc: pc)]
+  withNativeLock:
+    nativeSymbolize(frames)
+    let fr = frames[0]
+    result = fr.sym.len > 0
+    if result:
+      var module = ""
+      let name = nativeProcName(fr.sym, fr.file, module)
+      procname = intern(if module.len > 0 and module != name: module & "." & name
+                        else: name)
+      filename = if fr.file.len > 0: intern(fr.file) else: nil
+      line = fr.line
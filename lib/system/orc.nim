@@ -518,7 +518,10 @@ proc nimDecRefIsLastCyclicDyn(p: pointer): bool {.compilerRtl, inl.} =
     else:
       dec cell.rc, rcIncrement
     #if cell.color == colPurple:
-    rememberCycle(result, cell, cast[ptr PNimTypeV2](p)[])
+    let desc = cast[ptr PNimTypeV2](p)[]
+    # the check of the acyclic flag is inlined, most objects never need the call
+    if result or markedAsCyclic(cell, desc):
+      rememberCycle(result, cell, desc)
 
 proc nimDecRefIsLastDyn(p: pointer): bool {.compilerRtl, inl.} =
   result = false
@@ -544,4 +547,5 @@ proc nimDecRefIsLastCyclicStatic(p: pointer; desc: PNimTypeV2): bool {.compilerR
     else:
       dec cell.rc, rcIncrement
     #if cell.color == colPurple:
-    rememberCycle(result, cell, desc)
+    if result or markedAsCyclic(cell, desc):
+      rememberCycle(result, cell, desc)
@@ -138,20 +138,107 @@ elif defined(posix) and not defined(StandaloneHeapSize):
 
   proc munmap(adr: pointer, len: csize_t): cint {.header: "<sys/mman.h>".}
 
-  proc osAllocPages(size: int): pointer {.inline.} =
-    result = mmap(nil, cast[csize_t](size), PROT_READ or PROT_WRITE,
-                             MAP_ANONYMOUS or MAP_PRIVATE or MAP_STACK, -1, 0)
-    if result == nil or result == cast[pointer](-1):
-      raiseOutOfMem()
+  when defined(nimHugePages) and defined(linux):
+    # Regions of at least `HugePageSize` bytes are aligned to it, so that the
+    # kernel can back them with transparent huge pages. The environment
+    # variable `NIM_HUGEPAGES` selects how: `thp` (the default) uses
+    # `madvise(MADV_HUGEPAGE)`, `hugetlb` tries the reserved huge page pool
+    # first and `off` disables huge pages.
+    const HugePageSize = 2 * 1024 * 1024
 
-  proc osTryAllocPages(size: int): pointer {.inline.} =
-    result = mmap(nil, cast[csize_t](size), PROT_READ or PROT_WRITE,
-                             MAP_ANONYMOUS or MAP_PRIVATE or MAP_STACK, -1, 0)
-    if result == cast[pointer](-1): result = nil
+    var
+      MAP_HUGETLB {.importc: "MAP_HUGETLB", header: "<sys/mman.h>".}: cint
+      MADV_HUGEPAGE {.importc: "MADV_HUGEPAGE", header: "<sys/mman.h>".}: cint
+
+    proc madvise(adr: pointer, len: csize_t, advice: cint): cint {.
+      header: "<sys/mman.h>".}
+    proc c_getenv(name: cstring): cstring {.importc: "getenv", header: "<stdlib.h>".}
+
+    type HugePagesMode = enum
+      hpUnknown, hpOff, hpThp, hpHugetlb
+
+    var hugePagesMode: HugePagesMode # read once; a race only reads it twice
+
+    proc hugePages(): HugePagesMode =
+      if hugePagesMode == hpUnknown:
+        let v = c_getenv("NIM_HUGEPAGES")
+        hugePagesMode =
+          if v == nil: hpThp
+          elif c_strcmp(v, "off") == 0 or c_strcmp(v, "0") == 0: hpOff
+          elif c_strcmp(v, "hugetlb") == 0: hpHugetlb
+          else: hpThp
+      result = hugePagesMode
+
+    proc osHugePagesEnabled(): bool {.inline.} = hugePages() != hpOff
+
+    proc osHugePageBytes(p: pointer; size: int): int {.inline.} =
+      ## The part of the region of `size` bytes at `p` that can be backed by
+      ## huge pages: the aligned huge pages that lie within it. A region that
+      ## `osTryReallocPages` moved can lose its alignment.
+      if size >= HugePageSize and osHugePagesEnabled():
+        let first = roundup(cast[int](p), HugePageSize)
+        let last = (cast[int](p) +% size) and not (HugePageSize - 1)
+        result = max(0, last -% first)
+      else:
+        result = 0
+
+    proc mapPages(size: int; flags: cint): pointer {.inline.} =
+      result = mmap(nil, cast[csize_t](size), PROT_READ or PROT_WRITE,
+                               flags, -1, 0)
+      if result == cast[pointer](-1): result = nil
+
+    proc osTryAllocPages(size: int): pointer =
+      let flags = cint(MAP_ANONYMOUS or MAP_PRIVATE or MAP_STACK)
+      if size < HugePageSize or not osHugePagesEnabled():
+        return mapPages(size, flags)
+      if hugePages() == hpHugetlb and (size and (HugePageSize - 1)) == 0:
+        # `munmap` of a hugetlb mapping needs the size to be a multiple too
+        result = mapPages(size, flags or MAP_HUGETLB)
+        if result != nil: return
+      # map more than needed and unmap the parts before and after the
+      # aligned region
+      let base = mapPages(size + HugePageSize, flags)
+      if base == nil: return nil
+      let start = roundup(cast[int](base), HugePageSize)
+      let head = start -% cast[int](base)
+      if head > 0: discard munmap(base, cast[csize_t](head))
+      if HugePageSize - head > 0:
+        discard munmap(cast[pointer](start +% size), cast[csize_t](HugePageSize - head))
+      result = cast[pointer](start)
+      discard madvise(result, cast[csize_t](size), MADV_HUGEPAGE)
+
+    proc osAllocPages(size: int): pointer {.inline.} =
+      result = osTryAllocPages(size)
+      if result == nil: raiseOutOfMem()
+
+  else:
+    proc osAllocPages(size: int): pointer {.inline.} =
+      result = mmap(nil, cast[csize_t](size), PROT_READ or PROT_WRITE,
+                               MAP_ANONYMOUS or MAP_PRIVATE or MAP_STACK, -1, 0)
+      if result == nil or result == cast[pointer](-1):
+        raiseOutOfMem()
+
+    proc osTryAllocPages(size: int): pointer {.inline.} =
+      result = mmap(nil, cast[csize_t](size), PROT_READ or PROT_WRITE,
+                               MAP_ANONYMOUS or MAP_PRIVATE or MAP_STACK, -1, 0)
+      if result == cast[pointer](-1): result = nil
 
   proc osDeallocPages(p: pointer, size: int) {.inline.} =
     when reallyOsDealloc: discard munmap(p, cast[csize_t](size))
 
+  when defined(linux):
+    const MREMAP_MAYMOVE = 1
+
+    proc mremap(adr: pointer, oldLen, newLen: csize_t, flags: cint): pointer {.
+      header: "<sys/mman.h>".}
+
+    proc osTryReallocPages(p: pointer, oldSize, newSize: int): pointer {.inline.} =
+      ## Resizes a region from `osAllocPages` by remapping its pages, which
+      ## may move it. Returns nil if that fails; `p` is still valid then.
+      result = mremap(p, cast[csize_t](oldSize), cast[csize_t](newSize),
+                      MREMAP_MAYMOVE)
+      if result == cast[pointer](-1): result = nil
+
 elif defined(windows) and not defined(StandaloneHeapSize):
   const
     MEM_RESERVE = 0x2000
@@ -38,11 +38,18 @@ const nimSeqVersion {.core.} = 2
 
 # XXX make code memory safe for overflows in '*'
 
+template sampledSeq(payload: pointer; size, elemAlign: int): pointer =
+  let q = payload
+  when declared(heapProfAlloc):
+    heapProfAlloc(heapProfBlock(q, elemAlign), size, "seq")
+  q
+
 proc newSeqPayload(cap, elemSize, elemAlign: int): pointer {.compilerRtl, raises: [].} =
   # we have to use type erasure here as Nim does not support generic
   # compilerProcs. Oh well, this will all be inlined anyway.
   if cap > 0:
-    var p = cast[ptr NimSeqPayloadBase](alignedAlloc0(align(sizeof(NimSeqPayloadBase), elemAlign) + cap * elemSize, elemAlign))
+    let size = align(sizeof(NimSeqPayloadBase), elemAlign) + cap * elemSize
+    var p = cast[ptr NimSeqPayloadBase](sampledSeq(alignedAlloc0(size, elemAlign), size, elemAlign))
     p.cap = cap
     result = p
   else:
@@ -51,7 +58,8 @@ proc newSeqPayload(cap, elemSize, elemAlign: int): pointer {.compilerRtl, raises
 proc newSeqPayloadUninit(cap, elemSize, elemAlign: int): pointer {.compilerRtl, raises: [].} =
   # Used in `newSeqOfCap()`.
   if cap > 0:
-    var p = cast[ptr NimSeqPayloadBase](alignedAlloc(align(sizeof(NimSeqPayloadBase), elemAlign) + cap * elemSize, elemAlign))
+    let size = align(sizeof(NimSeqPayloadBase), elemAlign) + cap * elemSize
+    var p = cast[ptr NimSeqPayloadBase](sampledSeq(alignedAlloc(size, elemAlign), size, elemAlign))
     p.cap = cap
     result = p
   else:
@@ -79,12 +87,13 @@ proc prepareSeqAdd(len: int; p: pointer; addlen, elemSize, elemAlign: int): poin
       let newCap = max(resize(oldCap), len+addlen)
       var q: ptr NimSeqPayloadBase
       if (p.cap and strlitFlag) == strlitFlag:
-        q = cast[ptr NimSeqPayloadBase](alignedAlloc(headerSize + elemSize * newCap, elemAlign))
+        let newSize = headerSize + elemSize * newCap
+        q = cast[ptr NimSeqPayloadBase](sampledSeq(alignedAlloc(newSize, elemAlign), newSize, elemAlign))
         copyMem(q +! headerSize, p +! headerSize, len * elemSize)
       else:
         let oldSize = headerSize + elemSize * oldCap
         let newSize = headerSize + elemSize * newCap
-        q = cast[ptr NimSeqPayloadBase](alignedRealloc(p, oldSize, newSize, elemAlign))
+        q = cast[ptr NimSeqPayloadBase](sampledSeq(alignedRealloc(p, oldSize, newSize, elemAlign), newSize, elemAlign))
 
       zeroMem(q +! headerSize +! len * elemSize, addlen * elemSize)
       q.cap = newCap
@@ -111,14 +120,15 @@ proc prepareSeqAddUninit(len: int; p: pointer; addlen, elemSize, elemAlign: int)
       let oldCap = p.cap and not strlitFlag
       let newCap = max(resize(oldCap), len+addlen)
       if (p.cap and strlitFlag) == strlitFlag:
-        var q = cast[ptr NimSeqPayloadBase](alignedAlloc(headerSize + elemSize * newCap, elemAlign))
+        let newSize = headerSize + elemSize * newCap
+        var q = cast[ptr NimSeqPayloadBase](sampledSeq(alignedAlloc(newSize, elemAlign), newSize, elemAlign))
         copyMem(q +! headerSize, p +! headerSize, len * elemSize)
         q.cap = newCap
         result = q
       else:
         let oldSize = headerSize + elemSize * oldCap
         let newSize = headerSize + elemSize * newCap
-        var q = cast[ptr NimSeqPayloadBase](alignedRealloc(p, oldSize, newSize, elemAlign))
+        var q = cast[ptr NimSeqPayloadBase](sampledSeq(alignedRealloc(p, oldSize, newSize, elemAlign), newSize, elemAlign))
         q.cap = newCap
         result = q
 
@@ -15,6 +15,8 @@ const
   reraisedFromEnd* = -100
   maxStackTraceLines* = 128
 
+include "system/nativesymbols"
+
 when defined(nimStackTraceOverride):
   ## Procedure types for overriding the default stack trace.
   type
@@ -81,3 +83,6 @@ when defined(nimStackTraceOverride):
         result.add(entry)
     if programCounters.len > 0:
       result.add(stackTraceOverrideGetDebuggingInfo(programCounters, maxStackTraceLines))
+
+elif defined(nimNativeStackTraces):
+  include "system/nativestacktraces"
@@ -8,6 +8,12 @@
 #
 
 ## Default new string implementation used by Nim's core.
+##
+## With `-d:nimSso` a string of up to `ssoLen` chars is stored inline: its
+## chars and their `\0` start at the `p` field and continue into `inl`, and
+## `sso` is set. Such a string needs no payload. A string with a `len` of 0
+## and a nil `p` is empty whether `sso` is set or not, so resetting these
+## two fields keeps the string valid.
 
 type
   NimStrPayloadBase = object
@@ -20,55 +26,94 @@ type
   NimStringV2 {.core.} = object
     len: int
     p: ptr NimStrPayload ## can be nil if len == 0.
+    when defined(nimSso):
+      inl: array[7, char] ## the chars of a short string that follow `p`
+      sso: bool ## the chars are stored inline
 
 const nimStrVersion {.core.} = 2
 
-template isLiteral(s): bool = (s.p == nil) or (s.p.cap and strlitFlag) == strlitFlag
+when defined(nimSso):
+  const ssoLen = sizeof(pointer) + 6 ## the chars a short string can hold
+
+template isShort(s): bool =
+  when defined(nimSso): s.sso else: false
+
+template strData(s): ptr UncheckedArray[char] =
+  ## the chars of `s`; not valid for a long string with a nil `p`
+  when defined(nimSso):
+    if s.sso: cast[ptr UncheckedArray[char]](unsafeAddr s.p)
+    else: cast[ptr UncheckedArray[char]](unsafeAddr s.p.data)
+  else:
+    cast[ptr UncheckedArray[char]](unsafeAddr s.p.data)
+
+template setPayload(s, payload) =
+  s.p = payload
+  when defined(nimSso): s.sso = false
+
+template isLiteral(s): bool =
+  not isShort(s) and ((s.p == nil) or (s.p.cap and strlitFlag) == strlitFlag)
 
 template contentSize(cap): int = cap + 1 + sizeof(NimStrPayloadBase)
 
 template frees(s) =
-  if not isLiteral(s):
+  if not isShort(s) and not isLiteral(s):
     when compileOption("threads"):
       deallocShared(s.p)
     else:
       dealloc(s.p)
 
+template sampledStr(payload: pointer; newLen: int): ptr NimStrPayload =
+  let q = payload
+  when declared(heapProfAlloc):
+    heapProfAlloc(q, contentSize(newLen), "string")
+  cast[ptr NimStrPayload](q)
+
 template allocPayload(newLen: int): ptr NimStrPayload =
-  when compileOption("threads"):
-    cast[ptr NimStrPayload](allocShared(contentSize(newLen)))
-  else:
-    cast[ptr NimStrPayload](alloc(contentSize(newLen)))
+  sampledStr(payloadAlloc(contentSize(newLen)), newLen)
 
 template allocPayload0(newLen: int): ptr NimStrPayload =
-  when compileOption("threads"):
-    cast[ptr NimStrPayload](allocShared0(contentSize(newLen)))
-  else:
-    cast[ptr NimStrPayload](alloc0(contentSize(newLen)))
+  sampledStr(payloadAlloc0(contentSize(newLen)), newLen)
 
 template reallocPayload(p: pointer, newLen: int): ptr NimStrPayload =
-  when compileOption("threads"):
-    cast[ptr NimStrPayload](reallocShared(p, contentSize(newLen)))
-  else:
-    cast[ptr NimStrPayload](realloc(p, contentSize(newLen)))
+  sampledStr(payloadRealloc(p, contentSize(newLen)), newLen)
 
 template reallocPayload0(p: pointer; oldLen, newLen: int): ptr NimStrPayload =
-  when compileOption("threads"):
-    cast[ptr NimStrPayload](reallocShared0(p, contentSize(oldLen), contentSize(newLen)))
-  else:
-    cast[ptr NimStrPayload](realloc0(p, contentSize(oldLen), contentSize(newLen)))
+  sampledStr(payloadRealloc0(p, contentSize(oldLen), contentSize(newLen)), newLen)
 
 proc resize(old: int): int {.inline.} =
   if old <= 0: result = 4
   elif old <= high(int16): result = old * 2
   else: result = old div 2 + old # for large arrays * 3/2 is better
 
+when defined(nimSso):
+  proc toShort(s: var NimStringV2; src: pointer; len: int) {.inline.} =
+    ## Stores `len` chars from `src`, which must not be part of `s`, and a
+    ## `\0` inline. Does not free the payload of `s`.
+    s.sso = true
+    if len > 0: copyMem(strData(s), src, len)
+    strData(s)[len] = '\0'
+
+  proc toLong(s: var NimStringV2; newCap: int) =
+    ## Moves the chars of the short string `s` into a payload of `newCap`.
+    let p = allocPayload(newCap)
+    p.cap = newCap
+    copyMem(unsafeAddr p.data[0], strData(s), s.len+1)
+    setPayload(s, p)
+
 proc prepareAdd(s: var NimStringV2; addLen: int) {.compilerRtl.} =
   let newLen = s.len + addLen
+  when defined(nimSso):
+    if s.sso:
+      if newLen > ssoLen: toLong(s, max(newLen, resize(ssoLen)))
+      return
+    elif isLiteral(s) and newLen <= ssoLen:
+      # a short copy of the literal needs no payload:
+      toShort(s, (if s.len > 0: unsafeAddr s.p.data[0] else: nil), s.len)
+      return
   if isLiteral(s):
     let oldP = s.p
     # can't mutate a literal, so we need a fresh copy here:
-    s.p = allocPayload(newLen)
+    setPayload(s, allocPayload(newLen))
     s.p.cap = newLen
     if s.len > 0:
       # we are about to append, so there is no need to copy the \0 terminator:
@@ -89,14 +134,20 @@ proc prepareAdd(s: var NimStringV2; addLen: int) {.compilerRtl.} =
 proc nimAddCharV1(s: var NimStringV2; c: char) {.compilerRtl, inl.} =
   #if (s.p == nil) or (s.len+1 > s.p.cap and not strlitFlag):
   prepareAdd(s, 1)
-  s.p.data[s.len] = c
+  let d = strData(s)
+  d[s.len] = c
   inc s.len
-  s.p.data[s.len] = '\0'
+  d[s.len] = '\0'
 
 proc toNimStr(str: cstring, len: int): NimStringV2 {.compilerproc.} =
   if len <= 0:
     result = NimStringV2(len: 0, p: nil)
   else:
+    when defined(nimSso):
+      if len <= ssoLen:
+        result = NimStringV2(len: len, p: nil)
+        toShort(result, str, len)
+        return
     var p = allocPayload(len)
     p.cap = len
     copyMem(unsafeAddr p.data[0], str, len+1)
@@ -107,26 +158,35 @@ proc cstrToNimstr(str: cstring): NimStringV2 {.compilerRtl.} =
   else: toNimStr(str, str.len)
 
 proc nimToCStringConv(s: NimStringV2): cstring {.compilerproc, nonReloadable, inline.} =
+  # with -d:nimSso the code generator takes the chars of a short string
+  # itself, `s` is a copy
   if s.len == 0: result = cstring""
   else: result = cast[cstring](unsafeAddr s.p.data)
 
 proc appendString(dest: var NimStringV2; src: NimStringV2) {.compilerproc, inline.} =
   if src.len > 0:
+    let d = strData(dest)
     # don't copy the \0 terminator:
-    copyMem(unsafeAddr dest.p.data[dest.len], unsafeAddr src.p.data[0], src.len)
+    copyMem(addr d[dest.len], strData(src), src.len)
     inc dest.len, src.len
-    dest.p.data[dest.len] = '\0'
+    d[dest.len] = '\0'
 
 proc appendChar(dest: var NimStringV2; c: char) {.compilerproc, inline.} =
-  dest.p.data[dest.len] = c
+  let d = strData(dest)
+  d[dest.len] = c
   inc dest.len
-  dest.p.data[dest.len] = '\0'
+  d[dest.len] = '\0'
 
 proc rawNewString(space: int): NimStringV2 {.compilerproc.} =
   # this is also 'system.newStringOfCap'.
   if space <= 0:
     result = NimStringV2(len: 0, p: nil)
   else:
+    when defined(nimSso):
+      if space <= ssoLen:
+        result = NimStringV2(len: 0, p: nil)
+        toShort(result, nil, 0)
+        return
     var p = allocPayload(space)
     p.cap = space
     p.data[0] = '\0'
@@ -136,17 +196,37 @@ proc mnewString(len: int): NimStringV2 {.compilerproc.} =
   if len <= 0:
     result = NimStringV2(len: 0, p: nil)
   else:
+    when defined(nimSso):
+      if len <= ssoLen:
+        # zeroes the chars and the \0:
+        result = NimStringV2(len: len, p: nil, sso: true)
+        return
     var p = allocPayload0(len)
     p.cap = len
     result = NimStringV2(len: len, p: p)
 
 proc setLengthStrV2(s: var NimStringV2, newLen: int) {.compilerRtl.} =
+  when defined(nimSso):
+    if newLen > 0 and (s.sso or isLiteral(s) and newLen <= ssoLen):
+      let oldLen = s.len
+      if s.sso:
+        if newLen > ssoLen: toLong(s, newLen)
+      else:
+        toShort(s, (if oldLen > 0: unsafeAddr s.p.data[0] else: nil),
+                min(oldLen, newLen))
+      let d = strData(s)
+      if newLen > oldLen:
+        zeroMem(addr d[oldLen], newLen - oldLen + 1)
+      else:
+        d[newLen] = '\0'
+      s.len = newLen
+      return
   if newLen == 0:
     discard "do not free the buffer here, pattern 's.setLen 0' is common for avoiding allocations"
   else:
     if isLiteral(s):
       let oldP = s.p
-      s.p = allocPayload(newLen)
+      setPayload(s, allocPayload(newLen))
       s.p.cap = newLen
       if s.len > 0:
         copyMem(unsafeAddr s.p.data[0], unsafeAddr oldP.data[0], min(s.len, newLen))
@@ -167,32 +247,46 @@ proc setLengthStrV2(s: var NimStringV2, newLen: int) {.compilerRtl.} =
   s.len = newLen
 
 proc nimAsgnStrV2(a: var NimStringV2, b: NimStringV2) {.compilerRtl.} =
-  if a.p == b.p and a.len == b.len: return
+  if a.p == b.p and a.len == b.len and not isShort(a) and not isShort(b): return
+  when defined(nimSso):
+    if b.sso:
+      frees(a)
+      a = b
+      return
+    elif a.sso and b.len <= ssoLen:
+      a.len = b.len
+      if b.len > 0: copyMem(strData(a), strData(b), b.len)
+      strData(a)[b.len] = '\0'
+      return
   if isLiteral(b):
     # we can shallow copy literals:
     frees(a)
     a.len = b.len
-    a.p = b.p
+    setPayload(a, b.p)
   else:
-    if isLiteral(a) or (a.p.cap and not strlitFlag) < b.len:
+    if isShort(a) or isLiteral(a) or (a.p.cap and not strlitFlag) < b.len:
       # we have to allocate the 'cap' here, consider
       # 'let y = newStringOfCap(); var x = y'
       # on the other hand... These get turned into moves now.
       frees(a)
-      a.p = allocPayload(b.len)
+      setPayload(a, allocPayload(b.len))
       a.p.cap = b.len
     a.len = b.len
     copyMem(unsafeAddr a.p.data[0], unsafeAddr b.p.data[0], b.len+1)
 
 proc nimPrepareStrMutationImpl(s: var NimStringV2) =
   let oldP = s.p
+  when defined(nimSso):
+    if s.len <= ssoLen:
+      toShort(s, unsafeAddr oldP.data[0], s.len)
+      return
   # can't mutate a literal, so we need a fresh copy here:
-  s.p = allocPayload(s.len)
+  setPayload(s, allocPayload(s.len))
   s.p.cap = s.len
   copyMem(unsafeAddr s.p.data[0], unsafeAddr oldP.data[0], s.len+1)
 
 proc nimPrepareStrMutationV2(s: var NimStringV2) {.compilerRtl, inl.} =
-  if s.p != nil and (s.p.cap and strlitFlag) == strlitFlag:
+  if not isShort(s) and s.p != nil and (s.p.cap and strlitFlag) == strlitFlag:
     nimPrepareStrMutationImpl(s)
 
 proc prepareMutation*(s: var string) {.inline.} =
@@ -222,4 +316,6 @@ func capacity*(self: string): int {.inline.} =
     assert str.capacity == 42
 
   let str = cast[ptr NimStringV2](unsafeAddr self)
+  when defined(nimSso):
+    if str.sso: return ssoLen
   result = if str.p != nil: str.p.cap and not strlitFlag else: 0
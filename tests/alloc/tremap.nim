@@ -0,0 +1,50 @@
+discard """
+  matrix: "--mm:orc; --mm:arc; --mm:orc -d:nimHugePages"
+"""
+
+# growing a buffer past a few MB: on Linux its pages are remapped rather than
+# copied, the contents have to survive either way
+
+proc checkHugeMem() =
+  # remapped pages can lose their huge page alignment; the accounting must
+  # follow them
+  when defined(nimHugePages):
+    doAssert getHugePageMem() >= 0 and getHugePageMem() <= getTotalMem(),
+      $(getHugePageMem(), getTotalMem())
+
+proc main =
+  const
+    step = 3 * 1024 * 1024 + 123 # not a multiple of the page size
+    target = 256 * 1024 * 1024
+  var s: seq[byte] = @[]
+  var i = 0
+  while s.len < target:
+    let old = s.len
+    s.setLen(old + step)
+    for j in old..<s.len:
+      s[j] = byte(j mod 251)
+    inc i
+  for j in countup(0, s.len - 1, 4099):
+    doAssert s[j] == byte(j mod 251), $j
+  doAssert s[^1] == byte((s.len - 1) mod 251)
+  let len = s.len
+  s.setLen(len div 2) # shrinking keeps the front
+  doAssert s[^1] == byte((len div 2 - 1) mod 251)
+  checkHugeMem()
+  s = @[]
+  doAssert getOccupiedMem() < 16 * 1024 * 1024, $getOccupiedMem()
+  checkHugeMem()
+
+  # blocks of that size that were allocated at once are freed as usual
+  for k in 0..<8:
+    var big = newSeq[byte](8 * 1024 * 1024)
+    big[^1] = 1
+  doAssert getOccupiedMem() < 16 * 1024 * 1024, $getOccupiedMem()
+
+  var str = ""
+  for k in 0..<5_000_000:
+    str.add char(ord('a') + k mod 26)
+  doAssert str.len == 5_000_000
+  doAssert str[4_999_999] == char(ord('a') + 4_999_999 mod 26)
+
+main()
@@ -0,0 +1,65 @@
+discard """
+  cmd: "nim c -r --mm:orc --hint:CyclicTypes:on $file"
+  nimout: '''
+Button.onClick (closure)
+Cell.next -> Cell
+'''
+  output: '''
+7
+destroyed 3
+collected 2
+1
+'''
+"""
+
+# `Expr`, `Lit` and `Add` are inheritable but no subtype can form a cycle,
+# the whole-program inference proves them acyclic; `Cell` and `Button`
+# stay cyclic
+
+type
+  Tracked = object
+    id: int
+
+  Expr = ref object of RootObj
+    t: Tracked
+  Lit = ref object of Expr
+    val: int
+  Add = ref object of Expr
+    a, b: Lit
+
+  Cell = ref object
+    next: Cell
+    t: Tracked
+
+  Button = ref object of RootObj
+    onClick: proc () {.closure.}
+
+var destroyed = 0
+
+proc `=destroy`(x: Tracked) =
+  inc destroyed
+
+proc eval(e: Expr): int =
+  if e of Lit: Lit(e).val
+  elif e of Add: eval(Add(e).a) + eval(Add(e).b)
+  else: 0
+
+proc main =
+  block:
+    let e = Add(a: Lit(val: 3), b: Lit(val: 4))
+    echo eval(e)
+  echo "destroyed ", destroyed
+
+  block:
+    var a = Cell()
+    a.next = Cell(next: a)
+  GC_fullCollect()
+  echo "collected ", destroyed - 3
+
+  var clicks = 0
+  let b = Button()
+  b.onClick = proc () = inc clicks
+  b.onClick()
+  echo clicks
+
+main()
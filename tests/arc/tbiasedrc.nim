@@ -0,0 +1,96 @@
+discard """
+  matrix: "--mm:atomicArc; --mm:atomicArc -d:nimNoBiasedRc; --mm:atomicArc -d:useMalloc"
+  output: '''
+handoff 1000
+shared 2000
+retired 3000
+concurrent 13000
+unique true false
+'''
+"""
+
+# objects released by threads other than the one that created them
+
+import std/typedthreads
+
+type
+  Tracked = object
+    id: int
+
+  Node = ref object
+    t: Tracked
+    next: Node
+
+var
+  destroyed: int
+  box: Node
+
+proc `=destroy`(x: Tracked) =
+  discard atomicInc(destroyed)
+
+proc build(n: int): Node =
+  for i in 0..<n:
+    result = Node(t: Tracked(id: i), next: result)
+
+proc drop() {.thread.} =
+  {.cast(gcsafe).}:
+    var list = move box
+    list = nil
+
+proc sum(list: Node): int {.thread.} =
+  var held = newSeq[Node](8)
+  var it = list
+  while it != nil:
+    held[it.t.id and 7] = it
+    result += it.t.id
+    it = it.next
+
+proc readShared() {.thread.} =
+  {.cast(gcsafe).}:
+    doAssert sum(box) == 999 * 1000 div 2
+
+proc produce() {.thread.} =
+  {.cast(gcsafe).}:
+    box = build(1000)
+
+proc dropAll(list: ptr seq[Node]) {.thread.} =
+  for x in mitems(list[]): x = nil
+
+proc main =
+  var t: Thread[void]
+
+  box = build(1000)
+  createThread(t, drop)
+  joinThread(t)
+  GC_fullCollect()
+  echo "handoff ", destroyed
+
+  box = build(1000)
+  var readers: array[4, Thread[void]]
+  for r in mitems(readers): createThread(r, readShared)
+  joinThreads(readers)
+  box = nil
+  echo "shared ", destroyed
+
+  createThread(t, produce)
+  joinThread(t)
+  box = nil
+  echo "retired ", destroyed
+
+  # the owner and another thread drop their last references at the same time
+  var objs = newSeq[Node](10000)
+  for i in 0..<objs.len: objs[i] = Node(t: Tracked(id: i))
+  var copies = objs
+  var d: Thread[ptr seq[Node]]
+  createThread(d, dropAll, addr copies)
+  for x in mitems(objs): x = nil
+  joinThread(d)
+  GC_fullCollect()
+  echo "concurrent ", destroyed
+
+  var a = Node()
+  let unique = isUniqueRef(a)
+  var s = @[a]
+  echo "unique ", unique, " ", isUniqueRef(a)
+
+main()
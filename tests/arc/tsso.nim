@@ -0,0 +1,93 @@
+discard """
+  targets: "c cpp"
+  matrix: "--mm:orc; --mm:orc -d:nimSso; --mm:arc -d:nimSso -d:useMalloc"
+  output: '''
+abc abcdefghijklmnopqrstuvwxyz
+abcx 4
+abcdefghijklmn 14
+abcdefghijklmno 15
+de 2
+abc
+xbc abc
+hello
+short
+a longer string that needs a payload
+0 0
+12
+ok
+'''
+"""
+
+# strings behave the same with and without inline storage for short strings
+
+proc main =
+  var s = "abc"
+  var t = "abcdefghijklmnopqrstuvwxyz"
+  echo s, " ", t
+
+  s.add 'x'
+  echo s, " ", s.len
+
+  var u = ""
+  for c in 'a'..'n': u.add c
+  echo u, " ", u.len
+  u.add 'o'
+  echo u, " ", u.len
+
+  var v = "abcde"
+  v = v[3..4]
+  echo v, " ", v.len
+
+  var w = newString(3)
+  w[0] = 'a'; w[1] = 'b'; w[2] = 'c'
+  echo w
+
+  var x = w
+  x[0] = 'x'
+  echo x, " ", w
+
+  let c: cstring = "hello"
+  let y = $c
+  echo y.cstring
+
+  var z = "short"
+  var moved = move z
+  echo moved
+  moved = "a longer string that needs a payload"
+  echo moved
+
+  var e = "xyz"
+  e.setLen 0
+  echo e.len, " ", z.len
+
+  var n = "12345"
+  n.setLen 2
+  doAssert n == "12"
+  n.setLen 4
+  doAssert n.len == 4 and n[2] == '\0'
+  n.setLen 2
+  echo n
+
+  var grow = "ab"
+  grow.setLen 40
+  doAssert grow[0] == 'a' and grow[39] == '\0'
+
+  proc sum(a: openArray[char]): int =
+    for ch in a: result += ord(ch) - ord('0')
+  doAssert sum("123") == 6
+  doAssert sum(toOpenArray("91234", 1, 2)) == 3
+
+  var m = "mutate"
+  prepareMutation(m)
+  let p = addr m[0]
+  p[] = 'M'
+  doAssert m == "Mutate"
+
+  var strs: seq[string] = @[]
+  for i in 0..<100: strs.add $i
+  doAssert strs[42] == "42"
+  doAssert newStringOfCap(4).capacity >= 4
+
+  echo "ok"
+
+main()
@@ -0,0 +1,67 @@
+discard """
+  action: compile
+  matrix: "--mm:arc; --mm:orc"
+"""
+
+#[
+Time per request of a handler that allocates refs, seqs and strings, with
+the heap and with an arena per request.
+
+nim r -d:danger --mm:orc tests/benchmarks/tarena.nim
+]#
+
+import std/[arenas, monotimes, strutils, tables, times]
+
+type
+  Header = ref object
+    name, value: string
+
+  Request = ref object
+    verb, path: string
+    headers: seq[Header]
+    params: Table[string, string]
+
+const raw = "GET /search?q=nim&lang=en&page=2 HTTP/1.1\n" &
+  "Host: nim-lang.org\nAccept: text/html\nAccept-Language: en\n" &
+  "Connection: keep-alive\nUser-Agent: bench"
+
+proc parse(raw: string): Request =
+  let lines = raw.splitLines
+  let first = lines[0].split(' ')
+  result = Request(verb: first[0], params: initTable[string, string]())
+  let target = first[1].split('?', 1)
+  result.path = target[0]
+  if target.len == 2:
+    for kv in target[1].split('&'):
+      let parts = kv.split('=', 1)
+      result.params[parts[0]] = parts[1]
+  for line in lines.toOpenArray(1, lines.high):
+    let parts = line.split(": ", 1)
+    result.headers.add Header(name: parts[0].toLowerAscii, value: parts[1])
+
+proc handle(raw: string): int =
+  let req = parse(raw)
+  var body = "<html><body>"
+  for k, v in req.params: body.add "<p>" & k & "=" & v & "</p>"
+  for h in req.headers: body.add "<p>" & h.name & "</p>"
+  body.add "</body></html>"
+  result = body.len
+
+template bench(name: string; body: untyped) =
+  block:
+    const n = 200_000
+    var res {.inject.} = 0
+    let t = getMonoTime()
+    for i in 0..<n:
+      body
+    let d = getMonoTime() - t
+    echo name, ": ", d.inNanoseconds div n, " ns/request (", res, ")"
+
+proc main =
+  bench("heap"):
+    res += handle(raw)
+  bench("arena"):
+    withArena:
+      res += handle(raw)
+
+main()
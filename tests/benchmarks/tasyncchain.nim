@@ -0,0 +1,56 @@
+discard """
+  action: compile
+  matrix: "-d:nimAllocStats --mm:orc; -d:nimAllocStats --mm:arc"
+"""
+
+#[
+Time and allocations per await of chains of async procs, each awaiting the
+next one, where the innermost waits for a future completed by the event
+loop so that every level suspends once.
+
+nim r -d:danger -d:nimAllocStats tests/benchmarks/tasyncchain.nim
+]#
+
+import std/[asyncdispatch, monotimes, times]
+
+proc leaf(): Future[int] {.async.} =
+  let f = newFuture[void]("leaf")
+  callSoon(proc () = f.complete())
+  await f
+  result = 1
+
+proc chain(depth: int): Future[int] {.async.} =
+  if depth == 0:
+    result = await leaf()
+  else:
+    let inner = await chain(depth - 1)
+    result = inner + 1
+
+proc loop(steps: int): Future[int] {.async.} =
+  # one call that suspends many times
+  for i in 0..<steps:
+    let x = await leaf()
+    result += x
+
+proc report(name: string; awaits: int; d: Duration; stats: AllocStats) =
+  echo name, ": ", d.inNanoseconds div awaits, " ns/await, ",
+    awaits, " awaits, ", stats
+
+proc main =
+  for depth in [1, 10, 100]:
+    let n = 100_000 div depth
+    let s = getAllocStats()
+    let t = getMonoTime()
+    var res = 0
+    for i in 0..<n:
+      res += waitFor chain(depth)
+    let d = getMonoTime() - t
+    doAssert res == n * (depth + 1)
+    report("depth " & $depth, n * (depth + 1), d, getAllocStats() - s)
+
+  let s = getAllocStats()
+  let t = getMonoTime()
+  doAssert waitFor(loop(100_000)) == 100_000
+  report("loop", 100_000, getMonoTime() - t, getAllocStats() - s)
+
+main()
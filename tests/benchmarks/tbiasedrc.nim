@@ -0,0 +1,85 @@
+discard """
+  action: compile
+  matrix: "--mm:arc; --mm:atomicArc -d:nimNoBiasedRc; --mm:atomicArc"
+"""
+
+#[
+Reference counting costs of `--mm:arc`, `--mm:atomicArc` without and with
+biased reference counting.
+
+nim r -d:danger --mm:arc tests/benchmarks/tbiasedrc.nim
+nim r -d:danger --mm:atomicArc -d:nimNoBiasedRc tests/benchmarks/tbiasedrc.nim
+nim r -d:danger --mm:atomicArc tests/benchmarks/tbiasedrc.nim
+]#
+
+import std/[monotimes, times, typedthreads]
+
+type
+  Node = ref object
+    next: Node
+    val: int
+
+const
+  listLen = 10_000
+  rounds = 2_000
+  threads = 4
+
+var box: Node
+
+proc build(n: int): Node =
+  for i in 0..<n:
+    result = Node(next: result, val: i)
+
+proc walk(list: Node; rounds: int): int =
+  # every step copies a ref into `held` and destroys the one it replaces
+  var held = newSeq[Node](16)
+  for r in 0..<rounds:
+    var it = list
+    var i = 0
+    while it != nil:
+      held[i and 15] = it
+      result += it.val
+      it = it.next
+      inc i
+
+template bench(name: string, body: untyped) =
+  block:
+    let t = getMonoTime()
+    body
+    echo name, ": ", (getMonoTime() - t).inMilliseconds, "ms"
+
+proc reader() {.thread.} =
+  {.cast(gcsafe).}:
+    doAssert walk(box, rounds div threads) > 0
+
+proc dropper() {.thread.} =
+  {.cast(gcsafe).}:
+    var list = move box
+    list = nil
+
+proc main =
+  bench "single thread, copies":
+    doAssert walk(build(listLen), rounds) > 0
+
+  bench "single thread, allocations":
+    for r in 0..<rounds div 10:
+      doAssert build(listLen) != nil
+
+  when defined(gcAtomicArc):
+    # `--mm:arc` cannot share refs between threads
+    bench "shared, copies from " & $threads & " threads":
+      box = build(listLen)
+      var ts: array[threads, Thread[void]]
+      for t in mitems(ts): createThread(t, reader)
+      joinThreads(ts)
+      box = nil
+
+    bench "shared, freed by another thread":
+      for r in 0..<rounds div 100:
+        box = build(listLen)
+        var t: Thread[void]
+        createThread(t, dropper)
+        joinThread(t)
+      GC_fullCollect()
+
+main()
@@ -0,0 +1,38 @@
+discard """
+  action: compile
+  matrix: "--mm:orc; --mm:orc -d:nimHugePages"
+"""
+
+#[
+Random reads from a large in-memory index, with and without huge pages.
+Check `grep AnonHugePages /proc/meminfo` while it runs to see how much of
+the heap the kernel actually backs with huge pages.
+
+nim r -d:danger --mm:orc tests/benchmarks/thugepages.nim
+nim r -d:danger --mm:orc -d:nimHugePages tests/benchmarks/thugepages.nim
+NIM_HUGEPAGES=hugetlb nim r -d:danger --mm:orc -d:nimHugePages tests/benchmarks/thugepages.nim
+]#
+
+import std/[monotimes, times]
+
+proc main =
+  const entries = 64 * 1024 * 1024 # 512 MB of ints
+  var index = newSeq[int](entries)
+  for i in 0..<entries: index[i] = i
+
+  var x = 88172645463325252'u64 # xorshift
+  var sum = 0
+  const n = 20_000_000
+  let t = getMonoTime()
+  for i in 0..<n:
+    x = x xor (x shl 13)
+    x = x xor (x shr 7)
+    x = x xor (x shl 17)
+    sum += index[int(x mod entries.uint64)]
+  let d = getMonoTime() - t
+  echo "random reads: ", d.inNanoseconds div n, " ns/read (", sum, ")"
+  when defined(nimHugePages):
+    echo "huge page coverage: ", getHugePageMem() div (1024 * 1024), " of ",
+      getTotalMem() div (1024 * 1024), " MB"
+
+main()
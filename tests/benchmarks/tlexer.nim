@@ -0,0 +1,33 @@
+discard """
+  action: compile
+"""
+
+#[
+Tokenizes every module of the standard library with the compiler's lexer.
+
+nim r -d:danger tests/benchmarks/tlexer.nim
+]#
+
+import std/[os, strutils, monotimes]
+import ../../compiler/[lexer, llstream, idents, options, pathutils]
+
+let conf = newConfigRef()
+conf.notes = {} # no style or deprecation hints
+let cache = newIdentCache()
+var files: seq[AbsoluteFile] = @[]
+for path in walkDirRec(currentSourcePath().parentDir / ".." / ".." / "lib"):
+  if path.endsWith(".nim"): files.add AbsoluteFile(path)
+
+var tokens = 0
+let start = getMonoTime()
+for round in 1..5:
+  for f in files:
+    var L: Lexer
+    openLexer(L, f, llStreamOpen(f, fmRead), cache, conf)
+    var tok: Token
+    while true:
+      rawGetTok(L, tok)
+      if tok.tokType == tkEof: break
+      inc tokens
+    closeLexer(L)
+echo files.len, " files, ", tokens, " tokens: ", getMonoTime() - start
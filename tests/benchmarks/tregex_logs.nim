@@ -0,0 +1,57 @@
+discard """
+  action: compile
+"""
+
+#[
+Compares recompiling patterns built at runtime against `cachedRe`, and
+string captures against bound captures, on log-parsing patterns.
+
+nim r -d:danger tests/benchmarks/tregex_logs.nim
+]#
+
+import std/[re, times]
+
+const
+  lines = [
+    "2024-01-03 12:00:01 INFO  [http] GET /index.html 200 1532",
+    "2024-01-03 12:00:02 WARN  [db] slow query took 1200ms",
+    "2024-01-03 12:00:02 ERROR [http] POST /api/v1/items 500 87",
+    "2024-01-03 12:00:03 INFO  [auth] user=alice login ok",
+  ]
+  levels = ["INFO", "WARN", "ERROR"]
+
+proc bench(name: string, body: proc (): int) =
+  let t = cpuTime()
+  let n = body()
+  echo name, ": ", cpuTime() - t, "s (", n, ")"
+
+proc main =
+  let n = 100_000
+  bench("re() per line") do () -> int:
+    result = 0
+    for i in 0..<n:
+      let level = levels[i mod levels.len]
+      if lines[i mod lines.len].contains(re("\\s" & level & "\\s+\\[(\\w+)\\]")):
+        inc result
+  bench("cachedRe per line") do () -> int:
+    result = 0
+    for i in 0..<n:
+      let level = levels[i mod levels.len]
+      if lines[i mod lines.len].contains(cachedRe("\\s" & level & "\\s+\\[(\\w+)\\]")):
+        inc result
+
+  let request = re"(GET|POST) (\S+) (\d+) (\d+)"
+  bench("string captures") do () -> int:
+    result = 0
+    var caps: array[4, string]
+    for i in 0..<n*10:
+      if find(lines[i mod lines.len], request, caps) >= 0:
+        result += caps[3].len
+  bench("bound captures") do () -> int:
+    result = 0
+    var caps: array[4, tuple[first, last: int]]
+    for i in 0..<n*10:
+      if find(lines[i mod lines.len], request, caps) >= 0:
+        result += caps[3].last - caps[3].first + 1
+
+main()
@@ -0,0 +1,32 @@
+discard """
+  action: compile
+  matrix: "--mm:orc"
+"""
+
+#[
+Grows a seq to 4 GB in steps of 16 MB. Payloads of 4 MB and more are
+resized with `mremap` on Linux instead of being copied; the time per step
+and the peak memory show what copying would cost.
+
+nim r -d:danger --mm:orc tests/benchmarks/tseqgrowth.nim
+]#
+
+import std/[monotimes, times]
+
+proc main =
+  const
+    step = 16 * 1024 * 1024
+    target = 4 * 1024 * 1024 * 1024
+  var s: seq[byte] = @[]
+  var slowest = 0'i64
+  let t = getMonoTime()
+  while s.len < target:
+    let t0 = getMonoTime()
+    s.setLen(s.len + step)
+    slowest = max(slowest, (getMonoTime() - t0).inMicroseconds)
+  let d = getMonoTime() - t
+  echo "grew to ", s.len div (1024 * 1024), " MB in ", d.inMilliseconds,
+    " ms, slowest step ", slowest div 1000, " ms, peak ",
+    getMaxMem() div (1024 * 1024), " MB"
+
+main()
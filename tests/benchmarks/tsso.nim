@@ -0,0 +1,50 @@
+discard """
+  action: compile
+  matrix: "-d:nimAllocStats; -d:nimAllocStats -d:nimSso"
+"""
+
+#[
+Allocations and time for short strings, with and without inline storage.
+
+nim r -d:danger -d:nimAllocStats tests/benchmarks/tsso.nim
+nim r -d:danger -d:nimAllocStats -d:nimSso tests/benchmarks/tsso.nim
+]#
+
+import std/[strutils, tables, times]
+
+template bench(name: string, body: untyped) =
+  block:
+    let stats = getAllocStats()
+    let t = cpuTime()
+    let res = body
+    let d = getAllocStats() - stats
+    echo name, ": ", cpuTime() - t, "s, ", d, " (", res, ")"
+
+proc keys(n: int): int =
+  var t = initTable[string, int]()
+  for i in 0..<n:
+    let k = "k" & $(i mod 1000)
+    t.mgetOrPut(k, 0) += 1
+  result = t.len
+
+proc headers(n: int): int =
+  const lines = ["Host: a", "Accept: */*", "Connection: close", "X-Id: 42"]
+  for i in 0..<n:
+    for line in lines:
+      let name = line.split(':', 1)[0].toLowerAscii
+      result += name.len
+
+type Color = enum red, green, blue
+
+proc enums(n: int): int =
+  for i in 0..<n:
+    let s = $Color(i mod 3)
+    result += s.len
+
+proc main =
+  const n = 1_000_000
+  bench("table keys", keys(n))
+  bench("header names", headers(n))
+  bench("enum strings", enums(n))
+
+main()
@@ -0,0 +1,55 @@
+discard """
+  action: compile
+"""
+
+#[
+Decodes a file of little-endian records through a plain `FileStream` and
+through a `BufferedStream`.
+
+nim r -d:danger tests/benchmarks/tstreams.nim
+]#
+
+import std/[streams, times, os]
+
+const records = 2_000_000
+
+template bench(name: string, body: untyped) =
+  block:
+    let t = cpuTime()
+    let res = body
+    echo name, ": ", cpuTime() - t, "s (", res, ")"
+
+proc decode(s: Stream): int =
+  for _ in 0..<records:
+    let tag = s.readUint8()
+    let len = s.readInt32()
+    let val = s.readInt64()
+    result += int(tag) + len + int(val and 0xff)
+
+proc decodeSlices(s: Stream): int =
+  for _ in 0..<records:
+    let v = s.peekSlice(13)
+    result += int(v.data[0]) + int(v.data[1]) + int(v.data[5])
+    s.skip(13)
+
+proc run(s: Stream, decoder: proc (s: Stream): int {.nimcall.}): int =
+  result = decoder(s)
+  s.close()
+
+proc main =
+  let filename = getTempDir() / "tstreams_bench.bin"
+  block:
+    let s = openFileStream(filename, fmWrite)
+    for i in 0..<records:
+      s.write(uint8(i and 0xff))
+      s.write(int32(i))
+      s.write(int64(i) * 3)
+    s.close()
+
+  bench("FileStream", run(openFileStream(filename), decode))
+  bench("BufferedStream", run(newBufferedStream(openFileStream(filename)), decode))
+  bench("BufferedStream.peekSlice",
+        run(newBufferedStream(openFileStream(filename)), decodeSlices))
+  removeFile(filename)
+
+main()
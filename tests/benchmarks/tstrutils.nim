@@ -0,0 +1,40 @@
+discard """
+  action: compile
+"""
+
+#[
+Microbenchmarks for the strutils byte loops.
+
+nim r -d:danger tests/benchmarks/tstrutils.nim
+]#
+
+import std/[strutils, times]
+
+template bench(name: string, n: int, body: untyped) =
+  block:
+    let t = cpuTime()
+    var res = 0
+    for _ in 0..<n:
+      res += body
+    echo name, ": ", cpuTime() - t, "s (", res, ")"
+
+proc splitLen(s: string, sep: char | string): int =
+  for x in s.split(sep): result += x.len
+
+proc main =
+  var text = ""
+  for i in 0..<20_000:
+    text.add "GET /Some/Path/" & $i & " HTTP/1.1\r\nHost: Example.COM\r\n"
+  let n = 200
+
+  bench("find(string)", n): text.find("HTTP/2")
+  bench("find(string, last)", n): text.find("HTTP/2", 0, text.high - 1)
+  bench("count(char)", n): text.count('/')
+  bench("count(string)", n): text.count("\r\n")
+  bench("split(char)", n): text.splitLen('\n')
+  bench("split(string)", n): text.splitLen("\r\n")
+  bench("replace", n): text.replace("Example", "example").len
+  bench("toLowerAscii", n): text.toLowerAscii.len
+  bench("toUpperAscii", n): text.toUpperAscii.len
+
+main()
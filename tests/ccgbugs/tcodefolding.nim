@@ -0,0 +1,36 @@
+discard """
+  disabled: "win"
+  disabled: "osx"
+  ccodecheck: "'__attribute__((alias('"
+  output: '''
+3 3 3
+@[1, 2] @[1, 2]
+1 2
+'''
+"""
+
+# instantiations with identical C code are folded into one, `twice` for
+# the distinct types at least; they must still behave like the
+# instantiations they replace
+
+type
+  Meters = distinct int
+  Seconds = distinct int
+
+proc twice[T](x: T): T = T(int(x) * 2 + 1)
+
+echo int(twice(1)), " ", int(twice(Meters(1))), " ", int(twice(Seconds(1)))
+
+proc collect[T](n: int): seq[T] =
+  for i in 1..n: result.add T(i)
+
+let a = collect[Meters](2)
+let b = collect[int](2)
+echo "@[", int(a[0]), ", ", int(a[1]), "]", " ", b
+
+proc first[T](s: seq[T]): T = s[0]
+proc second[T](s: seq[T]): T = s[1]
+
+let f = first[int]
+let g = second[int]
+echo f(b), " ", g(b)
@@ -0,0 +1,71 @@
+discard """
+  matrix: "--stackTrace:native; --stackTrace:native -d:release"
+  disabled: "win"
+  disabled: "osx"
+"""
+
+import std/strutils
+
+var counter: int
+
+proc fail(x: int) {.noinline.} =
+  if x > 0:
+    raise newException(ValueError, "boom")
+  inc counter
+
+proc middle(x: int) {.noinline.} =
+  fail(x)
+  inc counter # no tail call
+
+proc outer() {.noinline.} =
+  try:
+    middle(1)
+    inc counter
+  except ValueError as e:
+    let entries = getStackTraceEntries(e)
+    var names: seq[string] = @[]
+    for entry in entries: names.add $entry.procname
+    doAssert names.len >= 3, $names
+    doAssert names[^1] == "fail", $names
+    doAssert names[^2] == "middle", $names
+    doAssert "outer" in names, $names
+    doAssert $entries[^1].filename == "tnativestacktrace.nim"
+    doAssert entries[^1].line == 13, $entries[^1].line
+    let trace = getStackTrace(e)
+    doAssert "tnativestacktrace.nim(13) fail" in trace, trace
+    doAssert "middle" in trace, trace
+
+outer()
+
+block: # the trace of the exception itself is resolved, by the cached tables
+  for i in 0..1:
+    try:
+      middle(1)
+    except ValueError as e:
+      doAssert e.trace.len > 0 and e.trace[^1].procname == nil
+      let trace = getStackTrace(e)
+      doAssert "tnativestacktrace.nim(13) fail" in trace, trace
+      doAssert e.trace[^1].procname == "fail", $e.trace[^1].procname
+      doAssert e.trace[^1].line == 13
+
+block: # the current stack
+  let s = getStackTrace()
+  doAssert s.startsWith("Traceback (most recent call last)\n"), s
+  doAssert "tnativestacktrace" in s, s
+
+when compileOption("threads"):
+  import std/typedthreads
+
+  proc inThread() {.thread.} =
+    # the walk ends at the top of the thread's stack
+    try:
+      middle(1)
+    except ValueError as e:
+      let entries = getStackTraceEntries(e)
+      doAssert entries.len >= 2 and entries[^1].procname == "fail", $entries.len
+      doAssert "inThread" in getStackTrace(e)
+
+  block: # another thread
+    var t: Thread[void]
+    createThread(t, inThread)
+    joinThread(t)
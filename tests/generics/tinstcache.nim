@@ -0,0 +1,56 @@
+discard """
+  matrix: "--hint:CacheStats:on"
+  output: "ok"
+"""
+
+# Instantiations must be found again through the hashed generic caches,
+# including instantiations created while an argument was still a forward
+# declaration.
+
+import std/[tables, macros]
+
+type
+  Holder = object
+    late: Table[int, Late]    # instantiated while `Late` is a forward type
+    early: Table[Late, int]
+  Late = object
+    x: int
+  Dist = distinct int
+  Box[T] = object
+    val: T
+
+proc hash(x: Late): int = x.x
+
+proc key[T](x: T): int = sizeof(x)
+
+macro manyTables(n: static int): untyped =
+  # distinct instantiations of the same generic with different arguments
+  result = newStmtList()
+  for i in 0..<n:
+    let arr = nnkBracketExpr.newTree(ident"array", newLit(i + 1), ident"int")
+    result.add quote do:
+      doAssert Table[`arr`, string] is Table[`arr`, string]
+      doAssert key(default(Box[`arr`])) == sizeof(`arr`)
+
+manyTables(40)
+
+var h: Holder
+h.late[1] = Late(x: 2)
+h.early[Late(x: 3)] = 4
+doAssert h.late is Table[int, Late]
+doAssert h.early is Table[Late, int]
+doAssert Table[int, Late] is typeof(h.late)
+doAssert Box[Dist] isnot Box[int]
+doAssert Box[seq[Dist]] isnot Box[seq[int]]
+doAssert Box[ref Late] is Box[ref Late]
+# instantiations as arguments: told apart by their generic body and arguments
+doAssert Box[Box[int]] isnot Box[Box[float]]
+doAssert Box[Table[int, int]] isnot Box[Box[int]]
+doAssert Box[Box[Dist]] is Box[Box[Dist]]
+doAssert key(default(Box[Box[int8]])) == 1
+doAssert key(default(Box[Box[int64]])) == 8
+var a: Box[Dist]
+var b: Box[Dist]
+a = b
+doAssert key(a) == key(b)
+echo "ok"
@@ -0,0 +1,54 @@
+discard """
+  joinable: false
+"""
+
+# an instance that is created while an instance among its arguments is
+# still being built must be found again once that one is complete; the
+# CacheStats hint counts the types that were instantiated twice
+
+import stdtest/specialpaths
+import std/[osproc, strformat, strutils, os]
+
+const
+  nim = getCurrentCompilerExe()
+  dir = buildDir / "tinstcache_stats"
+  file = dir / "minstcache.nim"
+
+proc duplicates(code: string): int =
+  writeFile(file, """
+type
+  Box[T] = object
+    val: T
+""" & code)
+  let (msg, exitCode) = execCmdEx(fmt"{nim} check --hints:off --hint:CacheStats:on {file}")
+  doAssert exitCode == 0, msg
+  for line in msg.splitLines:
+    const suffix = " duplicate types; "
+    let k = line.find(suffix)
+    if k >= 0:
+      var i = k
+      while i > 0 and line[i - 1] in Digits: dec i
+      return parseInt(line.substr(i, k - 1))
+  doAssert false, msg
+
+createDir(dir)
+
+let base = duplicates("")
+
+block: # `Box[Node[int]]` is instantiated inside of `Node[int]`
+  let d = duplicates("""
+type
+  Node[T] = ref object
+    next: Box[Node[T]]
+    kids: seq[Box[Node[T]]]
+    val: T
+
+var n = Node[int](val: 1)
+var b: Box[Node[int]]
+b = n.next
+n.kids.add b
+doAssert n.kids[0] is Box[Node[int]]
+""")
+  doAssert d == base, $(d, base)
+
+removeDir(dir)
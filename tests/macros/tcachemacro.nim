@@ -0,0 +1,32 @@
+discard """
+  output: '''
+@["red", "green", "blue"]
+@["red", "green", "blue"]
+3
+7
+'''
+"""
+
+# cached expansions must behave like fresh ones; calls that cannot be cached
+# (typed arguments, results with symbols) are expanded as usual
+
+import std/macros
+
+macro enumStrings(names: varargs[untyped]): untyped {.cacheMacro.} =
+  result = newNimNode(nnkPrefix)
+  result.add ident"@"
+  var arr = newNimNode(nnkBracket)
+  for n in names: arr.add newLit($n)
+  result.add arr
+
+macro count(x: typed): untyped {.cacheMacro.} =
+  result = newLit(x.len)
+
+macro addSeven(x: untyped): untyped {.cacheMacro.} =
+  result = quote do: `x` + 7
+
+echo enumStrings(red, green, blue)
+for i in 0..0:
+  echo enumStrings(red, green, blue)
+echo count([1, 2, 3])
+echo addSeven(0)
@@ -0,0 +1,81 @@
+discard """
+  joinable: false
+"""
+
+# a `.cacheMacro` expansion is reused by the next build and invalidated when
+# the macro, or a type or constant it reads, changes
+
+import stdtest/specialpaths
+import std/[osproc, strformat, strutils, os]
+
+const
+  nim = getCurrentCompilerExe()
+  dir = buildDir / "tcachemacro_rebuild"
+  nimcache = dir / "nimcache"
+  file = dir / "mcachemacro.nim"
+  exe = dir / "mcachemacro".addFileExt(ExeExt)
+
+proc program(sep, field: string): string =
+  result = fmt"""
+import std/macros
+
+type Color = object
+  {field}: int
+
+const sep = "{sep}"
+
+macro describe(names: varargs[untyped]): untyped {{.cacheMacro.}} =
+  var s = ""
+  for n in names: s.add $n & sep
+  for f in getTypeImpl(Color)[2]: s.add $f[0]
+  result = newLit(s)
+
+var calls {{.compileTime.}} = 0
+
+macro counter(): untyped {{.cacheMacro.}} =
+  # reads compile-time state, never cached
+  inc calls
+  result = newLit(calls)
+
+echo describe(red, green)
+echo counter()
+"""
+
+proc build(sep, field: string): tuple[stats, output: string] =
+  writeFile(file, program(sep, field))
+  let (msg, code) = execCmdEx(fmt"{nim} c --hints:off --hint:CacheStats:on --nimcache:{nimcache} -o:{exe} {file}")
+  doAssert code == 0, msg
+  for line in msg.splitLines:
+    if "macro expansion cache:" in line: result.stats = line
+  doAssert result.stats.len > 0, msg
+  let (output, status) = execCmdEx(exe)
+  doAssert status == 0, output
+  result.output = output.strip
+
+removeDir(dir)
+createDir(dir)
+
+block: # first build
+  let (stats, output) = build(",", "r")
+  doAssert "0 hits, 1 misses" in stats, stats
+  doAssert output == "red,green,r\n1", output
+
+block: # unchanged: reused
+  let (stats, output) = build(",", "r")
+  doAssert "1 hits, 0 misses" in stats, stats
+  doAssert output == "red,green,r\n1", output
+
+block: # the constant changed
+  let (stats, output) = build(";", "r")
+  doAssert "0 hits, 1 misses" in stats, stats
+  doAssert output == "red;green;r\n1", output
+
+block: # the type changed
+  let (stats, output) = build(";", "g")
+  doAssert "0 hits, 1 misses" in stats, stats
+  doAssert output == "red;green;g\n1", output
+
+block: # stale expansions are removed
+  var files = 0
+  for f in walkFiles(nimcache / "macro_*.rod"): inc files
+  doAssert files == 1, $files
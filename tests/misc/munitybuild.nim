@@ -0,0 +1,23 @@
+# shared by the modules of tunitybuild.nim
+
+type
+  Stack*[T] = object
+    items: seq[T]
+
+proc push*[T](s: var Stack[T]; x: T) = s.items.add x
+proc pop*[T](s: var Stack[T]): T = s.items.pop()
+proc len*[T](s: Stack[T]): int = s.items.len
+
+proc twice*(x: int): int {.inline.} = x * 2
+
+var calls* {.threadvar.}: int
+
+proc bump*(): int =
+  inc calls
+  result = calls
+
+proc unityAnswer(): cint {.exportc: "unityAnswer".} = 42
+
+# a module private proc with the same name as one in munitybuild2
+proc helper(): string = "helper1"
+proc helper1*(): string = helper()
@@ -0,0 +1,21 @@
+# shared by the modules of tunitybuild.nim
+
+import munitybuild
+
+proc sumOf*(xs: openArray[int]): int =
+  # the same generic instance as in the main module
+  var s = Stack[int]()
+  for x in xs: s.push twice(x)
+  while s.len > 0: result += s.pop()
+
+proc unityAnswer(): cint {.importc: "unityAnswer".}
+
+proc answer*(): int = int(unityAnswer())
+
+proc bumpTwice*(): int =
+  discard bump()
+  result = bump()
+
+# a module private proc with the same name as one in munitybuild
+proc helper(): string = "helper2"
+proc helper2*(): string = helper()
@@ -0,0 +1,42 @@
+discard """
+  matrix: "--unityBuild:on; --unityBuild:on --unityShards:2; --unityBuild:on --unityShards:3 -d:release"
+  output: '''
+12
+3 2
+abc
+42
+2 1
+helper1 helper2
+'''
+"""
+
+# a program of several modules compiled as one or a few C files
+
+import std/typedthreads
+import munitybuild, munitybuild2
+
+var ints = Stack[int]()
+ints.push twice(1)
+ints.push 3
+echo sumOf([1, 2, 3])
+echo ints.pop(), " ", ints.pop()
+
+var strs = Stack[string]()
+for s in ["c", "b", "a"]: strs.push s
+var abc = ""
+while strs.len > 0: abc.add strs.pop()
+echo abc
+
+echo answer()
+
+# every thread has its own counter
+proc worker(res: ptr int) {.thread.} =
+  res[] = bump()
+
+var res = 0
+var t: Thread[ptr int]
+createThread(t, worker, addr res)
+joinThread(t)
+echo bumpTwice(), " ", res
+
+echo helper1(), " ", helper2()
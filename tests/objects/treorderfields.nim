@@ -0,0 +1,99 @@
+discard """
+  targets: "c cpp"
+  output: '''
+(flag: true, value: 2.5, kind: 3)
+flag value kind
+(flag: false, value: 1.5, kind: 7)
+(a: 1, b: 2, c: 3)
+(kind: true, x: 1, y: 2.0, z: 3)
+OK
+'''
+"""
+
+# fields of `.reorderFields` objects are laid out by decreasing alignment,
+# the C code has to agree with sizeof and offsetOf
+
+import std/macros
+
+macro c_offsetof(fieldAccess: typed): int32 =
+  let a = fieldAccess[0].getTypeInst
+  let b = fieldAccess[1]
+  result = quote do:
+    var res: int32
+    {.emit: [res, " = offsetof(", `a`, ", ", `b`, ");"] .}
+    res
+
+template c_offsetof(t: typedesc, a: untyped): int32 =
+  var x: ptr t
+  c_offsetof(x[].a)
+
+macro c_sizeof(a: typed): int32 =
+  result = quote do:
+    var res: int32
+    {.emit: [res, " = sizeof(", `a`, ");"] .}
+    res
+
+type
+  Node {.reorderFields.} = object
+    flag: bool
+    value: float64
+    kind: uint8
+
+  Declared = object
+    flag: bool
+    value: float64
+    kind: uint8
+
+  Packed {.reorderFields, packed.} = object
+    a: uint8
+    b: int64
+    c: uint8
+
+  Variant {.reorderFields.} = object
+    case kind: bool
+    of true:
+      x: uint8
+      y: float64
+      z: int16
+    of false:
+      w: int32
+
+  Derived {.reorderFields.} = object of RootObj
+    small: uint8
+    big: int64
+
+static:
+  doAssert sizeof(Node) == 16
+  doAssert sizeof(Declared) == 24
+  doAssert sizeof(Packed) == 10
+  doAssert offsetOf(Node, value) == 0
+  doAssert offsetOf(Node, flag) == 8
+  doAssert offsetOf(Node, kind) == 9
+
+doAssert c_sizeof(Node) == sizeof(Node)
+doAssert c_offsetof(Node, value) == offsetOf(Node, value)
+doAssert c_offsetof(Node, flag) == offsetOf(Node, flag)
+doAssert c_offsetof(Node, kind) == offsetOf(Node, kind)
+doAssert c_sizeof(Declared) == sizeof(Declared)
+doAssert c_sizeof(Packed) == sizeof(Packed)
+doAssert c_sizeof(Variant) == sizeof(Variant)
+doAssert c_sizeof(Derived) == sizeof(Derived)
+doAssert c_offsetof(Derived, small) == offsetOf(Derived, small)
+
+# iteration, `$` and constructors keep the declaration order
+var n = Node(flag: true, value: 2.5, kind: 3)
+echo n
+var names = ""
+for name, _ in fieldPairs(n):
+  if names.len > 0: names.add ' '
+  names.add name
+echo names
+
+const c = Node(flag: false, value: 1.5, kind: 7)
+let p = Packed(a: 1, b: 2, c: 3)
+echo c
+echo (a: p.a, b: p.b, c: p.c)
+
+const v = Variant(kind: true, x: 1, y: 2.0, z: 3)
+echo (kind: v.kind, x: v.x, y: v.y, z: v.z)
+echo "OK"
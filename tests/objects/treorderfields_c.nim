@@ -0,0 +1,90 @@
+discard """
+  targets: "c cpp"
+  matrix: "--reorderFields:on"
+"""
+
+# `--reorderFields:on` leaves objects that mirror C structs alone: those of
+# the standard library and its wrappers and those passed to importc or
+# exportc routines or through proc types with a C calling convention
+
+import std/os
+when defined(windows):
+  import std/winlean
+
+type
+  Inner = object
+    tag: uint8
+    value: float64
+  Pair = object
+    tag: uint8
+    value: float64
+    code: uint8
+    inner: Inner
+  Loose = object # never passed to C: reordered
+    tag: uint8
+    value: float64
+    code: uint8
+  Exported = object
+    tag: uint8
+    value: float64
+    code: uint8
+  Event = object
+    tag: uint8
+    value: float64
+    code: uint8
+  OnEvent = proc (e: ptr Event): float64 {.cdecl.}
+
+{.emit: """/*TYPESECTION*/
+typedef struct { unsigned char tag; double value; } CInner;
+typedef struct { unsigned char tag; double value; unsigned char code; CInner inner; } CPair;
+static double pairValue(void* q) {
+  CPair* p = (CPair*)q;
+  return p->value + p->code + p->inner.value;
+}
+typedef struct { unsigned char tag; double value; unsigned char code; } CEvent;
+static double fireEvent(void* f) {
+  double (*onEvent)(CEvent*) = (double (*)(CEvent*))f;
+  CEvent e = {1, 2.5, 3};
+  return onEvent(&e);
+}
+""".}
+
+proc pairValue(p: ptr Pair): float64 {.importc, nodecl.}
+proc fireEvent(onEvent: pointer): float64 {.importc, nodecl.}
+
+proc exportedValue(e: Exported): float64 {.exportc.} = e.value
+
+doAssert offsetOf(Pair, value) == 8
+doAssert offsetOf(Pair, code) == 16
+doAssert offsetOf(Pair, inner) == 24
+doAssert offsetOf(Inner, value) == 8
+doAssert sizeof(Pair) == 40
+doAssert sizeof(Loose) == 16
+
+var p = Pair(tag: 1, value: 2.5, code: 3, inner: Inner(tag: 4, value: 0.5))
+doAssert pairValue(addr p) == 6.0
+
+block: # exportc routines
+  doAssert offsetOf(Exported, code) == 16
+  doAssert sizeof(Exported) == 24
+  doAssert exportedValue(Exported(value: 1.5)) == 1.5
+
+block: # proc types with a C calling convention
+  doAssert offsetOf(Event, code) == 16
+  doAssert sizeof(Event) == 24
+  let onEvent: OnEvent = proc (e: ptr Event): float64 {.cdecl.} =
+    e.value + float64(e.code)
+  doAssert fireEvent(cast[pointer](onEvent)) == 5.5
+
+when defined(windows):
+  doAssert offsetOf(SECURITY_ATTRIBUTES, nLength) == 0
+  doAssert offsetOf(SECURITY_ATTRIBUTES, lpSecurityDescriptor) == sizeof(pointer)
+  doAssert offsetOf(SECURITY_ATTRIBUTES, bInheritHandle) == 2 * sizeof(pointer)
+  doAssert offsetOf(PROCESS_INFORMATION, hThread) == sizeof(Handle)
+  doAssert offsetOf(PROCESS_INFORMATION, dwProcessId) == 2 * sizeof(Handle)
+  doAssert offsetOf(PROCESS_INFORMATION, dwThreadId) == 2 * sizeof(Handle) + 4
+  doAssert offsetOf(STARTUPINFO, wShowWindow) == 4 * sizeof(pointer) + 32
+
+block: # the standard library keeps the declared order
+  doAssert offsetOf(FileInfo, kind) < offsetOf(FileInfo, size)
+  doAssert offsetOf(FileInfo, permissions) < offsetOf(FileInfo, linkCount)
@@ -2,9 +2,17 @@ discard """
 joinable: false
 """
 
-import osproc, streams, strutils, os
+import osproc, streams, strutils, os, sequtils, times
+
+when not defined(windows):
+  import posix
+
+when defined(linux):
+  proc prctl(option: cint): cint {.importc, header: "<sys/prctl.h>", varargs.}
+  const PR_SET_CHILD_SUBREAPER = cint(36)
 
 const NumberOfProcesses = 13
+const BigOutput = 200_000 # more than a pipe buffer holds
 
 var gResults {.threadvar.}: seq[string]
 
@@ -13,6 +21,18 @@ proc execCb(idx: int, p: Process) =
   if exitCode < len(gResults):
     gResults[exitCode] = p.outputStream.readAll.strip
 
+proc bigCb(idx: int, p: Process) =
+  doAssert p.peekExitCode == 0
+  doAssert p.outputStream.readAll.len == BigOutput
+
+var grandchild {.threadvar.}: int
+
+proc grandchildCb(idx: int, p: Process) =
+  doAssert p.peekExitCode == 0
+  let output = p.outputStream.readAll.strip
+  if idx == 0: grandchild = parseInt(output.splitLines[0])
+  doAssert output.endsWith("done")
+
 when true:
   if paramCount() == 0:
     gResults = newSeq[string](NumberOfProcesses)
@@ -25,6 +45,31 @@ when true:
                              afterRunEvent = execCb)
     doAssert(cres == len(commands) - 1)
     doAssert(gResults == checks)
+
+    when not defined(windows):
+      # the children would block on their full pipes if their output was
+      # only read after they exit
+      let bigCommands = newSeqWith(4, getAppFileName() & " big")
+      doAssert execProcesses(bigCommands, options = {poStdErrToStdOut}, n = 2,
+                             afterRunEvent = bigCb) == 0
+
+      # the background grandchild keeps the pipe open after the child exits;
+      # the child is still reaped right away
+      when defined(linux):
+        # the orphaned grandchild becomes our child, so that we can reap it
+        doAssert prctl(PR_SET_CHILD_SUBREAPER, culong(1)) == 0
+      let start = epochTime()
+      doAssert execProcesses(["sleep 10 & echo $!; echo done", "echo done"],
+                             options = {poStdErrToStdOut}, n = 2,
+                             afterRunEvent = grandchildCb) == 0
+      doAssert epochTime() - start < 5
+      doAssert grandchild > 0
+      doAssert posix.kill(Pid(grandchild), SIGKILL) == 0
+      when defined(linux):
+        var status: cint
+        doAssert waitpid(Pid(grandchild), status, 0) == Pid(grandchild)
+  elif paramStr(1) == "big":
+    stdout.write repeat('x', BigOutput)
   else:
     echo paramStr(1)
     programResult = parseInt(paramStr(1))
@@ -0,0 +1,82 @@
+discard """
+  output: '''
+15 15
+10
+2 3 4 5 6
+caught shrink
+caught past end
+caught in except
+caught overflow
+ok
+'''
+"""
+
+# index and overflow checks are only removed where they cannot fail
+
+proc sum(s: seq[int]): int =
+  for i in 0..<s.len: result += s[i]
+
+proc sumDown(a: array[5, int]): int =
+  for i in countdown(4, 0): result += a[i]
+
+proc guarded(s: openArray[int]; k: int): int =
+  if k >= 0 and k < s.len: result = s[k]
+
+proc shifted(s: var seq[int]) =
+  for i in 0..<s.len:
+    s[i] = s[i] + 1
+
+let data = @[1, 2, 3, 4, 5]
+echo sum(data), " ", sumDown([1, 2, 3, 4, 5])
+echo guarded(data, 3) + guarded(data, 7) + guarded(data, -1) + 6
+
+var d = data
+shifted(d)
+echo d[0], " ", d[1], " ", d[2], " ", d[3], " ", d[4]
+
+proc shrinking(s: var seq[int]): int =
+  let n = s.len
+  for i in 0..<n:
+    if i == 2: s.setLen(2)
+    result += s[i]
+
+try:
+  discard shrinking(d)
+except IndexDefect:
+  echo "caught shrink"
+
+proc pastEnd(s: seq[int]; n: int): int =
+  for i in 0..n:
+    result += s[i]
+
+try:
+  discard pastEnd(data, 3)
+  discard pastEnd(data, 5)
+except IndexDefect:
+  echo "caught past end"
+
+proc afterFailure(s: seq[int]; n: int): int =
+  try:
+    for i in 0..<n: result += s[i]
+  except IndexDefect:
+    # what the body established does not hold here
+    result = s[n - 1]
+
+try:
+  discard afterFailure(data, 7)
+except IndexDefect:
+  echo "caught in except"
+
+proc bump(x: int): int =
+  result = x
+  if result < high(int):
+    inc result
+  inc result
+
+try:
+  discard bump(high(int) - 2)
+  discard bump(high(int))
+except OverflowDefect:
+  echo "caught overflow"
+
+echo "ok"
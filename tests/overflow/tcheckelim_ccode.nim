@@ -0,0 +1,21 @@
+discard """
+  ccodecheck: "\\i !@'raiseIndexError'"
+  output: '''
+15 15 4
+'''
+"""
+
+# every index check in this module is proven redundant, the generated C code
+# has none left
+
+proc sum(s: seq[int]): int =
+  for i in 0..<s.len: result += s[i]
+
+proc sumDown(a: array[5, int]): int =
+  for i in countdown(4, 0): result += a[i]
+
+proc guarded(s: openArray[int]; k: int): int =
+  if k >= 0 and k < s.len: result = s[k]
+
+echo sum(@[1, 2, 3, 4, 5]), " ", sumDown([1, 2, 3, 4, 5]), " ",
+  guarded([1, 2, 3, 4, 5], 3) + guarded([1, 2], 7)
@@ -0,0 +1,45 @@
+discard """
+  output: '''
+int int
+float int
+var lent
+inner int
+int int
+B
+A A
+'''
+"""
+
+# the overload memo must not return a stale winner when the candidates,
+# the argument types or the argument's l-valueness change
+
+proc f(x: int): string = "int"
+proc f(x: float): string = "float"
+
+let i = 1
+let x = 2.0
+echo f(i), " ", f(i)
+echo f(x), " ", f(i)
+
+proc g(x: var int): string = "var"
+proc g(x: int): string = "lent"
+
+var v = 3
+echo g(v), " ", g(i)
+
+block:
+  proc f(x: int): string = "inner int"
+  echo f(i)
+echo f(i), " int"
+
+type
+  A = object of RootObj
+  B = object of A
+
+proc h(x: A): string = "A"
+proc h(x: B): string = "B"
+
+let b = B()
+let a = A()
+echo h(b)
+echo h(a), " ", h(A(b))
@@ -0,0 +1,52 @@
+discard """
+  joinable: false
+"""
+
+# repeated calls hit the overload memo, a call after a new overload came
+# into scope misses it; the CacheStats hint of small programs that only
+# differ in these calls shows it
+
+import stdtest/specialpaths
+import std/[osproc, strformat, strutils, os]
+
+const
+  nim = getCurrentCompilerExe()
+  dir = buildDir / "toverloadmemo_stats"
+  file = dir / "moverloadmemo.nim"
+
+proc stats(calls: string): tuple[hits, misses: int] =
+  writeFile(file, """
+proc f(x: int): string = "int"
+proc f(x: float): string = "float"
+
+let i = 1
+""" & calls)
+  let (msg, code) = execCmdEx(fmt"{nim} check --hints:off --hint:CacheStats:on {file}")
+  doAssert code == 0, msg
+  for line in msg.splitLines:
+    const prefix = "overload resolution memo: "
+    let k = line.find(prefix)
+    if k >= 0:
+      let parts = line.substr(k + prefix.len).split(' ')
+      return (parseInt(parts[0]), parseInt(parts[2]))
+  doAssert false, msg
+
+createDir(dir)
+
+let base = stats("discard f(i)\n")
+
+block: # the same call again: hits
+  let s = stats(repeat("discard f(i)\n", 11))
+  doAssert s.hits - base.hits == 10, $(s, base)
+  doAssert s.misses == base.misses, $(s, base)
+
+block: # a new overload in scope: the memo is not used
+  let s = stats("""
+discard f(i)
+proc f(x: int8): string = "int8"
+discard f(i)
+""")
+  doAssert s.hits == base.hits, $(s, base)
+  doAssert s.misses - base.misses == 1, $(s, base)
+
+removeDir(dir)
@@ -0,0 +1,143 @@
+discard """
+  targets: "c cpp"
+  matrix: "--mm:orc --threads:on; --mm:arc --threads:on; --mm:orc --threads:off; --mm:orc -d:useMalloc; --mm:refc"
+"""
+
+import std/[arenas, strutils, tables]
+import std/assertions
+
+type
+  Node = ref object
+    left, right: Node
+    value: int
+
+proc build(depth: int): Node =
+  result = Node(value: depth)
+  if depth > 0:
+    result.left = build(depth - 1)
+    result.right = build(depth - 1)
+
+proc sum(n: Node): int =
+  if n == nil: 0 else: n.value + sum(n.left) + sum(n.right)
+
+proc handle(request: string): string =
+  var headers = initTable[string, string]()
+  for line in request.splitLines:
+    let parts = line.split(": ", 1)
+    if parts.len == 2: headers[parts[0].toLowerAscii] = parts[1]
+  result = headers.getOrDefault("host", "?")
+
+var escaped: seq[string] = @[]
+
+proc main =
+  block: # refs, seqs and strings
+    var total = 0
+    withArena:
+      let tree = build(10)
+      total = sum(tree)
+      var s = ""
+      for i in 0..<1000: s.add $i
+      var xs: seq[int] = @[]
+      for i in 0..<10_000: xs.add i
+      doAssert s.len == 2890 and xs[9999] == 9999
+    doAssert total == 2036
+
+  block: # results go to memory allocated before the arena
+    var host = newStringOfCap(64)
+    withArena:
+      let h = handle("GET / HTTP/1.1\nHost: nim-lang.org\nAccept: */*")
+      host.add h
+    doAssert host == "nim-lang.org"
+
+  block: # nested arenas
+    withArena:
+      var a = @[1, 2, 3]
+      withArena:
+        var b = a
+        b.add 4
+        doAssert b.len == 4
+      a.add 5
+      doAssert a == @[1, 2, 3, 5]
+
+  block: # escaped allocations stay valid
+    var a = openArena()
+    for i in 0..<100: escaped.add "escaped " & $i
+    let n = close(a)
+    when defined(gcDestructors) and not defined(useMalloc):
+      doAssert n > 0
+    else:
+      doAssert n == 0
+    doAssert escaped[42] == "escaped 42"
+    escaped.setLen 0
+    escaped = @[]
+
+  when defined(gcDestructors) and not defined(useMalloc):
+    block: # and are reported
+      doAssertRaises(AssertionDefect):
+        withArena:
+          escaped.add "escaped"
+      doAssert escaped == @["escaped"]
+
+when compileOption("threads"):
+  import std/typedthreads
+
+  var handoff: seq[string] = @[]
+
+  proc release() {.thread.} =
+    {.cast(gcsafe).}:
+      handoff = @[]
+
+  proc freeElsewhere() =
+    var t: Thread[void]
+    createThread(t, release)
+    joinThread(t)
+
+  var
+    keptRef: Node
+    keptStr: string
+    keptSeq: seq[int]
+
+  proc threads =
+    block: # with threads refs, strings and seqs still come from the arena
+      var a = openArena()
+      keptRef = Node(value: 1)
+      keptStr = newString(10)
+      keptSeq = newSeq[int](10)
+      let n = close(a)
+      when defined(gcDestructors) and not defined(useMalloc):
+        doAssert n == 3, $n
+      keptRef = nil
+      keptStr = ""
+      keptSeq = @[]
+
+    block: # freed by another thread after the arena is closed
+      var a = openArena()
+      for i in 0..<1000: handoff.add "handed over " & $i
+      let n = close(a)
+      when defined(gcDestructors) and not defined(useMalloc):
+        doAssert n > 0
+      freeElsewhere()
+      doAssert handoff.len == 0
+
+    block: # and while it is still open
+      var a = openArena()
+      for i in 0..<1000: handoff.add "handed over " & $i
+      freeElsewhere()
+      doAssert close(a) == 0
+
+    block: # shared memory never comes from an arena
+      var p: pointer = nil
+      withArena:
+        p = allocShared(64)
+      var t: Thread[pointer]
+      createThread(t, proc (p: pointer) {.thread.} = deallocShared(p), p)
+      joinThread(t)
+
+    # the heap is intact
+    var xs: seq[string] = @[]
+    for i in 0..<10_000: xs.add $i
+    doAssert xs[9999] == "9999"
+
+  threads()
+
+main()
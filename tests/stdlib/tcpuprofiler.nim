@@ -0,0 +1,55 @@
+discard """
+  targets: "c"
+  matrix: "--framePointers:on; --framePointers:on -d:release; --framePointers:on --debugger:native -d:withLines"
+  disabled: "win"
+  output: "ok"
+"""
+
+import std/[cpuprofiler, os, strutils]
+import std/assertions
+
+proc spin(n: int): int {.noinline.} =
+  result = 0
+  for i in 0..<n:
+    result = result xor (i * 7919) shr 3
+
+proc busy(): int {.noinline.} =
+  result = 0
+  for round in 0..<200:
+    result += spin(1_000_000)
+
+proc main =
+  startCpuProfile(1000)
+  doAssert busy() != 0
+  stopCpuProfile()
+
+  let folded = getTempDir() / "tcpuprofiler.folded"
+  doAssert writeCollapsedStacks(folded)
+  var samples = 0
+  var inSpin = 0
+  for line in lines(folded):
+    let count = parseInt(line.rsplit(' ', 1)[1])
+    samples += count
+    if "tcpuprofiler.spin" in line: inSpin += count
+  doAssert samples > 0
+  doAssert inSpin * 2 > samples, $inSpin & " of " & $samples
+
+  when defined(linux) and defined(withLines):
+    # `busy` calls `spin` on line 19
+    doAssert writeCollapsedStacks(folded, lineNumbers = true)
+    var withLine = false
+    for line in lines(folded):
+      if "tcpuprofiler.busy:19;tcpuprofiler.spin:" in line: withLine = true
+    doAssert withLine
+
+  let pprof = getTempDir() / "tcpuprofiler.pb"
+  doAssert writeCpuProfile(pprof)
+  let data = readFile(pprof)
+  doAssert "nanoseconds" in data
+  when defined(linux):
+    doAssert extractFilename(getAppFilename()) in data
+  removeFile(folded)
+  removeFile(pprof)
+  echo "ok"
+
+main()
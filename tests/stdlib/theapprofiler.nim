@@ -0,0 +1,37 @@
+discard """
+  targets: "c"
+  matrix: "--mm:orc -d:nimHeapProfiler; --mm:arc -d:nimHeapProfiler -d:useMalloc"
+  output: "ok"
+"""
+
+import std/[heapprofiler, os, strutils]
+import std/assertions
+
+type
+  ProfiledNode = ref object
+    next: ProfiledNode
+    payload: array[8, int]
+
+proc build(n: int): ProfiledNode =
+  for i in 0..<n: result = ProfiledNode(next: result)
+
+proc main =
+  setHeapProfileRate(64)
+  let file = getTempDir() / "theapprofiler.pb"
+  var list = build(10_000)
+  var strs: seq[string] = @[]
+  for i in 0..<1000: strs.add repeat('x', 100)
+  doAssert dumpHeapProfile(file)
+  let live = readFile(file)
+  doAssert "inuse_space" in live
+  doAssert "ProfiledNode" in live
+  doAssert "string" in live
+
+  list = nil
+  strs = @[]
+  doAssert dumpHeapProfile(file)
+  doAssert "ProfiledNode" notin readFile(file)
+  removeFile(file)
+  echo "ok"
+
+main()
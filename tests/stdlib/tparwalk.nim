@@ -0,0 +1,53 @@
+discard """
+  matrix: "--mm:refc; --mm:orc"
+  joinable: false
+"""
+
+import std/[os, parwalk, algorithm, sequtils, strutils]
+import std/assertions
+from stdtest/specialpaths import buildDir
+
+block:
+  const root = buildDir / "D20240301T120000_parwalk"
+  removeDir(root)
+  for i in 0..<20:
+    let d = root / ("d" & $i) / "sub"
+    createDir(d)
+    writeFile(root / ("d" & $i) / "a.txt", "")
+    writeFile(d / "b.txt", "")
+  writeFile(root / "top.txt", "")
+  defer: removeDir(root)
+
+  for relative in [false, true]:
+    let expected = toSeq(walkDirRec(root, relative = relative)).sorted
+    for threads in [1, 4]:
+      let got = toSeq(walkDirRecParallel(root, relative = relative,
+                                         threads = threads)).sorted
+      doAssert got == expected
+
+  let dirs = toSeq(walkDirRecParallel(root, yieldFilter = {pcDir},
+                                      relative = true)).sorted
+  doAssert dirs == toSeq(walkDirRec(root, yieldFilter = {pcDir},
+                                    relative = true)).sorted
+  doAssert dirs.len == 40
+
+  # `descend` is asked on the iterating thread before a directory is listed
+  var asked: seq[string]
+  let pruned = toSeq(walkDirRecParallel(root, {pcFile, pcDir}, relative = true,
+                                        threads = 4, descend = proc (d: string): bool =
+                                          asked.add d
+                                          d.lastPathPart != "sub")).sorted
+  doAssert asked.sorted == dirs
+  # the skipped directories are still yielded, but not their files
+  doAssert pruned.len == 61
+  doAssert not pruned.anyIt(it.endsWith("b.txt"))
+
+  # breaking out early stops the workers
+  var n = 0
+  for p in walkDirRecParallel(root, bufferedEntries = 2):
+    inc n
+    if n == 3: break
+  doAssert n == 3
+
+  doAssertRaises(OSError):
+    for p in walkDirRecParallel(root / "nonexistent", checkDir = true): discard
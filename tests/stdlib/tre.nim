@@ -119,4 +119,23 @@ proc testAll() =
       accum.add(word)
     doAssert(accum == @["this", " ", "is", " ", "an", " ", "example"])
 
+  block: # captures as bounds
+    var bounds: array[3, tuple[first, last: int]]
+    doAssert match("k=v", re"(x)?(\w)=(\w)", bounds)
+    doAssert bounds[0] == (-1, 0) and bounds[1] == (0, 0) and bounds[2] == (2, 2)
+    doAssert matchLen("ab=cd;", re"(\w+)=(\w+)", bounds) == 5
+    doAssert bounds[0] == (0, 1) and bounds[1] == (3, 4)
+    doAssert find("  ab=cd", re"(\w+)=", bounds) == 2
+    doAssert bounds[0] == (2, 3)
+    doAssert find("abc", re"(x)", bounds) == -1
+    doAssert not match("abc", re"(x)", bounds)
+
+  block: # cachedRe
+    let a = cachedRe"\d+"
+    doAssert a == cachedRe"\d+"
+    doAssert a != cachedRe("\\d+", {reIgnoreCase, reStudy})
+    for i in 0..200:
+      doAssert match($i, cachedRe("^" & $i & "$"))
+    doAssert "123".match(cachedRe"\d+")
+
 testAll()
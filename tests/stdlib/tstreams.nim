@@ -17,6 +17,8 @@ GROOT
 
 
 import std/[syncio, streams, assertions]
+from std/strutils import splitLines
+from std/os import removeFile
 
 
 block tstreams:
@@ -105,3 +107,53 @@ template main =
 
 static: main()
 main()
+
+block: # BufferedStream, readInto, peekSlice
+  var data = ""
+  for i in 0..<1000: data.add $i & (if i mod 3 == 0: "\r\n" else: "\n")
+  let expected = data.splitLines()
+  var bs = newBufferedStream(newStringStream(data), bufSize = 7)
+  var lines: seq[string] = @[]
+  var line = ""
+  while bs.readLine(line): lines.add line
+  doAssert lines == expected[0..^2]
+  doAssert bs.atEnd
+  bs.setPosition(2)
+  doAssert bs.getPosition == 2
+  doAssert bs.readChar() == '\n'
+  doAssert bs.peekChar() == '1'
+  doAssert bs.readStr(20) == data[3..22]
+  var buf: array[5, byte]
+  doAssert bs.readInto(buf) == 5
+  for i, b in buf: doAssert char(b) == data[23 + i]
+  let v = bs.peekSlice(30) # larger than the buffer
+  doAssert v.len == 30
+  var peeked = newString(v.len)
+  for i, b in toOpenArray(v): peeked[i] = char(b)
+  doAssert peeked == data[28..57]
+  bs.skip(30)
+  doAssert bs.getPosition == 58
+  doAssert bs.readAll() == data[58..^1]
+  bs.close()
+
+  var ss = newStringStream("\x01\x02\x03\x04xyz")
+  doAssert ss.peekSlice(100).len == 7
+  doAssert ss.readInt8() == 1
+  doAssert ss.peekSlice(2).data[0] == 2
+  ss.setPosition(7)
+  doAssert ss.peekSlice(2).len == 0
+  doAssertRaises(IOError):
+    discard newFileStream(stdin).peekSlice(1)
+
+  let filename = "tstreams_buffered.txt"
+  writeFile(filename, data)
+  var fs = newBufferedStream(openFileStream(filename), bufSize = 64)
+  var n = 0
+  for line in fs.lines:
+    doAssert line == expected[n]
+    inc n
+  doAssert n == expected.len - 1
+  fs.setPosition(0)
+  doAssert fs.readStr(2) == data[0..1]
+  fs.close()
+  removeFile(filename)
@@ -905,6 +905,29 @@ bar
     doAssert "abc \0 def".find("def") == 6
     doAssert "abc \0 def".find('d') == 6
 
+  block: # word-at-a-time paths agree with the per-char definitions
+    var all = ""
+    for c in low(char)..high(char): all.add c
+    for i in 0..<all.len:
+      let s = all[i..^1] & all[0..<i]
+      var lower, upper = ""
+      for c in s:
+        lower.add toLowerAscii(c)
+        upper.add toUpperAscii(c)
+      doAssert toLowerAscii(s) == lower
+      doAssert toUpperAscii(s) == upper
+    doAssert count(all & all & "aaaaaaaaa", 'a') == 11
+    doAssert count("\0\0\0\0\0\0\0\0\1\0", '\0') == 9
+    doAssert count("\x80\x80\x80\x80\x80\x80\x80\x80\x81", '\x80') == 8
+    doAssert "a,bb,,ccc,dddd,eeeee,".split(',') == @["a", "bb", "", "ccc", "dddd", "eeeee", ""]
+    doAssert "a<>bb<><>ccc<>dddd<".split("<>") == @["a", "bb", "", "ccc", "dddd<"]
+    doAssert "a<>bb".split("<>", maxsplit = 0) == @["a<>bb"]
+    doAssert "abcabc".split("") == @["abcabc"]
+    doAssert "foo bar foo".find("foo", 1, 9) == -1
+    doAssert "foo bar foo".find("foo", 1, 10) == 8
+    doAssert "foo bar foo".find("bar", 0, 6) == 4
+    doAssert "foo bar foo".replace("foo", "x") == "x bar x"
+
 
 static: main()
 main()
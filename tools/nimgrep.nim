@@ -9,6 +9,7 @@
 
 import
   os, strutils, parseopt, pegs, re, terminal, osproc, tables, algorithm, times
+import std/parwalk
 
 const
   Version = "2.0.0"
@@ -150,6 +151,7 @@ var
   gVar = (matches: 0, errors: 0, reallyReplace: true)
     # gVar - variables that can change during search/replace
   nWorkers = 0  # run in single thread by default
+  walkThreads = 0  # list directories in the current thread by default
   searchRequestsChan: Channel[Trequest]
   resultsChan: Channel[Tresult]
   colorTheme: string = "simple"
@@ -1025,6 +1027,33 @@ iterator walkDirBasic(dir: string, walkOptC: WalkOptComp[Pattern]): string
     for (_, file) in timeFiles:
       yield file
 
+proc isRightDirForFiles(dir: string, walkOptC: WalkOptComp[Pattern],
+                        cache: var Table[string, bool]): bool =
+  ## `walkDirBasic` decides this once per directory; the parallel walker only
+  ## reports files, so remember the answer for their directories.
+  result = cache.getOrDefault(dir, true)
+  if dir notin cache:
+    result = dir.isRightDirectory(walkOptC)
+    cache[dir] = result
+
+iterator walkDirParallel(dir: string, walkOptC: WalkOptComp[Pattern]): string
+         {.closure.} =
+  ## Same files as `walkDirBasic`, but the directories are listed by
+  ## `walkThreads` threads and the files come in no particular order.
+  var follow: set[PathComponent] = {}
+  if optRecursive in options:
+    follow.incl pcDir
+    if optFollow in options: follow.incl pcLinkToDir
+  let kinds = if optFollow in options: {pcFile, pcLinkToFile} else: {pcFile}
+  var dirCache = initTable[string, bool]()
+  for path in walkDirRecParallel(dir, kinds, follow, skipSpecial = true,
+                                 threads = walkThreads,
+                                 descend = proc (d: string): bool =
+                                   d.descendToDirectory(walkOptC)):
+    if path.hasRightPath(walkOptC) and
+        path.parentDir.isRightDirForFiles(walkOptC, dirCache):
+      yield path
+
 iterator walkRec(paths: seq[string]): tuple[error: string, filename: string]
          {.closure.} =
   declareCompiledPatterns(walkOptC, WalkOptComp):
@@ -1035,7 +1064,10 @@ iterator walkRec(paths: seq[string]): tuple[error: string, filename: string]
     walkOptC.dirPath.add     walkOpt.dirPath.compileArray()
     walkOptC.notDirPath.add  walkOpt.notDirPath.compileArray()
     for path in paths:
-      if dirExists(path):
+      if dirExists(path) and walkThreads > 0 and not sortTime:
+        for p in walkDirParallel(path, walkOptC):
+          yield ("", p)
+      elif dirExists(path):
         for p in walkDirBasic(path, walkOptC):
           yield ("", p)
       else:
@@ -1288,6 +1320,11 @@ for kind, key, val in getopt():
         nWorkers = countProcessors()
       else:
         nWorkers = parseNonNegative(val, key)
+    of "walkthreads":
+      if val == "":
+        walkThreads = countProcessors()
+      else:
+        walkThreads = parseNonNegative(val, key)
     of "extensions", "ex", "ext": walkOpt.extensions.add val.split('|')
     of "nextensions", "notextensions", "nex", "notex",
        "noext", "no-ext":  # 2 deprecated options